@@ -982,6 +982,8 @@ public:
 	fixed_t			pitch;
 	angle_t			roll;	// This was fixed_t before, which is probably wrong
 	FBlockNode		*BlockNode;			// links in blocks (if needed)
+	int				CompactBlock;		// in the compact blockmap: block+1, -(multi-block record+1) or 0 if not linked
+	int				CompactSlot;		// slot in the compact block for actors that are in a single block
 	struct sector_t	*Sector;
 	subsector_t *		subsector;
 	fixed_t			floorz, ceilingz;	// closest together of contacted secs
@@ -121,6 +121,9 @@ static int	SavedConBottom;
 static bool g_IsCapturing = false;
 static FString g_CaptureBuffer;
 
+// Output of the current thread goes here if it is not NULL.
+static thread_local FString *ThreadCaptureBuffer;
+
 // [AK] A bunch of global variables that were originally defined in scoreboard.cpp but
 // are now used in other files which also deal with drawing HUD elements.
 // Is text scaling enabled?
@@ -1041,6 +1044,12 @@ int PrintString (int printlevel, const char *outline)
 		return 0;
 	}
 
+	if (ThreadCaptureBuffer != NULL)
+	{
+		*ThreadCaptureBuffer += outline;
+		return 0;
+	}
+
 	// [TP] Possibly capture it instead
 	if ( C_IsCapturing() )
 	{
@@ -2665,6 +2674,26 @@ bool C_IsCapturing()
 	return g_IsCapturing;
 }
 
+//==========================================================================
+//
+// C_StartThreadCapture
+//
+// Unlike C_StartCapture, this only affects the calling thread and can be
+// used on worker threads. The captured text should be printed on the main
+// thread afterwards.
+//
+//==========================================================================
+
+void C_StartThreadCapture(FString *buffer)
+{
+	ThreadCaptureBuffer = buffer;
+}
+
+void C_EndThreadCapture()
+{
+	ThreadCaptureBuffer = NULL;
+}
+
 //
 // [AK] Gets the minimum message level.
 //
@@ -101,6 +101,11 @@ void C_StartCapture();
 const char* C_EndCapture();
 bool C_IsCapturing();
 
+// Collects the calling thread's output in buffer instead of printing it.
+// This is what lets worker threads report problems.
+void C_StartThreadCapture(FString *buffer);
+void C_EndThreadCapture();
+
 // [AK]
 unsigned int C_GetMessageLevel();
 void C_UpdateVirtualScreen();
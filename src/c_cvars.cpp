@@ -88,6 +88,13 @@ bool FBaseCVar::m_UseCallback = false;
 
 FBaseCVar *CVars = NULL;
 
+// All cvars are also kept in a hash table so that FindCVar does not have to
+// walk the whole list. Like the list, this is filled during static
+// initialization, so it must not need a constructor.
+enum { CVAR_HASH_SIZE = 2048 };		// must be a power of 2
+static FBaseCVar *CVarHash[CVAR_HASH_SIZE];
+unsigned int CVarGeneration;
+
 int cvar_defflags;
 
 // [AK] Prevents CVars changed by ConsoleCommand from being written into the user's config file.
@@ -125,6 +132,7 @@ FBaseCVar::FBaseCVar (const char *var_name, DWORD flags, void (*callback)(FBaseC
 		Name = copystring (var_name);
 		m_Next = CVars;
 		CVars = this;
+		LinkHash ();
 	}
 
 	if (var)
@@ -163,11 +171,37 @@ FBaseCVar::~FBaseCVar ()
 			else
 				CVars = m_Next;
 		}
+		UnlinkHash ();
 		C_RemoveTabCommand(Name);
 		delete[] Name;
 	}
 }
 
+void FBaseCVar::LinkHash ()
+{
+	FBaseCVar **bucket = &CVarHash[MakeKey (Name) & (CVAR_HASH_SIZE - 1)];
+
+	m_HashNext = *bucket;
+	*bucket = this;
+	CVarGeneration++;
+}
+
+void FBaseCVar::UnlinkHash ()
+{
+	FBaseCVar **probe = &CVarHash[MakeKey (Name) & (CVAR_HASH_SIZE - 1)];
+
+	while (*probe != NULL)
+	{
+		if (*probe == this)
+		{
+			*probe = m_HashNext;
+			break;
+		}
+		probe = &(*probe)->m_HashNext;
+	}
+	CVarGeneration++;
+}
+
 void FBaseCVar::ForceSet (UCVarValue value, ECVarType type, bool nouserinfosend)
 {
 	DoSet (value, type);
@@ -1612,22 +1646,31 @@ void C_ForgetCVars (void)
 FBaseCVar *FindCVar (const char *var_name, FBaseCVar **prev)
 {
 	FBaseCVar *var;
-	FBaseCVar *dummy;
 
 	if (var_name == NULL)
 		return NULL;
 
-	if (prev == NULL)
-		prev = &dummy;
+	if (prev != NULL)
+	{
+		// The caller wants to unlink it, so this needs the list.
+		var = CVars;
+		*prev = NULL;
+		while (var)
+		{
+			if (stricmp (var->GetName (), var_name) == 0)
+				break;
+			*prev = var;
+			var = var->m_Next;
+		}
+		return var;
+	}
 
-	var = CVars;
-	*prev = NULL;
+	var = CVarHash[MakeKey (var_name) & (CVAR_HASH_SIZE - 1)];
 	while (var)
 	{
 		if (stricmp (var->GetName (), var_name) == 0)
 			break;
-		*prev = var;
-		var = var->m_Next;
+		var = var->m_HashNext;
 	}
 	return var;
 }
@@ -1639,7 +1682,7 @@ FBaseCVar *FindCVarSub (const char *var_name, int namelen)
 	if (var_name == NULL)
 		return NULL;
 
-	var = CVars;
+	var = CVarHash[MakeKey (var_name, namelen) & (CVAR_HASH_SIZE - 1)];
 	while (var)
 	{
 		const char *probename = var->GetName ();
@@ -1649,7 +1692,7 @@ FBaseCVar *FindCVarSub (const char *var_name, int namelen)
 		{
 			break;
 		}
-		var = var->m_Next;
+		var = var->m_HashNext;
 	}
 	return var;
 }
@@ -178,8 +178,12 @@ private:
 	FBaseCVar (const FBaseCVar &var);
 	FBaseCVar (const char *name, uint32 flags);
 
+	void LinkHash ();
+	void UnlinkHash ();
+
 	void (*m_Callback)(FBaseCVar &);
 	FBaseCVar *m_Next;
+	FBaseCVar *m_HashNext;
 
 	static bool m_UseCallback;
 	static bool m_DoNoSet;
@@ -213,6 +217,10 @@ void C_BackupCVars (void);
 
 // Finds a named cvar
 FBaseCVar *FindCVar (const char *var_name, FBaseCVar **prev);
+
+// Changes whenever a cvar is created or destroyed, so that anything that
+// caches the results of FindCVar knows when to look again.
+extern unsigned int CVarGeneration;
 FBaseCVar *FindCVarSub (const char *var_name, int namelen);
 
 // Create a new cvar with the specified name and type
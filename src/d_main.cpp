@@ -63,6 +63,7 @@
 #include "gstrings.h"
 #include "w_wad.h"
 #include "s_sound.h"
+#include "i_music.h"
 #include "v_video.h"
 #include "intermission/intermission.h"
 #include "f_wipe.h"
@@ -125,6 +126,7 @@
 #include "za_database.h"
 #include "st_hud.h"
 #include "p_acs.h"
+#include "r_renderbench.h"
 
 #include "st_start.h"
 #include "templates.h"
@@ -863,6 +865,13 @@ void D_Display ()
 	if ( NETWORK_GetState( ) == NETSTATE_SERVER )
 		return;
 
+	// The render benchmark draws into its own canvas instead.
+	if ( RENDERBENCH_IsActive( ))
+	{
+		RENDERBENCH_RenderFrame( );
+		return;
+	}
+
 	if (nodrawers || screen == NULL)
 		return; 				// for comparative timing / profiling
 	
@@ -3152,6 +3161,14 @@ void D_DoomMain (void)
 					throw CNoRunExit();
 				}
 
+				// Render a song through all music backends and quit.
+				v = Args->CheckValue ("-benchmusic");
+				if (v != NULL)
+				{
+					I_BenchMusic (v, Args->CheckValue ("-benchmusicwave"));
+					exit (0);
+				}
+
 				V_Init2();
 				UpdateJoystickMenu(NULL);
 
@@ -46,9 +46,19 @@
 // [BB] New #includes.
 #include "cl_demo.h"
 #include "doomstat.h"
+#include "c_cvars.h"
+#include "workerpool.h"
+
+// Tick lists of independent thinkers, like sector lights and scrollers, on
+// the worker threads. The result is the same as ticking them one by one.
+CVAR (Bool, parallelthinkers, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+// Smaller lists are not worth the overhead of waking up the workers.
+enum { MIN_PARALLEL_THINKERS = 256, PARALLEL_THINKER_CHUNK = 64 };
 
 
 static cycle_t ThinkCycles;
+static int ParallelThinkCount;
 
 IMPLEMENT_CLASS (DThinker)
 
@@ -410,13 +420,17 @@ void DThinker::RunThinkers ()
 	int i, count;
 
 	ThinkCycles.Reset();
+	ParallelThinkCount = 0;
 
 	ThinkCycles.Clock();
 
 	// Tick every thinker left from last time
 	for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 	{
-		TickThinkers (&Thinkers[i], NULL);
+		if (!parallelthinkers || !TickThinkersParallel (&Thinkers[i]))
+		{
+			TickThinkers (&Thinkers[i], NULL);
+		}
 	}
 
 	// Keep ticking the fresh thinkers until there are no new ones.
@@ -479,10 +493,124 @@ int DThinker::TickThinkers (FThinkerList *list, FThinkerList *dest)
 	return count;
 }
 
+//==========================================================================
+//
+// DThinker :: TickThinkersParallel
+//
+// Ticks a list whose thinkers all report a parallel tick key. Thinkers that
+// share their key with another one or can't tick in parallel this time are
+// ticked first in list order. The rest is split among the worker threads.
+// Since none of them touch what the others touch, the order doesn't matter.
+//
+//==========================================================================
+
+struct FParallelTickEntry
+{
+	const void *Key;
+	unsigned int Index;
+};
+
+static int SortParallelTickEntries (const void *a, const void *b)
+{
+	const FParallelTickEntry *ea = (const FParallelTickEntry *)a;
+	const FParallelTickEntry *eb = (const FParallelTickEntry *)b;
+
+	if (ea->Key != eb->Key)
+	{
+		return ea->Key < eb->Key ? -1 : 1;
+	}
+	return ea->Index < eb->Index ? -1 : ea->Index > eb->Index;
+}
+
+bool DThinker::TickThinkersParallel (FThinkerList *list)
+{
+	static TArray<DThinker *> thinkers;
+	static TArray<FParallelTickEntry> entries;
+	static TArray<bool> shared;
+	static TArray<DThinker *> batch;
+	DThinker *node = list->GetHead();
+
+	if (node == NULL)
+	{
+		return false;
+	}
+
+	thinkers.Clear();
+	entries.Clear();
+	for (; node != list->Sentinel; node = node->NextThinker)
+	{
+		if (node->ObjectFlags & OF_EuthanizeMe)
+		{
+			continue;
+		}
+		const void *key = node->GetParallelTickKey();
+		if (key == NULL || (node->ObjectFlags & OF_JustSpawned))
+		{
+			return false;
+		}
+		FParallelTickEntry entry = { key, thinkers.Push(node) };
+		entries.Push(entry);
+	}
+	if (thinkers.Size() < MIN_PARALLEL_THINKERS)
+	{
+		return false;
+	}
+
+	// Find the thinkers that share their key with another one.
+	qsort (&entries[0], entries.Size(), sizeof(entries[0]), SortParallelTickEntries);
+	shared.Resize(thinkers.Size());
+	for (unsigned int i = 0; i < entries.Size(); ++i)
+	{
+		shared[entries[i].Index] = (i > 0 && entries[i-1].Key == entries[i].Key) ||
+			(i + 1 < entries.Size() && entries[i+1].Key == entries[i].Key);
+	}
+
+	// GC::CheckGC is only called once everything has ticked, so a thinker
+	// that destroys itself here can't be collected while it is still in
+	// one of the arrays.
+	batch.Clear();
+	for (unsigned int i = 0; i < thinkers.Size(); ++i)
+	{
+		node = thinkers[i];
+		if (!shared[i] && node->CanTickInParallel())
+		{
+			batch.Push(node);
+		}
+		else if (!(node->ObjectFlags & OF_EuthanizeMe))
+		{
+			node->Tick();
+		}
+	}
+
+	const unsigned int count = batch.Size();
+	WorkerPool.ParallelFor ((count + PARALLEL_THINKER_CHUNK - 1) / PARALLEL_THINKER_CHUNK, [count](unsigned int chunk)
+	{
+		const unsigned int end = MIN<unsigned int>(count, (chunk + 1) * PARALLEL_THINKER_CHUNK);
+		for (unsigned int i = chunk * PARALLEL_THINKER_CHUNK; i < end; ++i)
+		{
+			batch[i]->Tick();
+		}
+	});
+	ParallelThinkCount += count;
+
+	GC::CheckGC();
+	return true;
+}
+
 void DThinker::Tick ()
 {
 }
 
+const void *DThinker::GetParallelTickKey () const
+{
+	return NULL;
+}
+
+bool DThinker::CanTickInParallel () const
+{
+	return false;
+}
+
 size_t DThinker::PropagateMark()
 {
 	assert(NextThinker != NULL && !(NextThinker->ObjectFlags & OF_EuthanizeMe));
@@ -584,5 +712,9 @@ ADD_STAT (think)
 {
 	FString out;
 	out.Format ("Think time = %04.1f ms", ThinkCycles.TimeMS());
+	if (parallelthinkers)
+	{
+		out.AppendFormat (", %d ticked in parallel", ParallelThinkCount);
+	}
 	return out;
 }
@@ -69,6 +69,14 @@ public:
 	virtual void Tick ();
 	virtual void PostBeginPlay ();	// Called just before the first tick
 	size_t PropagateMark();
+
+	// Thinkers that return a key here only change themselves and the object
+	// the key stands for when they tick. Thinkers of the same list with
+	// different keys may then be ticked by several threads at once.
+	virtual const void *GetParallelTickKey () const;
+	// Returns false if the next Tick() has to happen on the main thread,
+	// e.g. because it uses an RNG or destroys the thinker.
+	virtual bool CanTickInParallel () const;
 	
 	void ChangeStatNum (int statnum);
 
@@ -87,6 +95,7 @@ private:
 	static void DestroyThinkersInList (FThinkerList &list);
 	static void DestroyMostThinkersInList (FThinkerList &list, int stat);
 	static int TickThinkers (FThinkerList *list, FThinkerList *dest);	// Returns: # of thinkers ticked
+	static bool TickThinkersParallel (FThinkerList *list);	// Returns: false if the list must be ticked normally
 	static void SaveList(FArchive &arc, DThinker *node);
 	void Remove();
 
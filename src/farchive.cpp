@@ -56,6 +56,7 @@
 #include "d_player.h"
 #include "m_misc.h"
 #include "dobject.h"
+#include "workerpool.h"
 
 // These are special tokens found in the data stream of an archive.
 // Whenever a new object is encountered, it gets created using new and
@@ -133,6 +134,155 @@ static inline void SWAP_FLOAT(float &x)
 // I assume the description in zlib.h is accurate.
 #define OUT_LEN(a)		((a) + (a) / 1000 + 12)
 
+// Files larger than this are compressed in blocks of this size while they
+// are being written.
+#define CBLOCK_SIZE		(256*1024)
+
+//==========================================================================
+//
+// FCompressStream
+//
+// A deflate stream that compresses one block at a time on a worker thread.
+// The next block is filled while the last one is being compressed. The
+// output is a single zlib stream, the same as compress() makes, so reading
+// is not affected. Every block is flushed to a byte boundary, so that
+// everything that was compressed successfully can be inflated again if
+// the file has to be stored uncompressed after all.
+//
+//==========================================================================
+
+struct FCompressStream
+{
+	z_stream Stream;
+	FWorkerGroup Group;
+	BYTE *Busy;			// block being compressed
+	unsigned int BusyLen;
+	BYTE *Out;
+	size_t OutSize;
+	uLong GoodIn;		// totals after the last block that was compressed fully
+	uLong GoodOut;
+	int Result;
+
+	FCompressStream (int level)
+	{
+		memset (&Stream, 0, sizeof(Stream));
+		Busy = NULL;
+		BusyLen = 0;
+		Out = NULL;
+		OutSize = 0;
+		GoodIn = GoodOut = 0;
+		Result = deflateInit (&Stream, level);
+	}
+
+	~FCompressStream ()
+	{
+		Group.Wait ();
+		deflateEnd (&Stream);
+		if (Busy != NULL) M_Free (Busy);
+		if (Out != NULL) free (Out);
+	}
+
+	// Hands a block to the compressor and returns a free one to continue
+	// writing into. Returns NULL and keeps nothing if the previous block
+	// could not be compressed.
+	BYTE *Submit (BYTE *block, unsigned int len, bool finish)
+	{
+		Group.Wait ();
+		if (Result != Z_OK)
+		{
+			return NULL;
+		}
+		BYTE *next = Busy != NULL ? Busy : (BYTE *)M_Malloc (CBLOCK_SIZE);
+		Busy = block;
+		BusyLen = len;
+		Group.Run ([=]() { Compress (block, len, finish); });
+		return next;
+	}
+
+	// Writes everything that was submitted back to dest uncompressed and
+	// returns its length, or -1 if that failed.
+	long Recover (BYTE *dest)
+	{
+		long len = 0;
+
+		Group.Wait ();
+		if (GoodOut > 0)
+		{
+			z_stream in;
+			memset (&in, 0, sizeof(in));
+			if (inflateInit (&in) != Z_OK)
+			{
+				return -1;
+			}
+			in.next_in = Out;
+			in.avail_in = uInt(GoodOut);
+			in.next_out = dest;
+			in.avail_out = uInt(GoodIn);
+			int r = inflate (&in, Z_SYNC_FLUSH);
+			len = in.total_out;
+			inflateEnd (&in);
+			if ((r != Z_OK && r != Z_STREAM_END) || uLong(len) != GoodIn)
+			{
+				return -1;
+			}
+		}
+		if (Result != Z_OK && Result != Z_STREAM_END && Busy != NULL)
+		{
+			// The block that failed is still here in full.
+			memcpy (dest + len, Busy, BusyLen);
+			len += BusyLen;
+		}
+		return len;
+	}
+
+	// Runs on a worker thread, so it must not use M_Malloc or report errors.
+	void Compress (BYTE *block, unsigned int len, bool finish)
+	{
+		if (Result != Z_OK)
+		{
+			return;
+		}
+		Stream.next_in = block;
+		Stream.avail_in = len;
+		for (;;)
+		{
+			if (Stream.avail_out == 0)
+			{
+				size_t newsize = OutSize != 0 ? OutSize * 2 : CBLOCK_SIZE;
+				BYTE *newout = (BYTE *)realloc (Out, newsize);
+				if (newout == NULL)
+				{
+					Result = Z_MEM_ERROR;
+					return;
+				}
+				Out = newout;
+				OutSize = newsize;
+				Stream.next_out = Out + Stream.total_out;
+				Stream.avail_out = uInt(OutSize - Stream.total_out);
+			}
+			int r = deflate (&Stream, finish ? Z_FINISH : Z_SYNC_FLUSH);
+			if (r == Z_STREAM_END)
+			{
+				Result = r;
+				GoodIn = Stream.total_in;
+				GoodOut = Stream.total_out;
+				return;
+			}
+			if (r != Z_OK && r != Z_BUF_ERROR)
+			{
+				Result = r;
+				return;
+			}
+			if (!finish && Stream.avail_in == 0 && Stream.avail_out != 0)
+			{
+				GoodIn = Stream.total_in;
+				GoodOut = Stream.total_out;
+				return;
+			}
+		}
+	}
+};
+
 void FCompressedFile::BeEmpty ()
 {
 	m_Pos = 0;
@@ -142,6 +292,9 @@ void FCompressedFile::BeEmpty ()
 	m_File = NULL;
 	m_NoCompress = false;
 	m_Mode = ENotOpen;
+	m_Level = Z_DEFAULT_COMPRESSION;
+	m_Stream = NULL;
+	m_BlockStart = 0;
 }
 
 static const char LZOSig[4] = { 'F', 'L', 'Z', 'O' };
@@ -234,6 +387,11 @@ void FCompressedFile::Close ()
 		fclose (m_File);
 		m_File = NULL;
 	}
+	if (m_Stream)
+	{
+		delete m_Stream;
+		m_Stream = NULL;
+	}
 	if (m_Buffer)
 	{
 		M_Free (m_Buffer);
@@ -260,6 +418,11 @@ FFile &FCompressedFile::Write (const void *mem, unsigned int len)
 {
 	if (m_Mode == EWriting)
 	{
+		if (m_Stream != NULL || (m_Pos + len > CBLOCK_SIZE && StartStream ()))
+		{
+			StreamWrite ((const BYTE *)mem, len);
+			return *this;
+		}
 		if (m_Pos + len > m_MaxBufferSize)
 		{
 			do
@@ -312,6 +475,11 @@ unsigned int FCompressedFile::Tell () const
 
 FFile &FCompressedFile::Seek (int pos, ESeekPos ofs)
 {
+	if (m_Stream != NULL)
+	{
+		// Streaming only works while everything is appended.
+		StopStream ();
+	}
 	if (ofs == ESeekRelative)
 		pos += m_Pos;
 	else if (ofs == ESeekEnd)
@@ -329,21 +497,177 @@ FFile &FCompressedFile::Seek (int pos, ESeekPos ofs)
 
 CVAR (Bool, nofilecompression, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
+//==========================================================================
+//
+// FCompressedFile :: StartStream
+//
+// Switches to compressing the file while it is written. This only works
+// as long as everything is appended to the end.
+//
+//==========================================================================
+
+bool FCompressedFile::StartStream ()
+{
+	// Once streaming has been given up on, the file is bigger than a block
+	// and is not streamed again.
+	if (nofilecompression || m_NoCompress || m_Pos != m_BufferSize || m_Pos > CBLOCK_SIZE)
+	{
+		return false;
+	}
+	m_Stream = new FCompressStream (m_Level);
+	if (m_Stream->Result != Z_OK)
+	{
+		delete m_Stream;
+		m_Stream = NULL;
+		return false;
+	}
+	if (m_MaxBufferSize < CBLOCK_SIZE)
+	{
+		m_Buffer = (BYTE *)M_Realloc (m_Buffer, CBLOCK_SIZE);
+		m_MaxBufferSize = CBLOCK_SIZE;
+	}
+	m_BlockStart = 0;
+	return true;
+}
+
+//==========================================================================
+//
+// FCompressedFile :: StreamWrite
+//
+//==========================================================================
+
+void FCompressedFile::StreamWrite (const BYTE *mem, unsigned int len)
+{
+	while (len > 0)
+	{
+		unsigned int fill = m_Pos - m_BlockStart;
+		unsigned int chunk = MIN<unsigned int> (len, CBLOCK_SIZE - fill);
+
+		memcpy (m_Buffer + fill, mem, chunk);
+		m_Pos += chunk;
+		mem += chunk;
+		len -= chunk;
+		if (fill + chunk == CBLOCK_SIZE)
+		{
+			BYTE *next = m_Stream->Submit (m_Buffer, CBLOCK_SIZE, false);
+			if (next == NULL)
+			{
+				m_BufferSize = m_Pos;
+				StopStream ();
+				Write (mem, len);
+				return;
+			}
+			m_Buffer = next;
+			m_BlockStart = m_Pos;
+		}
+	}
+	m_BufferSize = m_Pos;
+}
+
+//==========================================================================
+//
+// FCompressedFile :: StopStream
+//
+// Goes back to keeping the whole file uncompressed in m_Buffer. m_Buffer
+// holds the data from m_BlockStart on that was not submitted yet.
+//
+//==========================================================================
+
+void FCompressedFile::StopStream ()
+{
+	unsigned int fill = m_Pos - m_BlockStart;
+	BYTE *buffer = (BYTE *)M_Malloc (m_Pos);
+	long len = m_Stream->Recover (buffer);
+
+	if (len < 0 || unsigned(len) + fill != m_Pos)
+	{
+		M_Free (buffer);
+		I_Error ("Could not recover streamed cfile");
+	}
+	if (fill > 0)
+	{
+		memcpy (buffer + len, m_Buffer, fill);
+	}
+	if (m_Buffer != NULL)
+	{
+		M_Free (m_Buffer);
+	}
+	delete m_Stream;
+	m_Stream = NULL;
+	m_Buffer = buffer;
+	m_MaxBufferSize = m_BufferSize = m_Pos;
+	m_BlockStart = 0;
+}
+
+//==========================================================================
+//
+// FCompressedFile :: FinishStream
+//
+// Compresses the last block and leaves the file's data in m_Buffer, the
+// way Implode does. If the data could not be compressed, the stream is
+// undone and false is returned, so that Implode can handle the file like
+// one that was never streamed.
+//
+//==========================================================================
+
+bool FCompressedFile::FinishStream ()
+{
+	uLong len = m_BufferSize;
+	BYTE *next = m_Stream->Submit (m_Buffer, m_Pos - m_BlockStart, true);
+
+	if (next != NULL)
+	{
+		M_Free (next);
+		m_Buffer = NULL;
+		m_BlockStart = m_Pos;
+		m_Stream->Group.Wait ();
+	}
+
+	uLong outlen = m_Stream->Stream.total_out;
+	if (m_Stream->Result != Z_STREAM_END || outlen >= len)
+	{
+		StopStream ();
+		return false;
+	}
+	DPrintf ("cfile shrank from %lu to %lu bytes\n", len, outlen);
+
+	m_MaxBufferSize = m_BufferSize = outlen;
+	m_Buffer = (BYTE *)M_Malloc (m_BufferSize + 8);
+	m_Pos = 0;
+	m_BlockStart = 0;
+
+	DWORD *lens = (DWORD *)(m_Buffer);
+	lens[0] = BigLong((unsigned int)outlen);
+	lens[1] = BigLong((unsigned int)len);
+	memcpy (m_Buffer + 8, m_Stream->Out, outlen);
+
+	delete m_Stream;
+	m_Stream = NULL;
+	return true;
+}
+
 void FCompressedFile::Implode ()
 {
 	uLong outlen;
-	uLong len = m_BufferSize;
+	uLong len;
 	Byte *compressed = NULL;
-	BYTE *oldbuf = m_Buffer;
+	BYTE *oldbuf;
 	int r;
 
+	if (m_Stream != NULL && FinishStream ())
+	{
+		return;
+	}
+	len = m_BufferSize;
+	oldbuf = m_Buffer;
+
 	if (!nofilecompression && !m_NoCompress)
 	{
 		outlen = OUT_LEN(len);
 		do
 		{
 			compressed = new Bytef[outlen];
-			r = compress (compressed, &outlen, m_Buffer, len);
+			r = compress2 (compressed, &outlen, m_Buffer, len, m_Level);
 			if (r == Z_BUF_ERROR)
 			{
 				delete[] compressed;
@@ -668,6 +992,7 @@ void FArchive::AttachToFile (FFile &file)
 	m_File = &file;
 	m_MaxObjectCount = m_ObjectCount = 0;
 	m_ObjectMap = NULL;
+	m_ObjectHash = NULL;
 	if (file.Mode() == FFile::EReading)
 	{
 		m_Loading = true;
@@ -689,7 +1014,6 @@ void FArchive::AttachToFile (FFile &file)
 	m_ClassCount = 0;
 	for (i = 0; i < EObjectHashSize; i++)
 	{
-		m_ObjectHash[i] = ~0;
 		m_NameHash[i] = NameMap::NO_INDEX;
 	}
 	m_NumSprites = 0;
@@ -707,6 +1031,8 @@ FArchive::~FArchive ()
 		delete[] m_TypeMap;
 	if (m_ObjectMap)
 		M_Free (m_ObjectMap);
+	if (m_ObjectHash)
+		delete[] m_ObjectHash;
 	if (m_SpriteMap)
 		delete[] m_SpriteMap;
 }
@@ -1477,25 +1803,52 @@ DWORD FArchive::MapObject (const DObject *obj)
 			m_ObjectMap[i].hashNext = ~0;
 			m_ObjectMap[i].object = NULL;
 		}
+		if (m_Storing)
+		{
+			// Keep as many hash buckets as there is room for objects
+			// so that the chains stay short on big levels.
+			if (m_ObjectHash != NULL)
+			{
+				delete[] m_ObjectHash;
+			}
+			m_ObjectHash = new DWORD[m_MaxObjectCount];
+			memset (m_ObjectHash, 0xff, sizeof(DWORD)*m_MaxObjectCount);
+			for (i = 0; i < m_ObjectCount; i++)
+			{
+				DWORD hash = HashObject (m_ObjectMap[i].object);
+				m_ObjectMap[i].hashNext = m_ObjectHash[hash];
+				m_ObjectHash[hash] = i;
+			}
+		}
 	}
 
 	DWORD index = m_ObjectCount++;
-	DWORD hash = HashObject (obj);
 
 	m_ObjectMap[index].object = obj;
-	m_ObjectMap[index].hashNext = m_ObjectHash[hash];
-	m_ObjectHash[hash] = index;
+	if (m_Storing)
+	{
+		// Only needed for finding objects that were already written.
+		DWORD hash = HashObject (obj);
+		m_ObjectMap[index].hashNext = m_ObjectHash[hash];
+		m_ObjectHash[hash] = index;
+	}
 
 	return index;
 }
 
 DWORD FArchive::HashObject (const DObject *obj) const
 {
-	return (DWORD)((size_t)obj % EObjectHashSize);
+	// m_MaxObjectCount is always a power of 2.
+	size_t key = (size_t)obj >> 4;
+	return (DWORD)((key ^ (key >> 11) ^ (key >> 22)) & (m_MaxObjectCount - 1));
 }
 
 DWORD FArchive::FindObjectIndex (const DObject *obj) const
 {
+	if (m_ObjectHash == NULL)
+	{
+		return TypeMap::NO_INDEX;
+	}
 	DWORD index = m_ObjectHash[HashObject (obj)];
 	while (index != TypeMap::NO_INDEX && m_ObjectMap[index].object != obj)
 	{
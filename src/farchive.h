@@ -72,6 +72,8 @@ virtual	FFile& Seek (int, ESeekPos) = 0;
 inline	FFile& Seek (unsigned int i, ESeekPos p) { return Seek ((int)i, p); }
 };
 
+struct FCompressStream;
+
 class FCompressedFile : public FFile
 {
 public:
@@ -93,6 +95,9 @@ public:
 	unsigned int Tell () const;
 	FFile &Seek (int, ESeekPos);
 
+	// zlib compression level, -1 for zlib's default.
+	void SetCompressionLevel (int level) { m_Level = level; }
+
 protected:
 	unsigned int m_Pos;
 	unsigned int m_BufferSize;
@@ -101,6 +106,13 @@ protected:
 	bool m_NoCompress;
 	EOpenMode m_Mode;
 	FILE *m_File;
+	int m_Level;
+
+	// Once a file grows past the first block, it is compressed block by
+	// block while it is still being written. m_Buffer then only holds the
+	// block starting at m_BlockStart.
+	FCompressStream *m_Stream;
+	unsigned int m_BlockStart;
 
 	void Implode ();
 	void Explode ();
@@ -109,6 +121,10 @@ protected:
 
 private:
 	void BeEmpty ();
+	bool StartStream ();
+	void StreamWrite (const BYTE *mem, unsigned int len);
+	void StopStream ();
+	bool FinishStream ();
 };
 
 class FCompressedMemFile : public FCompressedFile
@@ -203,7 +219,7 @@ inline	FArchive& operator<< (bool &b) { return operator<< ((BYTE &)b); }
 inline  FArchive& operator<< (DObject* &object) { return ReadObject (object, RUNTIME_CLASS(DObject)); }
 
 protected:
-		enum { EObjectHashSize = 137 };
+		enum { EObjectHashSize = 137 };	// for names; objects use m_MaxObjectCount buckets
 
 		DWORD FindObjectIndex (const DObject *obj) const;
 		DWORD MapObject (const DObject *obj);
@@ -239,7 +255,7 @@ protected:
 			const DObject *object;
 			DWORD hashNext;
 		} *m_ObjectMap;
-		DWORD m_ObjectHash[EObjectHashSize];
+		DWORD *m_ObjectHash;
 
 		struct NameMap
 		{
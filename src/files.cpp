@@ -33,6 +33,17 @@
 **
 */
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "files.h"
 #include "i_system.h"
 #include "templates.h"
@@ -264,6 +275,19 @@ long FileReaderZ::Read (void *buffer, long len)
 
 void FileReaderZ::FillBuffer ()
 {
+	const char *buffer = File.GetBuffer();
+
+	if (buffer != NULL)
+	{
+		// The compressed data is already in memory, so inflate it in place.
+		long pos = File.Tell();
+		Stream.next_in = (Bytef *)buffer + pos;
+		Stream.avail_in = File.GetLength() - pos;
+		File.Seek (0, SEEK_END);
+		SawEOF = true;
+		return;
+	}
+
 	long numread = File.Read (InBuff, BUFF_SIZE);
 
 	if (numread < BUFF_SIZE)
@@ -338,6 +362,18 @@ long FileReaderBZ2::Read (void *buffer, long len)
 
 void FileReaderBZ2::FillBuffer ()
 {
+	const char *buffer = File.GetBuffer();
+
+	if (buffer != NULL)
+	{
+		long pos = File.Tell();
+		Stream.next_in = (char *)buffer + pos;
+		Stream.avail_in = File.GetLength() - pos;
+		File.Seek (0, SEEK_END);
+		SawEOF = true;
+		return;
+	}
+
 	long numread = File.Read(InBuff, BUFF_SIZE);
 
 	if (numread < BUFF_SIZE)
@@ -527,3 +563,109 @@ char *MemoryReader::Gets(char *strbuf, int len)
 {
 	return GetsFromBuffer(bufptr, strbuf, len);
 }
+
+//==========================================================================
+//
+// MappedFileReader
+//
+// reads data from a file that is mapped into memory
+//
+//==========================================================================
+
+MappedFileReader::MappedFileReader ()
+: MemoryReader(NULL, 0), Mapping(NULL), MappedSize(0)
+{
+}
+
+MappedFileReader::~MappedFileReader ()
+{
+	if (Mapping != NULL)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile (Mapping);
+#else
+		munmap (Mapping, MappedSize);
+#endif
+		Mapping = NULL;
+	}
+}
+
+//==========================================================================
+//
+// MappedFileReader :: Open
+//
+// Returns false if the file cannot be mapped. The caller should then
+// fall back to a regular FileReader.
+//
+//==========================================================================
+
+bool MappedFileReader::Open (const char *filename)
+{
+	QWORD size;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA (filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER filesize;
+	if (!GetFileSizeEx (file, &filesize))
+	{
+		CloseHandle (file);
+		return false;
+	}
+	size = filesize.QuadPart;
+#else
+	int file = open (filename, O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat info;
+	if (fstat (file, &info) != 0 || !S_ISREG(info.st_mode))
+	{
+		close (file);
+		return false;
+	}
+	size = info.st_size;
+#endif
+
+	// FileReader offsets are longs, and a 32-bit process should not spend
+	// its address space on large files.
+	bool usable = size > 0 && size <= 0x7fffffff && (sizeof(void *) >= 8 || size <= 256*1024*1024);
+
+#ifdef _WIN32
+	if (usable)
+	{
+		HANDLE map = CreateFileMappingA (file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (map != NULL)
+		{
+			// The view keeps the mapping alive on its own.
+			Mapping = MapViewOfFile (map, FILE_MAP_COPY, 0, 0, 0);
+			CloseHandle (map);
+		}
+	}
+	CloseHandle (file);
+#else
+	if (usable)
+	{
+		void *map = mmap (NULL, (size_t)size, PROT_READ|PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (map != MAP_FAILED)
+		{
+			Mapping = map;
+		}
+	}
+	close (file);
+#endif
+
+	if (Mapping == NULL)
+	{
+		return false;
+	}
+	MappedSize = (size_t)size;
+	bufptr = (const char *)Mapping;
+	Length = (long)size;
+	FilePos = 0;
+	return true;
+}
@@ -338,6 +338,23 @@ protected:
 	const char * bufptr;
 };
 
+// Maps a whole file into memory. Since GetBuffer() points to the mapping,
+// uncompressed lumps can be used in place instead of being read into a
+// buffer of their own. The mapping is copy-on-write, so writing to it
+// never changes the file.
+class MappedFileReader : public MemoryReader
+{
+public:
+	MappedFileReader ();
+	~MappedFileReader ();
+
+	bool Open (const char *filename);
+
+private:
+	void *Mapping;
+	size_t MappedSize;
+};
+
 
 
 #endif
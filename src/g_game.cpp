@@ -112,6 +112,7 @@
 #include "p_3dmidtex.h"
 #include "a_lightning.h"
 #include "po_man.h"
+#include "r_renderbench.h"
 
 #include <zlib.h>
 
@@ -135,7 +136,7 @@ void	G_DoPlayDemo (void);
 void	G_DoCompleted (void);
 void	G_DoVictory (void);
 void	G_DoWorldDone (void);
-void	G_DoSaveGame (bool okForQuicksave, FString filename, const char *description);
+void	G_DoSaveGame (bool okForQuicksave, FString filename, const char *description, int compression = -1);
 void	G_DoAutoSave ();
 
 void STAT_Write(FILE *file);
@@ -4748,6 +4749,8 @@ FString G_BuildSaveName (const char *prefix, int slot)
 CVAR (Int, autosavenum, 0, CVAR_NOSET|CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 static int nextautosave = -1;
 CVAR (Int, disableautosave, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+// zlib level for autosaves. 1 is fastest, -1 is the same as for other saves.
+CVAR (Int, autosavecompression, -1, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CUSTOM_CVAR (Int, autosavecount, 4, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 {
 	if (self < 0)
@@ -4792,7 +4795,7 @@ void G_DoAutoSave ()
 	strncpy (description+9, readableTime+4, 12);
 	description[9+12] = 0;
 
-	G_DoSaveGame (false, file, description);
+	G_DoSaveGame (false, file, description, clamp<int> (autosavecompression, -1, 9));
 }
 
 
@@ -4857,7 +4860,7 @@ static void PutSavePic (FILE *file, int width, int height)
 	}
 }
 
-void G_DoSaveGame (bool okForQuicksave, FString filename, const char *description)
+void G_DoSaveGame (bool okForQuicksave, FString filename, const char *description, int compression)
 {
 	char buf[100];
 
@@ -4874,7 +4877,7 @@ void G_DoSaveGame (bool okForQuicksave, FString filename, const char *descriptio
 	}
 
 	insave = true;
-	G_SnapshotLevel ();
+	G_SnapshotLevel (compression);
 
 	FILE *stdfile = fopen (filename, "wb");
 
@@ -5458,6 +5461,7 @@ void G_TimeDemo (const char* name)
 	noblit = !!Args->CheckParm ("-noblit");
 	timingdemo = true;
 	singletics = true;
+	RENDERBENCH_StartDemo ();
 
 	defdemoname = name;
 	gameaction = (gameaction == ga_loadgame) ? ga_loadgameplaydemo : ga_playdemo;
@@ -5511,6 +5515,8 @@ bool G_CheckDemoStatus (void)
 		{
 			if (timingdemo)
 			{
+				RENDERBENCH_FinishDemo ();
+
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
 				// right now.
@@ -2262,7 +2262,7 @@ void G_SerializeLevel (FArchive &arc, bool hubLoad)
 //
 //==========================================================================
 
-void G_SnapshotLevel ()
+void G_SnapshotLevel (int compression)
 {
 	if (level.info->snapshot)
 		delete level.info->snapshot;
@@ -2272,6 +2272,7 @@ void G_SnapshotLevel ()
 		level.info->snapshotVer = SAVEVER;
 		level.info->snapshot = new FCompressedMemFile;
 		level.info->snapshot->Open ();
+		level.info->snapshot->SetCompressionLevel (compression);
 
 		FArchive arc (*level.info->snapshot);
 
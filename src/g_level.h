@@ -549,7 +549,7 @@ void G_ParseMapInfo (const char *basemapinfo);
 
 void G_ClearSnapshots (void);
 void P_RemoveDefereds ();
-void G_SnapshotLevel (void);
+void G_SnapshotLevel (int compression = -1);
 void G_UnSnapshotLevel (bool keepPlayers);
 struct PNGHandle;
 void G_ReadSnapshots (PNGHandle *png);
@@ -25,6 +25,11 @@
 #include <stdlib.h>
 #include "mystdint.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HQX_SSE2
+#include <emmintrin.h>
+#endif
+
 #define MASK_2     0x0000FF00
 #define MASK_13    0x00FF00FF
 #define MASK_RGB   0x00FFFFFF
@@ -58,7 +63,75 @@ static inline int Diff(uint32_t c1, uint32_t c2)
     return yuv_diff(rgb_to_yuv(c1), rgb_to_yuv(c2));
 }
 
+/* Returns a bit for each of w[1..4] and w[6..9] that differs from w[5] */
+static inline int DiffPattern(const uint32_t *w)
+{
+#ifdef HQX_SSE2
+    /* Y, U and V are one byte each, so yuv_diff is a per-byte test of the
+       absolute difference against the threshold. The alpha byte is always
+       0 in the table and never differs. */
+    const __m128i thresh = _mm_set1_epi32((trY >> 16 << 16) | (trU >> 8 << 8) | trV);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i c = _mm_set1_epi32(rgb_to_yuv(w[5]));
+    __m128i lo = _mm_setr_epi32(rgb_to_yuv(w[1]), rgb_to_yuv(w[2]), rgb_to_yuv(w[3]), rgb_to_yuv(w[4]));
+    __m128i hi = _mm_setr_epi32(rgb_to_yuv(w[6]), rgb_to_yuv(w[7]), rgb_to_yuv(w[8]), rgb_to_yuv(w[9]));
+    lo = _mm_or_si128(_mm_subs_epu8(lo, c), _mm_subs_epu8(c, lo));
+    hi = _mm_or_si128(_mm_subs_epu8(hi, c), _mm_subs_epu8(c, hi));
+    lo = _mm_cmpeq_epi32(_mm_subs_epu8(lo, thresh), zero);
+    hi = _mm_cmpeq_epi32(_mm_subs_epu8(hi, thresh), zero);
+    return ~(_mm_movemask_ps(_mm_castsi128_ps(lo)) | (_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4)) & 0xFF;
+#else
+    int pattern = 0;
+    int flag = 1;
+    uint32_t yuv1 = rgb_to_yuv(w[5]);
+
+    for (int k=1; k<=9; k++)
+    {
+        if (k==5) continue;
+
+        if ( w[k] != w[5] )
+        {
+            if (yuv_diff(yuv1, rgb_to_yuv(w[k])))
+                pattern |= flag;
+        }
+        flag <<= 1;
+    }
+    return pattern;
+#endif
+}
+
 /* Interpolate functions */
+#ifdef HQX_SSE2
+/* Every channel is weighted in its own 16 bit lane. The weights add up
+   to 1 << s <= 16, so the sums can't overflow and the result matches the
+   packed integer version below bit for bit. */
+static inline __m128i Unpack(uint32_t c)
+{
+    return _mm_unpacklo_epi8(_mm_cvtsi32_si128(c), _mm_setzero_si128());
+}
+
+static inline uint32_t Pack(__m128i sum, int s)
+{
+    sum = _mm_srl_epi16(sum, _mm_cvtsi32_si128(s));
+    return _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+}
+
+static inline uint32_t Interpolate_2(uint32_t c1, int w1, uint32_t c2, int w2, int s)
+{
+    if (c1 == c2) {
+        return c1;
+    }
+    return Pack(_mm_add_epi16(_mm_mullo_epi16(Unpack(c1), _mm_set1_epi16(w1)),
+                              _mm_mullo_epi16(Unpack(c2), _mm_set1_epi16(w2))), s);
+}
+
+static inline uint32_t Interpolate_3(uint32_t c1, int w1, uint32_t c2, int w2, uint32_t c3, int w3, int s)
+{
+    return Pack(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(Unpack(c1), _mm_set1_epi16(w1)),
+                                            _mm_mullo_epi16(Unpack(c2), _mm_set1_epi16(w2))),
+                              _mm_mullo_epi16(Unpack(c3), _mm_set1_epi16(w3))), s);
+}
+#else
 static inline uint32_t Interpolate_2(uint32_t c1, int w1, uint32_t c2, int w2, int s)
 {
     if (c1 == c2) {
@@ -77,6 +150,7 @@ static inline uint32_t Interpolate_3(uint32_t c1, int w1, uint32_t c2, int w2, u
         ((((c1 & MASK_2) * w1 + (c2 & MASK_2) * w2 + (c3 & MASK_2) * w3) >> s) & MASK_2) +
         ((((c1 & MASK_13) * w1 + (c2 & MASK_13) * w2 + (c3 & MASK_13) * w3) >> s) & MASK_13);
 }
+#endif
 
 static inline uint32_t Interp1(uint32_t c1, uint32_t c2)
 {
@@ -52,4 +52,9 @@ HQX_API void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uin
 HQX_API void HQX_CALLCONV hq3x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
 HQX_API void HQX_CALLCONV hq4x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
 
+/* Only produce the output for source rows [firstRow, lastRow), so that an image can be split up between threads */
+HQX_API void HQX_CALLCONV hq2x_32_rows( uint32_t * src, uint32_t * dest, int width, int height, int firstRow, int lastRow );
+HQX_API void HQX_CALLCONV hq3x_32_rows( uint32_t * src, uint32_t * dest, int width, int height, int firstRow, int lastRow );
+HQX_API void HQX_CALLCONV hq4x_32_rows( uint32_t * src, uint32_t * dest, int width, int height, int firstRow, int lastRow );
+
 #endif
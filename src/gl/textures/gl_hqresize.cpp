@@ -39,6 +39,13 @@
 #include "gl/renderer/gl_renderer.h"
 #include "gl/textures/gl_texture.h"
 #include "c_cvars.h"
+#include "c_dispatch.h"
+#include "m_crc32.h"
+#include "stats.h"
+#include "templates.h"
+#include "v_text.h"
+#include "workerpool.h"
+#include "textures/bitmap.h"
 #include "gl/hqnx/hqx.h"
 #ifdef _MSC_VER
 #include "gl/hqnx_asm/hqnx_asm.h"
@@ -67,19 +74,18 @@ CVAR (Flag, gl_texture_hqresize_sprites, gl_texture_hqresize_targets, 2);
 CVAR (Flag, gl_texture_hqresize_fonts, gl_texture_hqresize_targets, 4);
 
 
-static void scale2x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, int inHeight )
+static void scale2xRows ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, int inHeight, int firstRow, int lastRow )
 {
 	const int width = 2* inWidth;
-	const int height = 2 * inHeight;
 
-	for ( int i = 0; i < inWidth; ++i )
+	for ( int j = firstRow; j < lastRow; ++j )
 	{
-		const int iMinus = (i > 0) ? (i-1) : 0;
-		const int iPlus = (i < inWidth - 1 ) ? (i+1) : i;
-		for ( int j = 0; j < inHeight; ++j )
+		const int jMinus = (j > 0) ? (j-1) : 0;
+		const int jPlus = (j < inHeight - 1 ) ? (j+1) : j;
+		for ( int i = 0; i < inWidth; ++i )
 		{
-			const int jMinus = (j > 0) ? (j-1) : 0;
-			const int jPlus = (j < inHeight - 1 ) ? (j+1) : j;
+			const int iMinus = (i > 0) ? (i-1) : 0;
+			const int iPlus = (i < inWidth - 1 ) ? (i+1) : i;
 			const uint32 A = inputBuffer[ iMinus +inWidth*jMinus];
 			const uint32 B = inputBuffer[ iMinus +inWidth*j    ];
 			const uint32 C = inputBuffer[ iMinus +inWidth*jPlus];
@@ -104,19 +110,18 @@ static void scale2x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, in
 	}
 }
 
-static void scale3x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, int inHeight )
+static void scale3xRows ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, int inHeight, int firstRow, int lastRow )
 {
 	const int width = 3* inWidth;
-	const int height = 3 * inHeight;
 
-	for ( int i = 0; i < inWidth; ++i )
+	for ( int j = firstRow; j < lastRow; ++j )
 	{
-		const int iMinus = (i > 0) ? (i-1) : 0;
-		const int iPlus = (i < inWidth - 1 ) ? (i+1) : i;
-		for ( int j = 0; j < inHeight; ++j )
+		const int jMinus = (j > 0) ? (j-1) : 0;
+		const int jPlus = (j < inHeight - 1 ) ? (j+1) : j;
+		for ( int i = 0; i < inWidth; ++i )
 		{
-			const int jMinus = (j > 0) ? (j-1) : 0;
-			const int jPlus = (j < inHeight - 1 ) ? (j+1) : j;
+			const int iMinus = (i > 0) ? (i-1) : 0;
+			const int iPlus = (i < inWidth - 1 ) ? (i+1) : i;
 			const uint32 A = inputBuffer[ iMinus +inWidth*jMinus];
 			const uint32 B = inputBuffer[ iMinus +inWidth*j    ];
 			const uint32 C = inputBuffer[ iMinus +inWidth*jPlus];
@@ -151,6 +156,49 @@ static void scale3x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, in
 	}
 }
 
+//===========================================================================
+//
+// The scalers only look at the neighbours of each input pixel, so the
+// input can be split into bands of rows that are scaled on all worker
+// threads at once.
+//
+//===========================================================================
+
+enum { HQRESIZE_TILE_ROWS = 16 };
+
+static bool hqresize_singlethreaded;	// for benchhqresize
+
+static void ForEachRowTile ( const int inHeight, const std::function<void ( int, int )> &body )
+{
+	const int tiles = (inHeight + HQRESIZE_TILE_ROWS - 1) / HQRESIZE_TILE_ROWS;
+
+	if ( hqresize_singlethreaded || tiles <= 1 )
+	{
+		body ( 0, inHeight );
+		return;
+	}
+	WorkerPool.ParallelFor ( tiles, [&]( unsigned int tile )
+	{
+		body ( tile * HQRESIZE_TILE_ROWS, MIN<int> ( inHeight, (tile + 1) * HQRESIZE_TILE_ROWS ) );
+	});
+}
+
+static void scale2x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, int inHeight )
+{
+	ForEachRowTile ( inHeight, [=]( int firstRow, int lastRow )
+	{
+		scale2xRows ( inputBuffer, outputBuffer, inWidth, inHeight, firstRow, lastRow );
+	});
+}
+
+static void scale3x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, int inHeight )
+{
+	ForEachRowTile ( inHeight, [=]( int firstRow, int lastRow )
+	{
+		scale3xRows ( inputBuffer, outputBuffer, inWidth, inHeight, firstRow, lastRow );
+	});
+}
+
 static void scale4x ( uint32* inputBuffer, uint32* outputBuffer, int inWidth, int inHeight )
 {
 	int width = 2* inWidth;
@@ -214,7 +262,7 @@ static unsigned char *hqNxAsmHelper( void (*hqNxFunction) ( int*, unsigned char*
 }
 #endif
 
-static unsigned char *hqNxHelper( void (*hqNxFunction) ( unsigned*, unsigned*, int, int ),
+static unsigned char *hqNxHelper( void (*hqNxFunction) ( uint32_t*, uint32_t*, int, int, int, int ),
 							  const int N,
 							  unsigned char *inputBuffer,
 							  const int inWidth,
@@ -233,7 +281,10 @@ static unsigned char *hqNxHelper( void (*hqNxFunction) ( unsigned*, unsigned*, i
 	outHeight = N *inHeight;
 
 	unsigned char * newBuffer = new unsigned char[outWidth*outHeight*4];
-	hqNxFunction( reinterpret_cast<unsigned*>(inputBuffer), reinterpret_cast<unsigned*>(newBuffer), inWidth, inHeight );
+	ForEachRowTile ( inHeight, [=]( int firstRow, int lastRow )
+	{
+		hqNxFunction( reinterpret_cast<uint32_t*>(inputBuffer), reinterpret_cast<uint32_t*>(newBuffer), inWidth, inHeight, firstRow, lastRow );
+	});
 	delete[] inputBuffer;
 	return newBuffer;
 }
@@ -293,29 +344,206 @@ unsigned char *gl_CreateUpsampledTextureBuffer ( const FTexture *inputTexture, u
 		}
 #endif
 
+		if (type < 1 || type > 9)
+		{
+			return inputBuffer;
+		}
+
+		// Upsampling is slow, so the result is kept in a cache on disk.
+		BYTE key[16];
+		gl_GetUpsampleCacheKey(key, inputBuffer, inWidth, inHeight, type);
+		unsigned char *outputBuffer = gl_LoadCachedUpsample(key, outWidth, outHeight);
+		if (outputBuffer != NULL)
+		{
+			delete[] inputBuffer;
+			return outputBuffer;
+		}
+
+		outputBuffer = inputBuffer;
 		switch (type)
 		{
 		case 1:
-			return scaleNxHelper( &scale2x, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = scaleNxHelper( &scale2x, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 2:
-			return scaleNxHelper( &scale3x, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = scaleNxHelper( &scale3x, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 3:
-			return scaleNxHelper( &scale4x, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = scaleNxHelper( &scale4x, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 4:
-			return hqNxHelper( &hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxHelper( &hq2x_32_rows, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 5:
-			return hqNxHelper( &hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxHelper( &hq3x_32_rows, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 6:
-			return hqNxHelper( &hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxHelper( &hq4x_32_rows, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 #ifdef _MSC_VER
 		case 7:
-			return hqNxAsmHelper( &HQnX_asm::hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxAsmHelper( &HQnX_asm::hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 8:
-			return hqNxAsmHelper( &HQnX_asm::hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxAsmHelper( &HQnX_asm::hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 		case 9:
-			return hqNxAsmHelper( &HQnX_asm::hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			outputBuffer = hqNxAsmHelper( &HQnX_asm::hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+			break;
 #endif
 		}
+		if (outputBuffer != inputBuffer)
+		{
+			gl_StoreCachedUpsample(key, outputBuffer, outWidth, outHeight);
+		}
+		return outputBuffer;
 	}
 	return inputBuffer;
 }
+
+//===========================================================================
+// 
+// Times every upsampling filter on the sprites of the loaded game, once
+// on a single thread and once split between the worker threads, and
+// checks that both produce the same output. Doesn't need the GL renderer.
+//
+// Each filter is also run on a generated image, and the output is compared
+// against the CRC32 the original scalar, single threaded code produced for
+// it (with the RGB to YUV table including white).
+//
+//===========================================================================
+
+enum { HQRESIZE_TEST_WIDTH = 61, HQRESIZE_TEST_HEIGHT = 47 };
+
+static const DWORD HQResizeReferenceCRCs[7] =
+{
+	0, 0xc69f087a, 0x46a5c4d3, 0x1122b3f2, 0xaeee63ab, 0x293eca73, 0xbc124838
+};
+
+// Runs of a few colors with some noise, so that most of the hqNx edge rules
+// get used. The height is not a multiple of the row tiles on purpose.
+static unsigned char *MakeHQResizeTestImage ( int w, int h )
+{
+	static const BYTE colors[8][4] =
+	{
+		{ 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 255, 0, 0, 255 }, { 0, 160, 0, 255 },
+		{ 40, 40, 200, 128 }, { 0, 0, 0, 0 }, { 128, 128, 128, 255 }, { 136, 128, 120, 255 },
+	};
+	unsigned char *image = new unsigned char[w * h * 4];
+	DWORD seed = 12345;
+
+	for (int y = 0; y < h; y++)
+	{
+		for (int x = 0; x < w; x++)
+		{
+			unsigned char *p = image + (y * w + x) * 4;
+			seed = seed * 1664525 + 1013904223;
+			DWORD r = seed >> 24;
+			if (x > 0 && r < 128) memcpy (p, p - 4, 4);
+			else if (y > 0 && r < 192) memcpy (p, p - w * 4, 4);
+			else if (r < 240) memcpy (p, colors[r & 7], 4);
+			else { p[0] = BYTE(seed >> 16); p[1] = BYTE(seed >> 8); p[2] = BYTE(seed); p[3] = 255; }
+		}
+	}
+	return image;
+}
+
+static unsigned char *RunUpsampleFilter ( int type, unsigned char *inputBuffer, int inWidth, int inHeight, int &outWidth, int &outHeight )
+{
+	switch (type)
+	{
+	case 1:
+		return scaleNxHelper( &scale2x, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	case 2:
+		return scaleNxHelper( &scale3x, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	case 3:
+		return scaleNxHelper( &scale4x, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	case 4:
+		return hqNxHelper( &hq2x_32_rows, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	case 5:
+		return hqNxHelper( &hq3x_32_rows, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	default:
+		return hqNxHelper( &hq4x_32_rows, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	}
+}
+
+CCMD (benchhqresize)
+{
+	static const char *const filternames[] = { "", "scale2x", "scale3x", "scale4x", "hq2x", "hq3x", "hq4x" };
+	TArray<FTexture *> sprites;
+	unsigned maxsprites = argv.argc() > 1 ? (unsigned)atoi(argv[1]) : 256;
+
+	for (int i = 0; i < TexMan.NumTextures() && sprites.Size() < maxsprites; i++)
+	{
+		FTexture *tex = TexMan.ByIndex(i);
+		if (tex != NULL && tex->UseType == FTexture::TEX_Sprite &&
+			tex->GetWidth() <= gl_texture_hqresize_maxinputsize && tex->GetHeight() <= gl_texture_hqresize_maxinputsize)
+		{
+			sprites.Push(tex);
+		}
+	}
+	if (sprites.Size() == 0)
+	{
+		Printf ("No sprites to upsample\n");
+		return;
+	}
+
+	Printf ("Upsampling %u sprites with %u threads\n", sprites.Size(), WorkerPool.GetNumThreads());
+	Printf ("%-8s %10s %10s %8s %10s\n", "filter", "1 thread", "threaded", "output", "reference");
+	for (int type = 1; type <= 6; type++)
+	{
+		cycle_t single, threaded;
+		bool match = true;
+		const char *reference;
+
+		// The reference CRCs were made on a little endian machine.
+#ifndef __BIG_ENDIAN__
+		{
+			int ow, oh;
+			unsigned char *out = RunUpsampleFilter(type, MakeHQResizeTestImage(HQRESIZE_TEST_WIDTH, HQRESIZE_TEST_HEIGHT),
+				HQRESIZE_TEST_WIDTH, HQRESIZE_TEST_HEIGHT, ow, oh);
+			reference = CalcCRC32(out, ow * oh * 4) == HQResizeReferenceCRCs[type] ? "same" : TEXTCOLOR_RED "DIFFERS";
+			delete[] out;
+		}
+#else
+		reference = "n/a";
+#endif
+
+		single.Reset();
+		threaded.Reset();
+		for (unsigned i = 0; i < sprites.Size(); i++)
+		{
+			FTexture *tex = sprites[i];
+			int w = tex->GetWidth(), h = tex->GetHeight();
+			int ow1, oh1, ow2, oh2;
+			FBitmap bmp;
+
+			bmp.Create(w, h);
+			tex->CopyTrueColorPixels(&bmp, 0, 0);
+
+			unsigned char *in1 = new unsigned char[w * h * 4];
+			unsigned char *in2 = new unsigned char[w * h * 4];
+			memcpy(in1, bmp.GetPixels(), w * h * 4);
+			memcpy(in2, bmp.GetPixels(), w * h * 4);
+
+			hqresize_singlethreaded = true;
+			single.Clock();
+			unsigned char *out1 = RunUpsampleFilter(type, in1, w, h, ow1, oh1);
+			single.Unclock();
+			hqresize_singlethreaded = false;
+
+			threaded.Clock();
+			unsigned char *out2 = RunUpsampleFilter(type, in2, w, h, ow2, oh2);
+			threaded.Unclock();
+
+			if (ow1 != ow2 || oh1 != oh2 || memcmp(out1, out2, ow1 * oh1 * 4) != 0)
+			{
+				match = false;
+			}
+			delete[] out1;
+			delete[] out2;
+		}
+		Printf ("%-8s %8.2fms %8.2fms %8s %10s\n", filternames[type], single.TimeMS(), threaded.TimeMS(),
+			match ? "same" : TEXTCOLOR_RED "DIFFERS" TEXTCOLOR_NORMAL, reference);
+	}
+}
@@ -0,0 +1,285 @@
+/*
+** gl_texcache.cpp
+** Persistent cache of upsampled texture buffers
+**
+** Running hqNx or scaleNx over every texture and sprite is by far the
+** slowest part of creating a hardware texture, and the result is the same
+** on every run. So the upsampled buffers are stored in the cache directory,
+** one file per buffer, named after an MD5 of the input buffer, its size and
+** the upsampling mode. Keying on the input buffer rather than the lump
+** means that translations, multipatch composition and anything else that
+** went into the buffer are covered automatically.
+**
+** The files hold the raw RGBA data behind a small header so that they can
+** be read straight into the buffer that is handed to the hardware texture.
+** Every hit touches the file's modification time, and when the cache grows
+** beyond gl_texture_hqresize_cachesize megabytes the least recently used
+** files are removed.
+*/
+
+#include "gl/system/gl_system.h"
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+#include "doomdef.h"
+#include "doomerrors.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "cmdlib.h"
+#include "m_swap.h"
+#include "m_misc.h"
+#include "md5.h"
+#include "templates.h"
+#include "gl/textures/gl_texture.h"
+
+CVAR(Bool, gl_texture_hqresize_cache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Int, gl_texture_hqresize_cachesize, 256, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+// Must change whenever the output of the upsampling filters changes, so that
+// files made by older versions are not used anymore.
+// HQC2: hqNx handles pure white correctly.
+#define TEXCACHE_MAGIC		MAKE_ID('H','Q','C','2')
+#define TEXCACHE_HEADER		12
+
+// Total size of all files in the cache, or -1 if it hasn't been scanned yet.
+static SQWORD TexCacheSize = -1;
+
+struct FTexCacheFile
+{
+	FString Filename;
+	QWORD Size;
+	time_t LastUse;
+};
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+static FString TexCachePath(bool create)
+{
+	FString path = M_GetCachePath(create);
+	path << "/textures/";
+	if (create) CreatePath(path);
+	return path;
+}
+
+static FString TexCacheName(const BYTE key[16], bool create)
+{
+	FString path = TexCachePath(create);
+	for (int i = 0; i < 16; i++)
+	{
+		path.AppendFormat("%02x", key[i]);
+	}
+	path << ".hqc";
+	return path;
+}
+
+//===========================================================================
+//
+// Lists all files in the cache and adds up their sizes
+//
+//===========================================================================
+
+static void ScanTexCache(TArray<FTexCacheFile> &files)
+{
+	TArray<FFileList> list;
+
+	TexCacheSize = 0;
+	try
+	{
+		ScanDirectory(list, TexCachePath(false));
+	}
+	catch (CRecoverableError &)
+	{
+		return;
+	}
+
+	for (unsigned i = 0; i < list.Size(); i++)
+	{
+		struct stat info;
+
+		if (!list[i].isDirectory && stat(list[i].Filename, &info) == 0)
+		{
+			FTexCacheFile file = { list[i].Filename, QWORD(info.st_size), info.st_mtime };
+			files.Push(file);
+			TexCacheSize += info.st_size;
+		}
+	}
+}
+
+static int STACK_ARGS CompareLastUse(const void *a, const void *b)
+{
+	time_t ta = ((const FTexCacheFile *)a)->LastUse;
+	time_t tb = ((const FTexCacheFile *)b)->LastUse;
+	return ta < tb ? -1 : ta > tb ? 1 : 0;
+}
+
+//===========================================================================
+//
+// Removes the least recently used files until the cache is back
+// below 3/4 of its maximum size, so that this doesn't happen again
+// with the next texture that gets stored.
+//
+//===========================================================================
+
+static void TrimTexCache()
+{
+	SQWORD limit = SQWORD(MAX<int>(gl_texture_hqresize_cachesize, 0)) << 20;
+
+	if (TexCacheSize <= limit)
+	{
+		return;
+	}
+
+	TArray<FTexCacheFile> files;
+	ScanTexCache(files);
+	if (files.Size() > 0)
+	{
+		qsort(&files[0], files.Size(), sizeof(files[0]), CompareLastUse);
+	}
+	for (unsigned i = 0; i < files.Size() && TexCacheSize > limit / 4 * 3; i++)
+	{
+		if (remove(files[i].Filename) == 0)
+		{
+			TexCacheSize -= files[i].Size;
+		}
+	}
+}
+
+//===========================================================================
+//
+// Computes the cache key of an upsampling operation
+//
+//===========================================================================
+
+void gl_GetUpsampleCacheKey(BYTE key[16], const unsigned char *inputBuffer, int inWidth, int inHeight, int type)
+{
+	MD5Context md5;
+	DWORD header[3] = { LittleLong(inWidth), LittleLong(inHeight), LittleLong(type) };
+
+	md5.Init();
+	md5.Update((const BYTE *)header, sizeof(header));
+	md5.Update(inputBuffer, inWidth * inHeight * 4);
+	md5.Final(key);
+}
+
+//===========================================================================
+//
+// Returns the cached upsampled buffer for the key, or NULL if there
+// is none. The buffer must be freed with delete[].
+//
+//===========================================================================
+
+unsigned char *gl_LoadCachedUpsample(const BYTE key[16], int &outWidth, int &outHeight)
+{
+	if (!gl_texture_hqresize_cache)
+	{
+		return NULL;
+	}
+
+	FString name = TexCacheName(key, false);
+	FILE *f = fopen(name, "rb");
+	if (f == NULL)
+	{
+		return NULL;
+	}
+
+	DWORD header[3];
+	unsigned char *buffer = NULL;
+	if (fread(header, 1, TEXCACHE_HEADER, f) == TEXCACHE_HEADER && header[0] == TEXCACHE_MAGIC)
+	{
+		int w = LittleLong(header[1]);
+		int h = LittleLong(header[2]);
+		if (w > 0 && h > 0 && w <= 8192 && h <= 8192)
+		{
+			size_t size = size_t(w) * h * 4;
+			buffer = new unsigned char[size];
+			if (fread(buffer, 1, size, f) == size)
+			{
+				outWidth = w;
+				outHeight = h;
+			}
+			else
+			{
+				delete[] buffer;
+				buffer = NULL;
+			}
+		}
+	}
+	fclose(f);
+
+	if (buffer != NULL)
+	{
+		// Mark it as recently used.
+		utime(name, NULL);
+	}
+	else
+	{
+		// Truncated or otherwise broken. Get rid of it.
+		remove(name);
+	}
+	return buffer;
+}
+
+//===========================================================================
+//
+// Stores an upsampled buffer in the cache
+//
+//===========================================================================
+
+void gl_StoreCachedUpsample(const BYTE key[16], const unsigned char *buffer, int width, int height)
+{
+	if (!gl_texture_hqresize_cache || gl_texture_hqresize_cachesize <= 0)
+	{
+		return;
+	}
+
+	if (TexCacheSize < 0)
+	{
+		TArray<FTexCacheFile> files;
+		ScanTexCache(files);
+	}
+
+	FString name = TexCacheName(key, true);
+	FILE *f = fopen(name, "wb");
+	if (f == NULL)
+	{
+		return;
+	}
+
+	DWORD header[3] = { TEXCACHE_MAGIC, LittleLong(width), LittleLong(height) };
+	size_t size = size_t(width) * height * 4;
+	bool ok = fwrite(header, 1, TEXCACHE_HEADER, f) == TEXCACHE_HEADER &&
+		fwrite(buffer, 1, size, f) == size;
+
+	if (fclose(f) != 0 || !ok)
+	{
+		remove(name);
+		return;
+	}
+	TexCacheSize += TEXCACHE_HEADER + size;
+	TrimTexCache();
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+UNSAFE_CCMD(cleartexturecache)
+{
+	TArray<FTexCacheFile> files;
+
+	ScanTexCache(files);
+	for (unsigned i = 0; i < files.Size(); i++)
+	{
+		remove(files[i].Filename);
+	}
+	TexCacheSize = 0;
+}
@@ -80,6 +80,9 @@ PalEntry averageColor(const DWORD *data, int size, fixed_t maxout);
 
 
 unsigned char *gl_CreateUpsampledTextureBuffer ( const FTexture *inputTexture, unsigned char *inputBuffer, const int inWidth, const int inHeight, int &outWidth, int &outHeight, bool hasAlpha );
+void gl_GetUpsampleCacheKey(BYTE key[16], const unsigned char *inputBuffer, int inWidth, int inHeight, int type);
+unsigned char *gl_LoadCachedUpsample(const BYTE key[16], int &outWidth, int &outHeight);
+void gl_StoreCachedUpsample(const BYTE key[16], const unsigned char *buffer, int width, int height);
 int CheckDDPK3(FTexture *tex);
 int CheckExternalFile(FTexture *tex, bool & hascolorkey);
 PalEntry averageColor(const DWORD *data, int size, fixed_t maxout);
@@ -261,18 +261,19 @@ MD5Transform(DWORD buf[4], const DWORD in[16])
 #include <errno.h>
 
 // [BB]
-bool MD5SumOfFile ( const char *Filename, char *MD5Sum )
+bool MD5SumOfFile ( const char *Filename, char *MD5Sum, bool bPrintErrors )
 {
 	FILE *file = fopen(Filename, "rb");
 	if (file == NULL)
 	{
-		Printf("%s: %s\n", Filename, strerror(errno));
+		if (bPrintErrors)
+			Printf("%s: %s\n", Filename, strerror(errno));
 		return false;
 	}
 	else
 	{
 		MD5Context md5;
-		BYTE readbuf[8192];
+		BYTE readbuf[65536];
 		size_t len;
 
 		while ((len = fread(readbuf, 1, sizeof(readbuf), file)) > 0)
@@ -282,7 +283,7 @@ bool MD5SumOfFile ( const char *Filename, char *MD5Sum )
 		md5.Final(readbuf);
 		for(int j = 0; j < 16; ++j)
 		{
-			mysnprintf(MD5Sum, sizeof(MD5Sum), "%02x", readbuf[j]);
+			mysnprintf(MD5Sum, 3, "%02x", readbuf[j]);
 			++++MD5Sum;
 		}
 		fclose (file);
@@ -33,6 +33,9 @@
 */
 
 #include <string.h>
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
 #include "name.h"
 #include "c_dispatch.h"
 #include "c_console.h"
@@ -44,7 +47,8 @@
 // that is just large enough to hold it.
 #define BLOCK_SIZE			4096
 
-// How many entries to grow the NameArray by when it needs to grow.
+// How many entries the NameArray must have room for beyond the predefined
+// names when it is first allocated. It doubles every time it fills up.
 #define NAME_GROW_AMOUNT	256
 
 // TYPES -------------------------------------------------------------------
@@ -59,6 +63,31 @@ struct FName::NameManager::NameBlock
 	NameBlock *NextBlock;
 };
 
+// The NameArray and its hash buckets live together in a NameTable. There is
+// one bucket per entry, so when the array fills up, a new table twice as
+// large is built and replaces the old one. Old tables are never changed
+// again and are kept until shutdown, so a thread that is still walking one
+// (or reading a name's text through a stale NameArray pointer) is safe.
+//
+// Lookups do not lock anything: a new name is fully written before its
+// bucket head is stored with release semantics, and the current table is
+// published the same way. Only adding a name takes the lock.
+
+struct FName::NameManager::NameTable
+{
+	NameEntry *Names;
+	int *Next;					// Hash chain links, parallel to Names
+	std::atomic<int> *Buckets;
+	unsigned int Mask;
+	int Capacity;
+	NameTable *Prev;
+
+	int Find (const char *text, size_t textLen, unsigned int hash) const;
+
+	static std::atomic<NameTable *> Current;
+	static std::mutex Lock;
+};
+
 // PRIVATE FUNCTION PROTOTYPES ---------------------------------------------
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
@@ -66,7 +95,8 @@ struct FName::NameManager::NameBlock
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
 FName::NameManager FName::NameData;
-bool FName::NameManager::Inited;
+std::atomic<FName::NameManager::NameTable *> FName::NameManager::NameTable::Current;
+std::mutex FName::NameManager::NameTable::Lock;
 
 // Define the predefined names.
 static const char *PredefinedNames[] =
@@ -80,47 +110,83 @@ static const char *PredefinedNames[] =
 
 //==========================================================================
 //
-// FName :: NameManager :: FindName
+// HashName
 //
-// Returns the index of a name. If the name does not exist and noCreate is
-// true, then it returns false. If the name does not exist and noCreate is
-// false, then the name is added to the table and its new index is returned.
+// A case-insensitive hash that works on eight characters at a time.
+// Setting bit 5 of every byte folds upper case letters onto lower case
+// ones. It also folds a few pairs of punctuation characters together, but
+// that only means they share a hash; the names are still compared with
+// strnicmp.
 //
 //==========================================================================
 
-int FName::NameManager::FindName (const char *text, bool noCreate)
+static unsigned int HashName (const char *text, size_t len)
 {
-	if (!Inited)
+	const QWORD fold = UCONST64(0x2020202020202020);
+	const QWORD mult = UCONST64(0x9E3779B97F4A7C15);
+	QWORD hash = len * mult;
+	QWORD chunk;
+
+	for (; len >= 8; len -= 8, text += 8)
 	{
-		InitBuckets ();
+		memcpy (&chunk, text, 8);
+		hash = (((hash << 5) | (hash >> 59)) ^ (chunk | fold)) * mult;
 	}
-
-	if (text == NULL)
+	if (len > 0)
 	{
-		return 0;
+		chunk = 0;
+		memcpy (&chunk, text, len);
+		hash = (((hash << 5) | (hash >> 59)) ^ (chunk | fold)) * mult;
 	}
+	hash ^= hash >> 29;
+	hash *= mult;
+	return (unsigned int)(hash >> 32);
+}
 
-	unsigned int hash = MakeKey (text);
-	unsigned int bucket = hash % HASH_SIZE;
-	int scanner = Buckets[bucket];
+//==========================================================================
+//
+// FName :: NameManager :: NameTable :: Find
+//
+// Returns the index of a name in this table or -1 if it is not there.
+// Safe to call without holding the lock.
+//
+//==========================================================================
+
+int FName::NameManager::NameTable::Find (const char *text, size_t textLen, unsigned int hash) const
+{
+	int scanner = Buckets[hash & Mask].load (std::memory_order_acquire);
 
-	// See if the name already exists.
 	while (scanner >= 0)
 	{
-		if (NameArray[scanner].Hash == hash && stricmp (NameArray[scanner].Text, text) == 0)
+		const NameEntry &entry = Names[scanner];
+		if (entry.Hash == hash &&
+			strnicmp (entry.Text, text, textLen) == 0 &&
+			entry.Text[textLen] == '\0')
 		{
 			return scanner;
 		}
-		scanner = NameArray[scanner].NextHash;
+		scanner = Next[scanner];
 	}
+	return -1;
+}
 
-	// If we get here, then the name does not exist.
-	if (noCreate)
+//==========================================================================
+//
+// FName :: NameManager :: FindName
+//
+// Returns the index of a name. If the name does not exist and noCreate is
+// true, then it returns false. If the name does not exist and noCreate is
+// false, then the name is added to the table and its new index is returned.
+//
+//==========================================================================
+
+int FName::NameManager::FindName (const char *text, bool noCreate)
+{
+	if (text == NULL)
 	{
 		return 0;
 	}
-
-	return AddName (text, hash, bucket);
+	return FindName (text, strlen (text), noCreate);
 }
 
 //==========================================================================
@@ -132,39 +198,49 @@ int FName::NameManager::FindName (const char *text, bool noCreate)
 
 int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreate)
 {
-	if (!Inited)
-	{
-		InitBuckets ();
-	}
-
 	if (text == NULL)
 	{
 		return 0;
 	}
 
-	unsigned int hash = MakeKey (text, textLen);
-	unsigned int bucket = hash % HASH_SIZE;
-	int scanner = Buckets[bucket];
+	unsigned int hash = HashName (text, textLen);
+	NameTable *table = NameTable::Current.load (std::memory_order_acquire);
 
 	// See if the name already exists.
-	while (scanner >= 0)
+	if (table != NULL)
 	{
-		if (NameArray[scanner].Hash == hash &&
-			strnicmp (NameArray[scanner].Text, text, textLen) == 0 &&
-			NameArray[scanner].Text[textLen] == '\0')
+		int index = table->Find (text, textLen, hash);
+		if (index >= 0)
 		{
-			return scanner;
+			return index;
+		}
+		if (noCreate)
+		{
+			return 0;
 		}
-		scanner = NameArray[scanner].NextHash;
 	}
 
-	// If we get here, then the name does not exist.
+	// If we get here, then the name did not exist or the table has not been
+	// set up yet. Another thread may have added it in the meantime, so look
+	// again once we have the lock.
+	std::lock_guard<std::mutex> lock (NameTable::Lock);
+
+	table = NameTable::Current.load (std::memory_order_relaxed);
+	if (table == NULL)
+	{
+		table = InitBuckets ();
+	}
+
+	int index = table->Find (text, textLen, hash);
+	if (index >= 0)
+	{
+		return index;
+	}
 	if (noCreate)
 	{
 		return 0;
 	}
-
-	return AddName (text, hash, bucket);
+	return AddName (text, textLen, hash);
 }
 
 //==========================================================================
@@ -172,34 +248,96 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 // FName :: NameManager :: InitBuckets
 //
 // Sets up the hash table and inserts all the default names into the table.
+// The caller must hold the lock.
 //
 //==========================================================================
 
-void FName::NameManager::InitBuckets ()
+FName::NameManager::NameTable *FName::NameManager::InitBuckets ()
 {
-	Inited = true;
-	memset (Buckets, -1, sizeof(Buckets));
+	NameTable *table = GrowTable (NULL);
 
 	// Register built-in names. 'None' must be name 0.
 	for (size_t i = 0; i < countof(PredefinedNames); ++i)
 	{
-		FindName (PredefinedNames[i], false);
+		size_t len = strlen (PredefinedNames[i]);
+		unsigned int hash = HashName (PredefinedNames[i], len);
+
+		if (table->Find (PredefinedNames[i], len, hash) < 0)
+		{
+			AddName (PredefinedNames[i], len, hash);
+		}
 	}
+	return NameTable::Current.load (std::memory_order_relaxed);
+}
+
+//==========================================================================
+//
+// FName :: NameManager :: GrowTable
+//
+// Replaces the current table with one twice as large (or creates the first
+// one). The old table is left intact for anyone who is still reading it.
+// The caller must hold the lock.
+//
+//==========================================================================
+
+FName::NameManager::NameTable *FName::NameManager::GrowTable (NameTable *table)
+{
+	NameTable *newtable = new NameTable;
+	int capacity;
+
+	if (table != NULL)
+	{
+		capacity = table->Capacity * 2;
+	}
+	else
+	{
+		// If no names have been defined yet, make the first allocation
+		// large enough to hold all the predefined names.
+		for (capacity = 1; capacity < int(countof(PredefinedNames) + NAME_GROW_AMOUNT); capacity <<= 1)
+		{ }
+	}
+
+	// This may run on any thread, so stay away from M_Malloc's bookkeeping.
+	newtable->Names = (NameEntry *)malloc (capacity * sizeof(NameEntry));
+	newtable->Next = (int *)malloc (capacity * sizeof(int));
+	newtable->Buckets = new std::atomic<int>[capacity];
+	newtable->Mask = capacity - 1;
+	newtable->Capacity = capacity;
+	newtable->Prev = table;
+
+	for (int i = 0; i < capacity; ++i)
+	{
+		newtable->Buckets[i].store (-1, std::memory_order_relaxed);
+	}
+	int numnames = NumNames.load (std::memory_order_relaxed);
+	for (int i = 0; i < numnames; ++i)
+	{
+		unsigned int bucket = table->Names[i].Hash & newtable->Mask;
+
+		newtable->Names[i] = table->Names[i];
+		newtable->Next[i] = newtable->Buckets[bucket].load (std::memory_order_relaxed);
+		newtable->Buckets[bucket].store (i, std::memory_order_relaxed);
+	}
+
+	NameArray.store (newtable->Names, std::memory_order_release);
+	MaxNames = capacity;
+	NameTable::Current.store (newtable, std::memory_order_release);
+	return newtable;
 }
 
 //==========================================================================
 //
 // FName :: NameManager :: AddName
 //
-// Adds a new name to the name table.
+// Adds a new name to the name table. The caller must hold the lock.
 //
 //==========================================================================
 
-int FName::NameManager::AddName (const char *text, unsigned int hash, unsigned int bucket)
+int FName::NameManager::AddName (const char *text, size_t textLen, unsigned int hash)
 {
 	char *textstore;
 	NameBlock *block = Blocks;
-	size_t len = strlen (text) + 1;
+	size_t len = textLen + 1;
 
 	// Get a block large enough for the name. Only the first block in the
 	// list is ever considered for name storage.
@@ -210,25 +348,28 @@ int FName::NameManager::AddName (const char *text, unsigned int hash, unsigned i
 
 	// Copy the string into the block.
 	textstore = (char *)block + block->NextAlloc;
-	strcpy (textstore, text);
+	memcpy (textstore, text, textLen);
+	textstore[textLen] = '\0';
 	block->NextAlloc += len;
 
 	// Add an entry for the name to the NameArray
-	if (NumNames >= MaxNames)
+	NameTable *table = NameTable::Current.load (std::memory_order_relaxed);
+	int index = NumNames.load (std::memory_order_relaxed);
+	if (index >= table->Capacity)
 	{
-		// If no names have been defined yet, make the first allocation
-		// large enough to hold all the predefined names.
-		MaxNames += MaxNames == 0 ? countof(PredefinedNames) + NAME_GROW_AMOUNT : NAME_GROW_AMOUNT;
-
-		NameArray = (NameEntry *)M_Realloc (NameArray, MaxNames * sizeof(NameEntry));
+		table = GrowTable (table);
 	}
 
-	NameArray[NumNames].Text = textstore;
-	NameArray[NumNames].Hash = hash;
-	NameArray[NumNames].NextHash = Buckets[bucket];
-	Buckets[bucket] = NumNames;
+	unsigned int bucket = hash & table->Mask;
+
+	table->Names[index].Text = textstore;
+	table->Names[index].Hash = hash;
+	table->Next[index] = table->Buckets[bucket].load (std::memory_order_relaxed);
+	NumNames.store (index + 1, std::memory_order_release);
 
-	return NumNames++;
+	// Readers can see the new name from here on.
+	table->Buckets[bucket].store (index, std::memory_order_release);
+	return index;
 }
 
 //==========================================================================
@@ -249,7 +390,7 @@ FName::NameManager::NameBlock *FName::NameManager::AddBlock (size_t len)
 	{
 		len = BLOCK_SIZE;
 	}
-	block = (NameBlock *)M_Malloc (len);
+	block = (NameBlock *)malloc (len);
 	block->NextAlloc = sizeof(NameBlock);
 	block->NextBlock = Blocks;
 	Blocks = block;
@@ -267,23 +408,28 @@ FName::NameManager::NameBlock *FName::NameManager::AddBlock (size_t len)
 FName::NameManager::~NameManager()
 {
 	NameBlock *block, *next;
+	NameTable *table, *prev;
 
 	C_ClearTabCommands();
 
 	for (block = Blocks; block != NULL; block = next)
 	{
 		next = block->NextBlock;
-		M_Free (block);
+		free (block);
 	}
 	Blocks = NULL;
 
-	if (NameArray != NULL)
+	for (table = NameTable::Current.exchange (NULL); table != NULL; table = prev)
 	{
-		M_Free (NameArray);
-		NameArray = NULL;
+		prev = table->Prev;
+		free (table->Names);
+		free (table->Next);
+		delete[] table->Buckets;
+		delete table;
 	}
-	NumNames = MaxNames = 0;
-	memset (Buckets, -1, sizeof(Buckets));
+	NameArray.store (NULL);
+	NumNames.store (0);
+	MaxNames = 0;
 }
 
 //==========================================================================
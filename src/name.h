@@ -34,6 +34,8 @@
 #ifndef NAME_H
 #define NAME_H
 
+#include <atomic>
+
 enum ENamedName
 {
 #define xx(n) NAME_##n,
@@ -58,8 +60,8 @@ public:
 
 	int GetIndex() const { return Index; }
 	operator int() const { return Index; }
-	const char *GetChars() const { return NameData.NameArray[Index].Text; }
-	operator const char *() const { return NameData.NameArray[Index].Text; }
+	const char *GetChars() const { return NameData.NameArray.load(std::memory_order_acquire)[Index].Text; }
+	operator const char *() const { return NameData.NameArray.load(std::memory_order_acquire)[Index].Text; }
 
 	FName &operator = (const char *text) { Index = NameData.FindName (text, false); return *this; }
 	FName &operator = (const FString &text);
@@ -68,7 +70,7 @@ public:
 
 	int SetName (const char *text, bool noCreate=false) { return Index = NameData.FindName (text, noCreate); }
 
-	bool IsValidName() const { return (unsigned)Index < (unsigned)NameData.NumNames; }
+	bool IsValidName() const { return (unsigned)Index < (unsigned)NameData.NumNames.load(std::memory_order_acquire); }
 
 	// Note that the comparison operators compare the names' indices, not
 	// their text, so they cannot be used to do a lexicographical sort.
@@ -96,7 +98,6 @@ protected:
 	{
 		char *Text;
 		unsigned int Hash;
-		int NextHash;
 	};
 
 	struct NameManager
@@ -106,20 +107,25 @@ protected:
 		// means this struct must only exist in the program's BSS section.
 		~NameManager();
 
-		enum { HASH_SIZE = 1024 };
 		struct NameBlock;
+		struct NameTable;
 
+		// FindName may be called from any thread. NameArray is only ever
+		// replaced by a larger copy, and the old copies stay valid until
+		// shutdown, so reading a name's text never needs a lock either.
+		// NameArray and NumNames are only written with the lock held, and
+		// with release semantics, so they must be read with acquire.
 		NameBlock *Blocks;
-		NameEntry *NameArray;
-		int NumNames, MaxNames;
-		int Buckets[HASH_SIZE];
+		std::atomic<NameEntry *> NameArray;
+		std::atomic<int> NumNames;
+		int MaxNames;
 
 		int FindName (const char *text, bool noCreate);
 		int FindName (const char *text, size_t textlen, bool noCreate);
-		int AddName (const char *text, unsigned int hash, unsigned int bucket);
+		int AddName (const char *text, size_t textlen, unsigned int hash);
 		NameBlock *AddBlock (size_t len);
-		void InitBuckets ();
-		static bool Inited;
+		NameTable *GrowTable (NameTable *table);
+		NameTable *InitBuckets ();
 	};
 
 	static NameManager NameData;
@@ -90,6 +90,7 @@
 #include "d_netinf.h"
 
 #include "md5.h"
+#include "network/checksumcache.h"
 #include "network/sv_auth.h"
 #include "doomerrors.h"
 
@@ -1221,6 +1222,12 @@ void network_CheckIfDuplicateLump( const int LumpNum )
 FString NETWORK_MapCollectionChecksum( )
 {
 	FString longSum, fullSum;
+
+	// Opening every map is slow, so reuse the result if the loaded files didn't change.
+	const FString cacheKey = CHECKSUMCACHE_MakeMapCollectionKey( );
+	if ( CHECKSUMCACHE_FindMapCollectionChecksum( cacheKey, fullSum ))
+		return fullSum;
+
 	for( unsigned i = 0; i < wadlevelinfos.Size( ); i++ )
 	{
 		char* mname = wadlevelinfos[i].mapname;
@@ -1245,6 +1252,7 @@ FString NETWORK_MapCollectionChecksum( )
 
 	CMD5Checksum::GetMD5( reinterpret_cast<const BYTE *>( longSum.GetChars( ) ),
 		longSum.Len( ), fullSum );
+	CHECKSUMCACHE_StoreMapCollectionChecksum( cacheKey, fullSum );
 	return fullSum;
 }
 
@@ -1597,6 +1605,7 @@ static void network_InitPWADList( void )
 	g_IWAD = Wads.GetWadName( ulRealIWADIdx );
 
 	// Collect all the PWADs into a list.
+	TArray<FString> filenames;
 	for ( ULONG ulIdx = 0; Wads.GetWadName( ulIdx ) != NULL; ulIdx++ )
 	{
 		// Skip the IWAD, zandronum.pk3, files that were automatically loaded from subdirectories (such as skin files), and WADs loaded automatically within pk3 files.
@@ -1607,15 +1616,20 @@ static void network_InitPWADList( void )
 		{
 			continue;
 		}
-		char MD5Sum[33];
-		MD5SumOfFile ( Wads.GetWadFullName( ulIdx ), MD5Sum );
 
 		NetworkPWAD pwad;
 		pwad.name = Wads.GetWadName( ulIdx );
-		pwad.checksum = MD5Sum;
 		pwad.wadnum = ulIdx;
 		g_PWADs.Push( pwad );
+		filenames.Push( Wads.GetWadFullName( ulIdx ));
 	}
+
+	// The checksums are computed in parallel and cached on disk.
+	TArray<FString> checksums;
+	CHECKSUMCACHE_MD5SumOfFiles( filenames, checksums );
+
+	for ( unsigned int i = 0; i < g_PWADs.Size(); i++ )
+		g_PWADs[i].checksum = checksums[i];
 }
 
 void network_Error( const char *pszError )
@@ -0,0 +1,392 @@
+//-----------------------------------------------------------------------------
+//
+// Zandronum Source
+// Copyright (C) 2026 Zandronum Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Filename: checksumcache.cpp
+//
+// Description: Caches the MD5 sums of loaded files and the map collection
+// checksum on disk, so that they don't need to be recomputed on every start.
+//
+//-----------------------------------------------------------------------------
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "checksumcache.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "cmdlib.h"
+#include "doomtype.h"
+#include "g_level.h"
+#include "m_misc.h"
+#include "md5.h"
+#include "p_setup.h"
+#include "v_text.h"
+#include "version.h"
+#include "w_wad.h"
+#include "workerpool.h"
+#include "../network.h"
+
+//*****************************************************************************
+//	DEFINES
+
+#define	CHECKSUMCACHE_FILENAME		GAMENAMELOWERCASE "-checksums.txt"
+#define	CHECKSUMCACHE_HEADER		"# " GAMENAME " checksum cache v1"
+
+// Only the most recent map collections are worth remembering.
+#define	MAX_CACHED_MAP_COLLECTIONS	8
+
+struct CachedFileChecksum
+{
+	QWORD		Size;
+	QWORD		ModificationTime;
+	FString		Checksum;
+};
+
+struct CachedMapCollection
+{
+	FString		Key;
+	FString		Checksum;
+};
+
+// Plain data that the worker threads fill in. FString isn't thread-safe.
+struct FileChecksumJob
+{
+	const char	*Filename;
+	char		Checksum[33];
+	bool		bSuccess;
+};
+
+//*****************************************************************************
+//	VARIABLES
+
+static	TMap<FString, CachedFileChecksum>	g_CachedFiles;
+static	TArray<CachedMapCollection>			g_CachedMapCollections;
+static	bool								g_bCacheLoaded = false;
+
+//*****************************************************************************
+//	CONSOLE VARIABLES
+
+// 0: Don't use the cache, 1: Use the cache, 2: Recompute everything and warn
+// if the result doesn't match the cache.
+CVAR( Int, checksumcache, 1, CVAR_ARCHIVE|CVAR_GLOBALCONFIG )
+
+//*****************************************************************************
+//	FUNCTIONS
+
+static FString checksumcache_GetPath( bool bCreate )
+{
+	FString path = M_GetCachePath( bCreate );
+	path << '/' << CHECKSUMCACHE_FILENAME;
+	return path;
+}
+
+//*****************************************************************************
+//
+static bool checksumcache_StatFile( const char *Filename, QWORD &Size, QWORD &ModificationTime )
+{
+	struct stat info;
+
+	if ( stat( Filename, &info ) != 0 )
+		return false;
+
+	Size = info.st_size;
+	ModificationTime = info.st_mtime;
+	return true;
+}
+
+//*****************************************************************************
+//
+static void checksumcache_Load( void )
+{
+	if ( g_bCacheLoaded )
+		return;
+
+	g_bCacheLoaded = true;
+
+	FILE *file = fopen( checksumcache_GetPath( false ), "r" );
+	if ( file == NULL )
+		return;
+
+	char line[1024];
+	while ( fgets( line, sizeof( line ), file ) != NULL )
+	{
+		size_t len = strlen( line );
+		while (( len > 0 ) && (( line[len - 1] == '\n' ) || ( line[len - 1] == '\r' )))
+			line[--len] = '\0';
+
+		unsigned long long size, modificationTime;
+		char checksum[33], key[33];
+		int consumed = 0;
+
+		// File entries: F <size> <mtime> <md5> <path>
+		if ( sscanf( line, "F %llu %llu %32s %n", &size, &modificationTime, checksum, &consumed ) == 3 )
+		{
+			if (( consumed == 0 ) || ( line[consumed] == '\0' ) || ( strlen( checksum ) != 32 ))
+				continue;
+
+			CachedFileChecksum &entry = g_CachedFiles[line + consumed];
+			entry.Size = size;
+			entry.ModificationTime = modificationTime;
+			entry.Checksum = checksum;
+		}
+		// Map collection entries: M <key> <checksum>
+		else if ( sscanf( line, "M %32s %32s", key, checksum ) == 2 )
+		{
+			if ( g_CachedMapCollections.Size( ) >= MAX_CACHED_MAP_COLLECTIONS )
+				continue;
+
+			CachedMapCollection entry;
+			entry.Key = key;
+			entry.Checksum = checksum;
+			g_CachedMapCollections.Push( entry );
+		}
+	}
+
+	fclose( file );
+}
+
+//*****************************************************************************
+//
+static void checksumcache_Save( void )
+{
+	FString contents;
+	contents.Format( "%s\n", CHECKSUMCACHE_HEADER );
+
+	TMap<FString, CachedFileChecksum>::Iterator it( g_CachedFiles );
+	TMap<FString, CachedFileChecksum>::Pair *pair;
+	while ( it.NextPair( pair ))
+	{
+		contents.AppendFormat( "F %llu %llu %s %s\n", static_cast<unsigned long long>( pair->Value.Size ),
+			static_cast<unsigned long long>( pair->Value.ModificationTime ),
+			pair->Value.Checksum.GetChars( ), pair->Key.GetChars( ));
+	}
+
+	for ( unsigned int i = 0; i < g_CachedMapCollections.Size( ); i++ )
+		contents.AppendFormat( "M %s %s\n", g_CachedMapCollections[i].Key.GetChars( ), g_CachedMapCollections[i].Checksum.GetChars( ));
+
+	// Several servers may share the cache directory, so never leave a half written file behind.
+	P_WriteCacheFile( checksumcache_GetPath( true ), reinterpret_cast<const BYTE *>( contents.GetChars( )), contents.Len( ));
+}
+
+//*****************************************************************************
+//
+void CHECKSUMCACHE_MD5SumOfFiles( const TArray<FString> &Filenames, TArray<FString> &Checksums )
+{
+	const bool bUseCache = ( checksumcache != 0 );
+	const bool bVerify = ( checksumcache == 2 );
+	bool bCacheChanged = false;
+
+	if ( bUseCache )
+		checksumcache_Load( );
+
+	Checksums.Clear( );
+	Checksums.Resize( Filenames.Size( ));
+
+	TArray<FileChecksumJob> jobs;
+	TArray<unsigned int> jobIndices;
+	TArray<QWORD> sizes, modificationTimes;
+	sizes.Resize( Filenames.Size( ));
+	modificationTimes.Resize( Filenames.Size( ));
+
+	for ( unsigned int i = 0; i < Filenames.Size( ); i++ )
+	{
+		const bool bStatOK = checksumcache_StatFile( Filenames[i], sizes[i], modificationTimes[i] );
+
+		if ( bUseCache && bStatOK && ( bVerify == false ))
+		{
+			const CachedFileChecksum *entry = g_CachedFiles.CheckKey( Filenames[i] );
+			if (( entry != NULL ) && ( entry->Size == sizes[i] ) && ( entry->ModificationTime == modificationTimes[i] ))
+			{
+				Checksums[i] = entry->Checksum;
+				continue;
+			}
+		}
+
+		FileChecksumJob job;
+		job.Filename = Filenames[i].GetChars( );
+		job.Checksum[0] = '\0';
+		job.bSuccess = false;
+		jobs.Push( job );
+		jobIndices.Push( i );
+	}
+
+	// Hashing is bound by disk and memory bandwidth, so every file gets its own task.
+	WorkerPool.ParallelFor( jobs.Size( ), [&jobs]( unsigned int i )
+	{
+		jobs[i].bSuccess = MD5SumOfFile( jobs[i].Filename, jobs[i].Checksum, false );
+	});
+
+	for ( unsigned int i = 0; i < jobs.Size( ); i++ )
+	{
+		const unsigned int index = jobIndices[i];
+
+		if ( jobs[i].bSuccess == false )
+		{
+			Printf( "%s: Couldn't compute the MD5 sum.\n", Filenames[index].GetChars( ));
+			continue;
+		}
+
+		Checksums[index] = jobs[i].Checksum;
+
+		if ( bUseCache == false )
+			continue;
+
+		CachedFileChecksum *entry = g_CachedFiles.CheckKey( Filenames[index] );
+		if ( bVerify && ( entry != NULL ) && ( entry->Size == sizes[index] )
+			&& ( entry->ModificationTime == modificationTimes[index] ) && ( entry->Checksum.CompareNoCase( Checksums[index] ) != 0 ))
+		{
+			Printf( TEXTCOLOR_YELLOW "%s: Cached MD5 sum %s doesn't match the actual sum %s.\n", Filenames[index].GetChars( ),
+				entry->Checksum.GetChars( ), Checksums[index].GetChars( ));
+		}
+
+		CachedFileChecksum &newEntry = g_CachedFiles[Filenames[index]];
+		newEntry.Size = sizes[index];
+		newEntry.ModificationTime = modificationTimes[index];
+		newEntry.Checksum = Checksums[index];
+		bCacheChanged = true;
+	}
+
+	if ( bCacheChanged )
+		checksumcache_Save( );
+}
+
+//*****************************************************************************
+//
+FString CHECKSUMCACHE_MakeMapCollectionKey( void )
+{
+	FString description;
+
+	// The maps can come from any loaded file, including the IWAD and
+	// automatically loaded ones, so all of them are part of the key.
+	for ( int i = 0; i < Wads.GetNumWads( ); i++ )
+	{
+		QWORD size = 0, modificationTime = 0;
+		checksumcache_StatFile( Wads.GetWadFullName( i ), size, modificationTime );
+		description.AppendFormat( "%s:%llu:%llu\n", Wads.GetWadFullName( i ),
+			static_cast<unsigned long long>( size ), static_cast<unsigned long long>( modificationTime ));
+	}
+
+	for ( unsigned int i = 0; i < wadlevelinfos.Size( ); i++ )
+		description.AppendFormat( "%s\n", wadlevelinfos[i].mapname );
+
+	FString key;
+	CMD5Checksum::GetMD5( reinterpret_cast<const BYTE *>( description.GetChars( )), description.Len( ), key );
+	return key;
+}
+
+//*****************************************************************************
+//
+bool CHECKSUMCACHE_FindMapCollectionChecksum( const FString &Key, FString &Checksum )
+{
+	// In verify mode the checksum is always recomputed and compared on store.
+	if (( checksumcache == 0 ) || ( checksumcache == 2 ))
+		return false;
+
+	checksumcache_Load( );
+
+	for ( unsigned int i = 0; i < g_CachedMapCollections.Size( ); i++ )
+	{
+		if ( g_CachedMapCollections[i].Key.CompareNoCase( Key ) == 0 )
+		{
+			Checksum = g_CachedMapCollections[i].Checksum;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//*****************************************************************************
+//
+void CHECKSUMCACHE_StoreMapCollectionChecksum( const FString &Key, const FString &Checksum )
+{
+	if ( checksumcache == 0 )
+		return;
+
+	checksumcache_Load( );
+
+	unsigned int index = g_CachedMapCollections.Size( );
+
+	for ( unsigned int i = 0; i < g_CachedMapCollections.Size( ); i++ )
+	{
+		if ( g_CachedMapCollections[i].Key.CompareNoCase( Key ) == 0 )
+		{
+			if ( g_CachedMapCollections[i].Checksum.CompareNoCase( Checksum ) != 0 )
+			{
+				Printf( TEXTCOLOR_YELLOW "Cached map collection checksum %s doesn't match the actual checksum %s.\n",
+					g_CachedMapCollections[i].Checksum.GetChars( ), Checksum.GetChars( ));
+			}
+
+			index = i;
+			break;
+		}
+	}
+
+	// A new collection takes a new slot, or the oldest one if the cache is full.
+	if ( index == g_CachedMapCollections.Size( ))
+	{
+		if ( index < MAX_CACHED_MAP_COLLECTIONS )
+			g_CachedMapCollections.Push( CachedMapCollection( ));
+		else
+			index--;
+	}
+
+	// Keep the most recent collection in front. The entries are moved by assignment,
+	// since TArray's Insert and Delete would memmove the FStrings.
+	for ( unsigned int i = index; i > 0; i-- )
+		g_CachedMapCollections[i] = g_CachedMapCollections[i - 1];
+
+	g_CachedMapCollections[0].Key = Key;
+	g_CachedMapCollections[0].Checksum = Checksum;
+
+	checksumcache_Save( );
+}
+
+//*****************************************************************************
+//	CONSOLE COMMANDS
+
+CCMD( clearchecksumcache )
+{
+	g_CachedFiles.Clear( );
+	g_CachedMapCollections.Clear( );
+	remove( checksumcache_GetPath( false ));
+}
@@ -51,11 +51,17 @@
 #include "m_bbox.h"
 #include "c_console.h"
 #include "r_state.h"
+#include "workerpool.h"
 
 const int MaxSegs = 64;
 const int SplitCost = 8;
 const int AAPreference = 16;
 
+// Sets where candidates * segs is below this are scored on the calling thread.
+const unsigned int ParallelScoreWork = 1 << 16;
+// Number of candidates each worker scores at a time.
+const unsigned int ScoreBatch = 8;
+
 #if 0
 #define D(x) x
 #else
@@ -463,10 +469,13 @@ int FNodeBuilder::SelectSplitter (DWORD set, node_t &node, DWORD &splitseg, int
 	bestvalue = 0;
 	bestseg = DWORD_MAX;
 
+	unsigned int setsize = 0;
+
 	seg = set;
 	stepleft = 0;
 
 	memset (&PlaneChecked[0], 0, PlaneChecked.Size());
+	Candidates.Clear ();
 
 	D(Printf (PRINT_LOG, "Processing set %d\n", set));
 
@@ -487,28 +496,35 @@ int FNodeBuilder::SelectSplitter (DWORD set, node_t &node, DWORD &splitseg, int
 				}
 
 				stepleft = step;
-				SetNodeFromSeg (node, pseg);
-
-				int value = Heuristic (node, set, nosplit);
-
-				D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
-					(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
-
-				if (value > bestvalue)
-				{
-					bestvalue = value;
-					bestseg = seg;
-				}
-				else if (value < 0)
-				{
-					nosplitters = true;
-				}
+				Candidates.Push (seg);
 			}
 		}
 
+		setsize++;
 		seg = pseg->next;
 	}
 
+	ScoreSplitters (set, setsize, nosplit);
+
+	// Pick the best one in the same order the candidates were found in, so
+	// ties are broken exactly as if they had been scored one after another.
+	for (unsigned int i = 0; i < Candidates.Size(); ++i)
+	{
+		int value = CandidateScores[i];
+
+		D(Printf (PRINT_LOG, "Seg %5d, ld %d scores %d\n", Candidates[i], Segs[Candidates[i]].linedef, value));
+
+		if (value > bestvalue)
+		{
+			bestvalue = value;
+			bestseg = Candidates[i];
+		}
+		else if (value < 0)
+		{
+			nosplitters = true;
+		}
+	}
+
 	if (bestseg == DWORD_MAX)
 	{ // No lines split any others into two sets, so this is a convex region.
 	D(Printf (PRINT_LOG, "set %d, step %d, nosplit %d has no good splitter (%d)\n", set, step, nosplit, nosplitters));
@@ -522,6 +538,44 @@ int FNodeBuilder::SelectSplitter (DWORD set, node_t &node, DWORD &splitseg, int
 	return 1;
 }
 
+// Scores every seg in Candidates as a splitter for the set. Heuristic() only
+// reads the segs and vertices, so big sets are scored on the worker threads,
+// each with its own scratch lists. The scores do not depend on the order they
+// are computed in, so the tree comes out the same either way.
+void FNodeBuilder::ScoreSplitters (DWORD set, unsigned int setsize, bool nosplit)
+{
+	unsigned int count = Candidates.Size();
+
+	CandidateScores.Resize (count);
+
+#ifndef BACKPATCH	// ClassifyLineBackpatch rewrites its caller on first use.
+	if (count > ScoreBatch && (QWORD)count * setsize >= ParallelScoreWork &&
+		WorkerPool.GetNumThreads() > 1)
+	{
+		WorkerPool.ParallelFor ((count + ScoreBatch - 1) / ScoreBatch, [&](unsigned int batch)
+		{
+			TArray<int> touched, colinear;
+			unsigned int end = MIN (count, (batch + 1) * ScoreBatch);
+			node_t node;
+
+			for (unsigned int i = batch * ScoreBatch; i < end; ++i)
+			{
+				SetNodeFromSeg (node, &Segs[Candidates[i]]);
+				CandidateScores[i] = Heuristic (node, set, nosplit, touched, colinear);
+			}
+		});
+		return;
+	}
+#endif
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		node_t node;
+		SetNodeFromSeg (node, &Segs[Candidates[i]]);
+		CandidateScores[i] = Heuristic (node, set, nosplit);
+	}
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
@@ -529,6 +583,11 @@ int FNodeBuilder::SelectSplitter (DWORD set, node_t &node, DWORD &splitseg, int
 // in the set.
 
 int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
+{
+	return Heuristic (node, set, honorNoSplit, Touched, Colinear);
+}
+
+int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
 	// Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
 	int score = 1000000;
@@ -543,8 +602,8 @@ int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
 	unsigned int max, m2, p, q;
 	double frac;
 
-	Touched.Clear ();
-	Colinear.Clear ();
+	touched.Clear ();
+	colinear.Clear ();
 
 	while (i != DWORD_MAX)
 	{
@@ -570,32 +629,32 @@ int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
 			{
 				if ((sidev[0] | sidev[1]) != 0)
 				{
-					max = Touched.Size();
+					max = touched.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Touched[p] == test->loopnum)
+						if (touched[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Touched.Push (test->loopnum);
+						touched.Push (test->loopnum);
 					}
 				}
 				else
 				{
-					max = Colinear.Size();
+					max = colinear.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Colinear[p] == test->loopnum)
+						if (colinear[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Colinear.Push (test->loopnum);
+						colinear.Push (test->loopnum);
 					}
 				}
 			}
@@ -712,8 +771,8 @@ int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
 	// seg of that sector must be crossing the container's corner and does not
 	// actually split the container.
 
-	max = Touched.Size ();
-	m2 = Colinear.Size ();
+	max = touched.Size ();
+	m2 = colinear.Size ();
 
 	// If honorNoSplit is false, then both these lists will be empty.
 
@@ -726,10 +785,10 @@ int FNodeBuilder::Heuristic (node_t &node, DWORD set, bool honorNoSplit)
 
 	for (p = 0; p < max; ++p)
 	{
-		int look = Touched[p];
+		int look = touched[p];
 		for (q = 0; q < m2; ++q)
 		{
-			if (look == Colinear[q])
+			if (look == colinear[q])
 			{
 				break;
 			}
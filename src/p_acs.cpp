@@ -2263,6 +2263,7 @@ FBehavior::FBehavior (int lumpnum, FileReader * fr, int len)
 	NumFunctions = 0;
 	NumArrays = 0;
 	NumTotalArrays = 0;
+	CVarCacheGeneration = 0;
 	Scripts = NULL;
 	Functions = NULL;
 	Arrays = NULL;
@@ -3258,6 +3259,52 @@ const char *FBehavior::StaticLookupString (DWORD index)
 	return StaticModules[lib]->LookupString (index & 0xffff);
 }
 
+//==========================================================================
+//
+// FBehavior :: StaticLookupCVar
+//
+// Returns the cvar named by a string. Strings from a module's string table
+// never change, so the cvars they name are cached until a cvar is created
+// or destroyed. Dynamic strings are looked up every time.
+//
+//==========================================================================
+
+FBaseCVar *FBehavior::StaticLookupCVar (DWORD index)
+{
+	DWORD lib = index >> LIBRARYID_SHIFT;
+
+	if (lib == STRPOOL_LIBRARYID || lib >= (DWORD)StaticModules.Size())
+	{
+		return FindCVar (StaticLookupString (index), NULL);
+	}
+	return StaticModules[lib]->LookupCVar (index & 0xffff);
+}
+
+FBaseCVar *FBehavior::LookupCVar (DWORD index)
+{
+	if (CVarCacheGeneration != CVarGeneration)
+	{
+		CVarCache.Clear ();
+		CVarCacheGeneration = CVarGeneration;
+	}
+	if (index >= CVarCache.Size())
+	{
+		unsigned int oldsize = CVarCache.Size();
+		CVarCache.Resize (index + 1);
+		for (unsigned int i = oldsize; i <= index; ++i)
+		{
+			CVarCache[i].Valid = false;
+		}
+	}
+	CVarCacheEntry &entry = CVarCache[index];
+	if (!entry.Valid)
+	{
+		entry.Var = FindCVar (LookupString (index), NULL);
+		entry.Valid = true;
+	}
+	return entry.Var;
+}
+
 const char *FBehavior::LookupString (DWORD index) const
 {
 	if (StringTable == 0)
@@ -5545,9 +5592,9 @@ static int GetUserCVar(int playernum, const char *cvarname, bool is_string)
 	return DoGetCVar(cvar, is_string);
 }
 
-static int GetCVar(AActor *activator, const char *cvarname, bool is_string)
+static int GetCVar(AActor *activator, DWORD cvarindex, bool is_string)
 {
-	FBaseCVar *cvar = FindCVar(cvarname, NULL);
+	FBaseCVar *cvar = FBehavior::StaticLookupCVar(cvarindex);
 	// Either the cvar doesn't exist, or it's for a mod that isn't loaded, so return 0.
 	if (cvar == NULL || (cvar->GetFlags() & CVAR_IGNORE))
 	{
@@ -5563,11 +5610,11 @@ static int GetCVar(AActor *activator, const char *cvarname, bool is_string)
 				// [BB] Compatibility with Zandronum 2.x: In CLIENTSIDE scripts,
 				// return the value belonging to the consoleplayer
 				if ( NETWORK_InClientMode() ) 
-					return GetUserCVar(consoleplayer, cvarname, is_string);
+					return GetUserCVar(consoleplayer, cvar->GetName(), is_string);
 
 				return 0;
 			}
-			return GetUserCVar(int(activator->player - players), cvarname, is_string);
+			return GetUserCVar(int(activator->player - players), cvar->GetName(), is_string);
 		}
 		return DoGetCVar(cvar, is_string);
 	}
@@ -5603,9 +5650,9 @@ static int SetUserCVar(int playernum, const char *cvarname, int value, bool is_s
 	return 1;
 }
 
-static int SetCVar(AActor *activator, const char *cvarname, int value, bool is_string)
+static int SetCVar(AActor *activator, DWORD cvarindex, int value, bool is_string)
 {
-	FBaseCVar *cvar = FindCVar(cvarname, NULL);
+	FBaseCVar *cvar = FBehavior::StaticLookupCVar(cvarindex);
 	// Only mod-created cvars may be set.
 	if (cvar == NULL || (cvar->GetFlags() & (CVAR_IGNORE|CVAR_NOSET)) || !(cvar->GetFlags() & CVAR_MOD))
 	{
@@ -5618,7 +5665,7 @@ static int SetCVar(AActor *activator, const char *cvarname, int value, bool is_s
 		{
 			return 0;
 		}
-		return SetUserCVar(int(activator->player - players), cvarname, value, is_string);
+		return SetUserCVar(int(activator->player - players), cvar->GetName(), value, is_string);
 	}
 	DoSetCVar(cvar, value, is_string);
 	return 1;
@@ -6201,21 +6248,21 @@ int DLevelScript::CallFunction(int argCount, int funcIndex, SDWORD *args)
 		case ACSF_GetCVarString:
 			if (argCount == 1)
 			{
-				return GetCVar(activator, FBehavior::StaticLookupString(args[0]), true);
+				return GetCVar(activator, args[0], true);
 			}
 			break;
 
 		case ACSF_SetCVar:
 			if (argCount == 2)
 			{
-				return SetCVar(activator, FBehavior::StaticLookupString(args[0]), args[1], false);
+				return SetCVar(activator, args[0], args[1], false);
 			}
 			break;
 
 		case ACSF_SetCVarString:
 			if (argCount == 2)
 			{
-				return SetCVar(activator, FBehavior::StaticLookupString(args[0]), args[1], true);
+				return SetCVar(activator, args[0], args[1], true);
 			}
 			break;
 
@@ -10290,6 +10337,7 @@ scriptwait:
 						lines[line].flags |= ML_BLOCK_PLAYERS;
 						break;
 					}
+					P_InvalidateSightCache ();
 
 					// If we're the server, tell clients to update this line.
 					if ( NETWORK_GetState( ) == NETSTATE_SERVER )
@@ -11320,7 +11368,7 @@ scriptwait:
 			break;
 
 		case PCD_GETCVAR:
-			STACK(1) = GetCVar(activator, FBehavior::StaticLookupString(STACK(1)), false);
+			STACK(1) = GetCVar(activator, STACK(1), false);
 			break;
 
 		case PCD_SETHUDSIZE:
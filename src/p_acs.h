@@ -50,6 +50,7 @@
 
 class FFont;
 class FileReader;
+class FBaseCVar;
 
 
 enum
@@ -483,6 +484,7 @@ public:
 	ACSProfileInfo *GetFunctionProfileData(int index) { return index >= 0 && index < NumFunctions ? &FunctionProfileData[index] : NULL; }
 	ACSProfileInfo *GetFunctionProfileData(ScriptFunction *func) { return GetFunctionProfileData((int)(func - (ScriptFunction *)Functions)); }
 	const char *LookupString (DWORD index) const;
+	FBaseCVar *LookupCVar (DWORD index);
 
 	BoundsCheckingArray<SDWORD *, NUM_MAPVARS> MapVars;
 
@@ -498,6 +500,7 @@ public:
 
 	static const ScriptPtr *StaticFindScript (int script, FBehavior *&module);
 	static const char *StaticLookupString (DWORD index);
+	static FBaseCVar *StaticLookupCVar (DWORD index);
 	static void StaticStartTypedScripts (WORD type, AActor *activator, bool always, int arg1=0, bool runNow=false, bool onlyClientSideScripts=false, int arg2=0, int arg3=0); // [BB] Added arg2+arg3
 	static void StaticStopMyScripts (AActor *actor);
 	static int StaticCountTypedScripts( WORD type );
@@ -531,6 +534,15 @@ private:
 	char ModuleName[9];
 	TArray<int> JumpPoints;
 
+	// Cvars looked up by the strings that name them.
+	struct CVarCacheEntry
+	{
+		FBaseCVar *Var;
+		bool Valid;
+	};
+	TArray<CVarCacheEntry> CVarCache;
+	unsigned int CVarCacheGeneration;
+
 	static TArray<FBehavior *> StaticModules;
 
 	void LoadScriptsDirectory ();
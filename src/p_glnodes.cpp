@@ -40,8 +40,10 @@
 
 #else
 #include <direct.h>
+#include <process.h>
 
 #define rmdir _rmdir
+#define getpid _getpid
 
 #endif
 
@@ -65,6 +67,7 @@
 #include "version.h"
 #include "md5.h"
 #include "m_misc.h"
+#include "m_crc32.h"
 // [BB] New #includes.
 #include "network.h"
 
@@ -1012,8 +1015,9 @@ bool P_CheckNodes(MapData * map, bool rebuilt, int buildtime)
 	// Building nodes in debug is much slower so let's cache them only if cachetime is 0
 	buildtime = 0;
 #endif
-	// [BB] Reportedly, the server can crash in case "gl_cachenodes true".
-	if ( ( NETWORK_GetState( ) != NETSTATE_SERVER ) && gl_cachenodes && buildtime/1000.f >= gl_cachetime)
+	// The cache is written atomically and verified on load, so servers
+	// can use it too, even if several of them share one cache directory.
+	if (gl_cachenodes && buildtime/1000.f >= gl_cachetime)
 	{
 		DPrintf("Caching nodes\n");
 		CreateCachedNodes(map);
@@ -1042,8 +1046,15 @@ bool P_CheckNodes(MapData * map, bool rebuilt, int buildtime)
 
 typedef TArray<BYTE> MemFile;
 
+// A cache file consists of the magic, the number of lines, the map's MD5,
+// a CRC32 of everything that follows it, the vertex indices of every line
+// and finally the nodes in compressed ZGL2 format.
+#define CACHE_MAGIC		"CAC2"
+#define CACHE_CRCPOS	24
+#define CACHE_HEADER	(CACHE_CRCPOS + 4)
 
-static FString CreateCacheName(MapData *map, bool create)
+
+FString P_GetCacheName(MapData *map, const char *ext, bool create)
 {
 	FString path = M_GetCachePath(create);
 	FString lumpname = Wads.GetLumpFullPath(map->lumpnum);
@@ -1052,10 +1063,73 @@ static FString CreateCacheName(MapData *map, bool create)
 	if (create) CreatePath(path);
 
 	lumpname.ReplaceChars('/', '%');
-	path << '/' << lumpname.Right(lumpname.Len() - separator - 1) << ".gzc";
+	path << '/' << lumpname.Right(lumpname.Len() - separator - 1) << ext;
 	return path;
 }
 
+//==========================================================================
+//
+// Reads a whole cache file into memory
+//
+//==========================================================================
+
+bool P_ReadCacheFile(const char *path, TArray<BYTE> &data)
+{
+	long size;
+
+	data.Clear();
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) return false;
+
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0)
+	{
+		data.Resize(size);
+		if (fread(&data[0], 1, size, f) != size_t(size))
+		{
+			data.Clear();
+		}
+	}
+	fclose(f);
+	return data.Size() > 0;
+}
+
+//==========================================================================
+//
+// Writes a cache file to a temporary name first and moves it into place
+// once it is complete, so that nobody ever sees a partially written file,
+// even if several processes share the cache directory.
+//
+//==========================================================================
+
+bool P_WriteCacheFile(const char *path, const BYTE *data, size_t len)
+{
+	static unsigned int counter;
+	FString temppath;
+
+	// The temporary name must be unique to this process, or two servers
+	// building the same map would write into each other's file.
+	temppath.Format("%s.%d-%u.tmp", path, int(getpid()), counter++);
+
+	FILE *f = fopen(temppath, "wb");
+	if (f == NULL) return false;
+
+	bool ok = fwrite(data, 1, len, f) == len;
+	if (fclose(f) == 0 && ok)
+	{
+#ifdef _WIN32
+		// rename() does not replace existing files on Windows.
+		remove(path);
+#endif
+		ok = rename(temppath, path) == 0;
+	}
+	if (!ok)
+	{
+		DPrintf("Could not write cache file %s\n", path);
+		remove(temppath);
+	}
+	return ok;
+}
+
 static void WriteByte(MemFile &f, BYTE b)
 {
 	f.Push(b);
@@ -1144,7 +1218,7 @@ static void CreateCachedNodes(MapData *map)
 
 	uLongf outlen = ZNodes.Size();
 	BYTE *compressed;
-	int offset = numlines * 8 + 12 + 16;
+	int offset = numlines * 8 + CACHE_HEADER + 4;
 	int r;
 	do
 	{
@@ -1158,61 +1232,63 @@ static void CreateCachedNodes(MapData *map)
 	} 
 	while (r == Z_BUF_ERROR);
 
-	memcpy(compressed, "CACH", 4);
+	memcpy(compressed, CACHE_MAGIC, 4);
 	DWORD len = LittleLong(numlines);
 	memcpy(compressed+4, &len, 4);
 	map->GetChecksum(compressed+8);
 	for(int i=0;i<numlines;i++)
 	{
 		DWORD ndx[2] = {LittleLong(DWORD(lines[i].v1 - vertexes)), LittleLong(DWORD(lines[i].v2 - vertexes)) };
-		memcpy(compressed+8+16+8*i, ndx, 8);
+		memcpy(compressed+CACHE_HEADER+8*i, ndx, 8);
 	}
 	memcpy(compressed + offset - 4, "ZGL2", 4);
 
-	FString path = CreateCacheName(map, true);
-	FILE *f = fopen(path, "wb");
-	fwrite(compressed, 1, outlen+offset, f);
-	fclose(f);
+	DWORD crc = LittleLong(CalcCRC32(compressed + CACHE_HEADER, outlen + offset - CACHE_HEADER));
+	memcpy(compressed + CACHE_CRCPOS, &crc, 4);
+
+	P_WriteCacheFile(P_GetCacheName(map, ".gzc", true), compressed, outlen+offset);
 	delete [] compressed;
 }
 
 
 static bool CheckCachedNodes(MapData *map)
 {
-	char magic[4] = {0,0,0,0};
-	BYTE md5[16];
 	BYTE md5map[16];
-	DWORD numlin;
-	DWORD *verts = NULL;
+	TArray<BYTE> data;
+	size_t offset = size_t(numlines) * 8 + CACHE_HEADER + 4;
 
-	FString path = CreateCacheName(map, false);
-	FILE *f = fopen(path, "rb");
-	if (f == NULL) return false;
+	// Read the whole file at once, so that it can be verified before
+	// anything in it is used.
+	FString path = P_GetCacheName(map, ".gzc", false);
+	if (!P_ReadCacheFile(path, data)) return false;
 
-	if (fread(magic, 1, 4, f) != 4) goto errorout;
-	if (memcmp(magic, "CACH", 4))  goto errorout;
+	if (data.Size() <= offset) goto errorout;
+	if (memcmp(&data[0], CACHE_MAGIC, 4)) goto errorout;
+	if ((int)LittleLong(*(DWORD *)&data[4]) != numlines) goto errorout;
 
-	if (fread(&numlin, 4, 1, f) != 1) goto errorout; 
-	numlin = LittleLong(numlin);
-	if ((int)numlin != numlines) goto errorout;
-
-	if (fread(md5, 1, 16, f) != 16) goto errorout;
 	map->GetChecksum(md5map);
-	if (memcmp(md5, md5map, 16)) goto errorout;
-
-	verts = new DWORD[numlin * 8];
-	if (fread(verts, 8, numlin, f) != numlin) goto errorout;
-
-	if (fread(magic, 1, 4, f) != 4) goto errorout;
-	if (memcmp(magic, "ZGL2", 4))  goto errorout;
+	if (memcmp(&data[8], md5map, 16)) goto errorout;
 
+	if (LittleLong(*(DWORD *)&data[CACHE_CRCPOS]) != CalcCRC32(&data[CACHE_HEADER], data.Size() - CACHE_HEADER))
+	{
+		DPrintf("Node cache %s is damaged\n", path.GetChars());
+		goto errorout;
+	}
+	if (memcmp(&data[offset - 4], "ZGL2", 4)) goto errorout;
 
 	try
 	{
-		long pos = ftell(f);
-		FileReader fr(f);
-		fr.Seek(pos, SEEK_SET);
+		MemoryReader fr((const char *)&data[offset], long(data.Size() - offset));
 		P_LoadZNodes (fr, MAKE_ID('Z','G','L','2'));
+
+		const DWORD *verts = (const DWORD *)&data[CACHE_HEADER];
+		for(int i=0;i<numlines*2;i++)
+		{
+			if (LittleLong(verts[i]) >= DWORD(numvertexes))
+			{
+				throw CRecoverableError("Line vertex index out of range");
+			}
+		}
 	}
 	catch (CRecoverableError &error)
 	{
@@ -1236,22 +1312,19 @@ static bool CheckCachedNodes(MapData *map)
 		goto errorout;
 	}
 
-	for(int i=0;i<numlines;i++)
 	{
-		lines[i].v1 = &vertexes[LittleLong(verts[i*2])];
-		lines[i].v2 = &vertexes[LittleLong(verts[i*2+1])];
+		const DWORD *verts = (const DWORD *)&data[CACHE_HEADER];
+		for(int i=0;i<numlines;i++)
+		{
+			lines[i].v1 = &vertexes[LittleLong(verts[i*2])];
+			lines[i].v2 = &vertexes[LittleLong(verts[i*2+1])];
+		}
 	}
-	delete [] verts;
-
-	fclose(f);
 	return true;
 
 errorout:
-	if (verts != NULL)
-	{
-		delete[] verts;
-	}
-	fclose(f);
+	// Get rid of anything that cannot be used, so that it gets rebuilt.
+	remove(path);
 	return false;
 }
 
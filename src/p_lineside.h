@@ -0,0 +1,43 @@
+#ifndef __P_LINESIDE_H__
+#define __P_LINESIDE_H__
+
+#include "doomtype.h"
+
+//==========================================================================
+//
+// Batched line crossing tests
+//
+// Tests a whole set of lines against one trace at once. A line is crossed
+// if its two vertices are on different sides of the trace, as computed by
+// P_PointOnDivlineSide. The vertex coordinates are passed as separate
+// arrays so that the SIMD versions can load several lines per instruction.
+// All arrays must have room for the count rounded up to a multiple of
+// LINESIDE_BATCH_ALIGN; the result for the padding is undefined.
+//
+//==========================================================================
+
+enum { LINESIDE_BATCH_ALIGN = 8 };
+
+struct FLineSideBatch
+{
+	const fixed_t *x1, *y1;
+	const fixed_t *x2, *y2;
+	int Count;
+};
+
+void P_LinesCrossedC (fixed_t tx, fixed_t ty, fixed_t tdx, fixed_t tdy, const FLineSideBatch &batch, BYTE *crossed);
+
+// The SSE2 version is available everywhere SSE2 can be used: Always on x64,
+// and on x86 if the file could be compiled with SSE2 enabled.
+#if defined(_M_X64) || defined(__amd64__) || defined(__SSE2__) || \
+	((defined(_M_IX86) || defined(__i386__)) && !defined(DISABLE_SSE))
+#define HAVE_LINESIDE_SSE2
+void P_LinesCrossedSSE2 (fixed_t tx, fixed_t ty, fixed_t tdx, fixed_t tdy, const FLineSideBatch &batch, BYTE *crossed);
+#endif
+
+#if (defined(_M_X64) || defined(__amd64__) || defined(_M_IX86) || defined(__i386__)) && !defined(DISABLE_AVX2)
+#define HAVE_LINESIDE_AVX2
+void P_LinesCrossedAVX2 (fixed_t tx, fixed_t ty, fixed_t tdx, fixed_t tdy, const FLineSideBatch &batch, BYTE *crossed);
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#include "p_lineside.h"
+
+#ifdef HAVE_LINESIDE_SSE2
+
+#include <string.h>
+#include <emmintrin.h>
+
+// SSE2 has no signed 32x32->64 multiply, so the products are calculated as
+// unsigned and the upper halves are corrected afterwards. Only the upper
+// half of DMulScale32's 64-bit sum is needed for the side test, so the
+// corrections are applied after the halves of the four lines have been
+// gathered in one register.
+
+static inline __m128i SignedMulHiSum (__m128i a, __m128i b, __m128i c, __m128i d)
+{
+	const __m128i himask = _mm_set_epi32 (-1, 0, -1, 0);
+
+	__m128i even = _mm_add_epi64 (_mm_mul_epu32 (a, b), _mm_mul_epu32 (c, d));
+	__m128i odd = _mm_add_epi64 (
+		_mm_mul_epu32 (_mm_srli_epi64 (a, 32), _mm_srli_epi64 (b, 32)),
+		_mm_mul_epu32 (_mm_srli_epi64 (c, 32), _mm_srli_epi64 (d, 32)));
+	__m128i hi = _mm_or_si128 (_mm_srli_epi64 (even, 32), _mm_and_si128 (odd, himask));
+
+	__m128i corr = _mm_add_epi32 (
+		_mm_add_epi32 (_mm_and_si128 (_mm_srai_epi32 (a, 31), b), _mm_and_si128 (_mm_srai_epi32 (b, 31), a)),
+		_mm_add_epi32 (_mm_and_si128 (_mm_srai_epi32 (c, 31), d), _mm_and_si128 (_mm_srai_epi32 (d, 31), c)));
+	return _mm_sub_epi32 (hi, corr);
+}
+
+void P_LinesCrossedSSE2 (fixed_t tx, fixed_t ty, fixed_t tdx, fixed_t tdy, const FLineSideBatch &batch, BYTE *crossed)
+{
+	const __m128i vtx = _mm_set1_epi32 (tx);
+	const __m128i vty = _mm_set1_epi32 (ty);
+	const __m128i vdx = _mm_set1_epi32 (tdx);
+	const __m128i vdy = _mm_set1_epi32 (tdy);
+	const __m128i zero = _mm_setzero_si128 ();
+
+	for (int i = 0; i < batch.Count; i += 4)
+	{
+		__m128i x1 = _mm_loadu_si128 ((const __m128i *)(batch.x1 + i));
+		__m128i y1 = _mm_loadu_si128 ((const __m128i *)(batch.y1 + i));
+		__m128i x2 = _mm_loadu_si128 ((const __m128i *)(batch.x2 + i));
+		__m128i y2 = _mm_loadu_si128 ((const __m128i *)(batch.y2 + i));
+
+		// P_PointOnDivlineSide: DMulScale32 (y-line->y, line->dx, line->x-x, line->dy) > 0
+		__m128i s1 = _mm_cmpgt_epi32 (SignedMulHiSum (_mm_sub_epi32 (y1, vty), vdx, _mm_sub_epi32 (vtx, x1), vdy), zero);
+		__m128i s2 = _mm_cmpgt_epi32 (SignedMulHiSum (_mm_sub_epi32 (y2, vty), vdx, _mm_sub_epi32 (vtx, x2), vdy), zero);
+		__m128i cross = _mm_xor_si128 (s1, s2);
+
+		cross = _mm_packs_epi32 (cross, cross);
+		cross = _mm_packs_epi16 (cross, cross);
+		int out = _mm_cvtsi128_si32 (cross);
+		memcpy (crossed + i, &out, 4);
+	}
+}
+
+#endif
@@ -2863,6 +2863,7 @@ FUNC(LS_Line_SetBlocking)
 	for(int line = -1; (line = P_FindLineFromID (arg0, line)) >= 0; )
 	{
 		lines[line].flags = (lines[line].flags & ~clearflags) | setflags;
+		P_InvalidateSightCache();
 
 		// [Dusk] Update clients on the line flags
 		if ( NETWORK_GetState() == NETSTATE_SERVER )
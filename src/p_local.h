@@ -314,6 +314,71 @@ public:
 	void Reset() { StartBlock(minx, miny); }
 };
 
+//===========================================================================
+//
+// FCompactBlockmap
+//
+// An alternative to the blocklinks chains that keeps the actors of every
+// block in one contiguous array. Actors that span several blocks keep the
+// slots they occupy in a side list, so they can be removed from all of them.
+// It is maintained in addition to blocklinks and only used by
+// FBlockThingsIterator.
+//
+// While an iterator is live, removed entries are only cleared, because
+// moving another entry into the slot could make the iterator return that
+// actor twice. The cleared slots are filled once the last iterator is gone.
+//
+//===========================================================================
+
+class FCompactBlockmap
+{
+public:
+	struct Entry
+	{
+		AActor *Actor;
+		// Range of blocks the actor is in. Used to return actors that span
+		// several blocks only once without hashing them.
+		short x1, y1, x2, y2;
+	};
+
+	FCompactBlockmap() : Blocks(NULL), NumBlocks(0), NumIterators(0) {}
+	~FCompactBlockmap() { Clear(); }
+
+	void Init();
+	void Clear();
+	void LinkAllActors();
+	bool IsActive() const { return Blocks != NULL; }
+
+	void Link(AActor *actor, int x1, int y1, int x2, int y2);
+	void Unlink(AActor *actor);
+
+	const TArray<Entry> &GetBlock(int index) const { return Blocks[index]; }
+
+	void AddIterator() { ++NumIterators; }
+	void RemoveIterator() { if (--NumIterators == 0 && DirtyBlocks.Size() > 0) Compact(); }
+
+private:
+	struct MultiBlockRecord
+	{
+		AActor *Actor;
+		int x1, y1, x2, y2;
+		TArray<int> Slots;	// slot in each block of the actor's range, row by row
+	};
+
+	void RemoveFromBlock(int index, int slot);
+	void FillSlot(int index, int slot);
+	void Compact();
+
+	TArray<Entry> *Blocks;
+	int NumBlocks;
+	int NumIterators;
+	TArray<int> DirtyBlocks;	// blocks with cleared slots, may contain duplicates
+	TArray<MultiBlockRecord> MultiBlockActors;
+	TArray<int> FreeMultiBlockRecords;
+};
+
+extern FCompactBlockmap CompactBlockmap;
+
 class FBlockThingsIterator
 {
 	int minx, maxx;
@@ -323,6 +388,13 @@ class FBlockThingsIterator
 
 	FBlockNode *block;
 
+	// Used instead of block when the compact blockmap is active.
+	const TArray<FCompactBlockmap::Entry> *compactBlock;
+	int compactIndex;
+	// Only the path traverser needs the hash with the compact blockmap,
+	// because it moves the iterated range around with SwitchBlock.
+	bool useHash;
+
 	int Buckets[32];
 
 	struct HashEntry
@@ -339,6 +411,8 @@ class FBlockThingsIterator
 	void StartBlock(int x, int y);
 	void SwitchBlock(int x, int y);
 	void ClearHash();
+	bool AddToHash(AActor *me);
+	bool IsCenterInBlock(AActor *me) const;
 
 	// The following is only for use in the path traverser 
 	// and therefore declared private.
@@ -346,9 +420,14 @@ class FBlockThingsIterator
 
 	friend class FPathTraverse;
 
+	// Copies would throw off the compact blockmap's iterator count.
+	FBlockThingsIterator(const FBlockThingsIterator &);
+	FBlockThingsIterator &operator=(const FBlockThingsIterator &);
+
 public:
 	FBlockThingsIterator(int minx, int miny, int maxx, int maxy);
 	FBlockThingsIterator(const FBoundingBox &box);
+	~FBlockThingsIterator() { CompactBlockmap.RemoveIterator(); }
 	AActor *Next(bool centeronly = false);
 	void Reset() { StartBlock(minx, miny); }
 };
@@ -364,6 +443,7 @@ class FPathTraverse
 	unsigned int count;
 
 	void AddLineIntercepts(int bx, int by);
+	void AddLineIntercept(line_t *ld);
 	void AddThingIntercepts(int bx, int by, FBlockThingsIterator &it, bool compatible);
 public:
 
@@ -462,6 +542,7 @@ enum ESightFlags
 };
 
 void	P_ResetSightCounters (bool full);
+void	P_InvalidateSightCache ();
 void	P_ResetSpawnCounters( void ); // [BC]
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
@@ -577,6 +658,7 @@ inline sector_t *P_PointInSector(fixed_t x, fixed_t y)
 // P_SETUP
 //
 extern BYTE*			rejectmatrix;	// for fast sight rejection
+extern bool				rejectbuilt;	// rejectmatrix was made by P_BuildReject
 extern int*				blockmaplump;	// offsets in blockmap are from here
 
 extern int*				blockmap;
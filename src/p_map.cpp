@@ -6453,6 +6453,9 @@ bool P_ChangeSector(sector_t *sector, int crunch, int amt, int floorOrCeil, bool
 	void(*iterator2)(AActor *, FChangePosition *) = NULL;
 	msecnode_t *n;
 
+	// The sector may now block or unblock sight.
+	P_InvalidateSightCache();
+
 	cpos.nofit = false;
 	cpos.crushchange = crunch;
 	cpos.moveamt = abs(amt);
@@ -44,6 +44,13 @@
 // [Leo] Zandronum includes
 #include "v_text.h"
 #include "sv_main.h"
+#include "c_dispatch.h"
+#include "g_level.h"
+#include "m_random.h"
+#include "stats.h"
+#include "network.h"
+#include "p_lineside.h"
+#include "x86.h"
 
 static AActor *RoughBlockCheck (AActor *mo, int index, void *);
 
@@ -318,6 +325,11 @@ void AActor::UnlinkFromWorld ()
 			block = next;
 		}
 		BlockNode = NULL;
+
+		if (CompactBlock != 0)
+		{
+			CompactBlockmap.Unlink (this);
+		}
 	}
 }
 
@@ -429,6 +441,11 @@ void AActor::LinkToWorld (sector_t *sec)
 					alink = &node->NextBlock;
 				}
 			}
+
+			if (CompactBlockmap.IsActive())
+			{
+				CompactBlockmap.Link (this, x1, y1, x2, y2);
+			}
 		}
 	}
 }
@@ -645,6 +662,253 @@ void FBlockNode::Release ()
 	FreeBlocks = this;
 }
 
+//===========================================================================
+//
+// FCompactBlockmap
+//
+//===========================================================================
+
+FCompactBlockmap CompactBlockmap;
+
+//===========================================================================
+//
+// FCompactBlockmap :: Init
+//
+// Creates an empty block array for the current blockmap.
+//
+//===========================================================================
+
+void FCompactBlockmap::Init ()
+{
+	Clear ();
+	NumBlocks = bmapwidth * bmapheight;
+	Blocks = new TArray<Entry>[NumBlocks];
+}
+
+//===========================================================================
+//
+// FCompactBlockmap :: Clear
+//
+//===========================================================================
+
+void FCompactBlockmap::Clear ()
+{
+	if (Blocks != NULL)
+	{
+		delete[] Blocks;
+		Blocks = NULL;
+	}
+	NumBlocks = 0;
+	MultiBlockActors.Clear ();
+	FreeMultiBlockRecords.Clear ();
+	DirtyBlocks.Clear ();
+}
+
+//===========================================================================
+//
+// FCompactBlockmap :: LinkAllActors
+//
+// Links every actor that is in blocklinks. Used when the compact blockmap
+// is enabled in the middle of a level.
+//
+//===========================================================================
+
+void FCompactBlockmap::LinkAllActors ()
+{
+	TThinkerIterator<AActor> it;
+	AActor *actor;
+
+	while ((actor = it.Next ()) != NULL)
+	{
+		actor->CompactBlock = 0;
+		if (actor->BlockNode == NULL)
+		{
+			continue;
+		}
+
+		// The block nodes were created row by row, so the first and the last
+		// one are the corners of the actor's block range.
+		FBlockNode *last = actor->BlockNode;
+		while (last->NextBlock != NULL)
+		{
+			last = last->NextBlock;
+		}
+		int first = actor->BlockNode->BlockIndex;
+		Link (actor, first % bmapwidth, first / bmapwidth, last->BlockIndex % bmapwidth, last->BlockIndex / bmapwidth);
+	}
+}
+
+//===========================================================================
+//
+// FCompactBlockmap :: Link
+//
+// The range must already be clipped to the blockmap.
+//
+//===========================================================================
+
+void FCompactBlockmap::Link (AActor *actor, int x1, int y1, int x2, int y2)
+{
+	Entry entry = { actor, (short)x1, (short)y1, (short)x2, (short)y2 };
+
+	if (x1 == x2 && y1 == y2)
+	{
+		int index = y1*bmapwidth + x1;
+		actor->CompactBlock = index + 1;
+		actor->CompactSlot = Blocks[index].Push (entry);
+		return;
+	}
+
+	int record;
+	if (!FreeMultiBlockRecords.Pop (record))
+	{
+		record = MultiBlockActors.Reserve (1);
+	}
+
+	MultiBlockRecord &rec = MultiBlockActors[record];
+	rec.Actor = actor;
+	rec.x1 = x1;
+	rec.y1 = y1;
+	rec.x2 = x2;
+	rec.y2 = y2;
+	rec.Slots.Clear ();
+	for (int y = y1; y <= y2; ++y)
+	{
+		for (int x = x1; x <= x2; ++x)
+		{
+			rec.Slots.Push (Blocks[y*bmapwidth + x].Push (entry));
+		}
+	}
+	actor->CompactBlock = -(record + 1);
+}
+
+//===========================================================================
+//
+// FCompactBlockmap :: Unlink
+//
+//===========================================================================
+
+void FCompactBlockmap::Unlink (AActor *actor)
+{
+	// The link info may be left over from before the last Init, so it is
+	// only trusted if it still points back at the actor.
+	if (actor->CompactBlock > 0)
+	{
+		int index = actor->CompactBlock - 1;
+		int slot = actor->CompactSlot;
+
+		if (index < NumBlocks && (unsigned)slot < Blocks[index].Size() && Blocks[index][slot].Actor == actor)
+		{
+			RemoveFromBlock (index, slot);
+		}
+	}
+	else if (actor->CompactBlock < 0)
+	{
+		unsigned int record = -actor->CompactBlock - 1;
+
+		if (record < MultiBlockActors.Size() && MultiBlockActors[record].Actor == actor)
+		{
+			MultiBlockRecord &rec = MultiBlockActors[record];
+			int i = 0;
+
+			for (int y = rec.y1; y <= rec.y2; ++y)
+			{
+				for (int x = rec.x1; x <= rec.x2; ++x)
+				{
+					RemoveFromBlock (y*bmapwidth + x, rec.Slots[i++]);
+				}
+			}
+			rec.Actor = NULL;
+			FreeMultiBlockRecords.Push (record);
+		}
+	}
+	actor->CompactBlock = 0;
+}
+
+//===========================================================================
+//
+// FCompactBlockmap :: RemoveFromBlock
+//
+// Clears the slot if an iterator is live, or fills it right away otherwise.
+//
+//===========================================================================
+
+void FCompactBlockmap::RemoveFromBlock (int index, int slot)
+{
+	if (NumIterators > 0)
+	{
+		Blocks[index][slot].Actor = NULL;
+		DirtyBlocks.Push (index);
+	}
+	else
+	{
+		FillSlot (index, slot);
+	}
+}
+
+//===========================================================================
+//
+// FCompactBlockmap :: FillSlot
+//
+// Moves the last entry of the block into the freed slot.
+//
+//===========================================================================
+
+void FCompactBlockmap::FillSlot (int index, int slot)
+{
+	TArray<Entry> &block = Blocks[index];
+	int last = block.Size() - 1;
+
+	if (slot != last)
+	{
+		Entry &moved = block[slot];
+		moved = block[last];
+
+		if (moved.x1 == moved.x2 && moved.y1 == moved.y2)
+		{
+			moved.Actor->CompactSlot = slot;
+		}
+		else
+		{
+			MultiBlockRecord &rec = MultiBlockActors[-moved.Actor->CompactBlock - 1];
+			int x = index % bmapwidth;
+			int y = index / bmapwidth;
+			rec.Slots[(y - moved.y1) * (moved.x2 - moved.x1 + 1) + (x - moved.x1)] = slot;
+		}
+	}
+	block.Pop ();
+}
+
+//===========================================================================
+//
+// FCompactBlockmap :: Compact
+//
+// Fills the slots that were cleared while iterators were live.
+//
+//===========================================================================
+
+void FCompactBlockmap::Compact ()
+{
+	for (unsigned int i = 0; i < DirtyBlocks.Size(); ++i)
+	{
+		int index = DirtyBlocks[i];
+
+		if (index >= NumBlocks)
+		{
+			continue;
+		}
+		// Going down, everything above the slot is already valid, so the
+		// entry that gets moved into it is never a cleared one.
+		for (int slot = Blocks[index].Size() - 1; slot >= 0; --slot)
+		{
+			if (Blocks[index][slot].Actor == NULL)
+			{
+				FillSlot (index, slot);
+			}
+		}
+	}
+	DirtyBlocks.Clear ();
+}
+
 //
 // BLOCK MAP ITERATORS
 // For each line/thing in the given mapblock,
@@ -789,19 +1053,25 @@ line_t *FBlockLinesIterator::Next()
 FBlockThingsIterator::FBlockThingsIterator()
 : DynHash(0)
 {
+	CompactBlockmap.AddIterator();
 	minx = maxx = 0;
 	miny = maxy = 0;
 	ClearHash();
 	block = NULL;
+	compactBlock = NULL;
+	compactIndex = 0;
+	useHash = true;
 }
 
 FBlockThingsIterator::FBlockThingsIterator(int _minx, int _miny, int _maxx, int _maxy)
 : DynHash(0)
 {
+	CompactBlockmap.AddIterator();
 	minx = _minx;
 	maxx = _maxx;
 	miny = _miny;
 	maxy = _maxy;
+	useHash = false;
 	ClearHash();
 	Reset();
 }
@@ -809,6 +1079,8 @@ FBlockThingsIterator::FBlockThingsIterator(int _minx, int _miny, int _maxx, int
 FBlockThingsIterator::FBlockThingsIterator(const FBoundingBox &box)
 : DynHash(0)
 {
+	CompactBlockmap.AddIterator();
+	useHash = false;
 	maxy = GetSafeBlockY(box.Top() - bmaporgy);
 	miny = GetSafeBlockY(box.Bottom() - bmaporgy);
 	maxx = GetSafeBlockX(box.Right() - bmaporgx);
@@ -840,14 +1112,20 @@ void FBlockThingsIterator::StartBlock(int x, int y)
 { 
 	curx = x; 
 	cury = y; 
+	block = NULL;
+	compactBlock = NULL;
 	if (x >= 0 && y >= 0 && x < bmapwidth && y <bmapheight)
 	{
-		block = blocklinks[y*bmapwidth + x];
-	}
-	else
-	{
-		// invalid block
-		block = NULL;
+		if (CompactBlockmap.IsActive())
+		{
+			// Walked backwards, so removing the current actor doesn't skip another one.
+			compactBlock = &CompactBlockmap.GetBlock(y*bmapwidth + x);
+			compactIndex = compactBlock->Size();
+		}
+		else
+		{
+			block = blocklinks[y*bmapwidth + x];
+		}
 	}
 }
 
@@ -870,16 +1148,127 @@ void FBlockThingsIterator::SwitchBlock(int x, int y)
 //
 //===========================================================================
 
+//===========================================================================
+//
+// FBlockThingsIterator :: IsCenterInBlock
+//
+// Block boundaries for compatibility mode
+//
+//===========================================================================
+
+bool FBlockThingsIterator::IsCenterInBlock(AActor *me) const
+{
+	fixed_t blockleft = (curx << MAPBLOCKSHIFT) + bmaporgx;
+	fixed_t blockright = blockleft + MAPBLOCKSIZE;
+	fixed_t blockbottom = (cury << MAPBLOCKSHIFT) + bmaporgy;
+	fixed_t blocktop = blockbottom + MAPBLOCKSIZE;
+
+	return me->x >= blockleft && me->x < blockright &&
+		me->y >= blockbottom && me->y < blocktop;
+}
+
+//===========================================================================
+//
+// FBlockThingsIterator :: AddToHash
+//
+// Returns false if the actor was already returned before.
+//
+//===========================================================================
+
+bool FBlockThingsIterator::AddToHash(AActor *me)
+{
+	HashEntry *entry;
+	int i;
+
+	size_t hash = ((size_t)me >> 3) % countof(Buckets);
+	for (i = Buckets[hash]; i >= 0; )
+	{
+		entry = GetHashEntry(i);
+		if (entry->Actor == me)
+		{ // I've already been checked. Skip to the next actor.
+			return false;
+		}
+		i = entry->Next;
+	}
+
+	// Add me to the hash table and return me.
+	if (NumFixedHash < (int)countof(FixedHash))
+	{
+		entry = &FixedHash[NumFixedHash];
+		entry->Next = Buckets[hash];
+		Buckets[hash] = NumFixedHash++;
+	}
+	else
+	{
+		if (DynHash.Size() == 0)
+		{
+			DynHash.Grow(50);
+		}
+		i = DynHash.Reserve(1);
+		entry = &DynHash[i];
+		entry->Next = Buckets[hash];
+		Buckets[hash] = i + countof(FixedHash);
+	}
+	entry->Actor = me;
+	return true;
+}
+
+//===========================================================================
+//
+// FBlockThingsIterator :: Next
+//
+//===========================================================================
+
 AActor *FBlockThingsIterator::Next(bool centeronly)
 {
 	for (;;)
 	{
+		while (compactBlock != NULL && compactIndex > 0)
+		{
+			// The block may have shrunk since the last call.
+			if (--compactIndex >= (int)compactBlock->Size())
+			{
+				continue;
+			}
+
+			const FCompactBlockmap::Entry &entry = (*compactBlock)[compactIndex];
+			AActor *me = entry.Actor;
+
+			if (me == NULL)
+			{ // Unlinked while this iterator was live.
+				continue;
+			}
+
+			if (entry.x1 == entry.x2 && entry.y1 == entry.y2)
+			{ // This actor doesn't span blocks, so we know it can only ever be checked once.
+				return me;
+			}
+			if (centeronly)
+			{
+				if (IsCenterInBlock(me))
+				{
+					return me;
+				}
+			}
+			else if (useHash)
+			{
+				if (AddToHash(me))
+				{
+					return me;
+				}
+			}
+			// Blocks are visited row by row, so the first block of the actor
+			// inside the iterated range is where it is returned.
+			else if (curx == MAX<int>(minx, entry.x1) && cury == MAX<int>(miny, entry.y1))
+			{
+				return me;
+			}
+		}
+
 		while (block != NULL)
 		{
 			AActor *me = block->Me;
 			FBlockNode *mynode = block;
-			HashEntry *entry;
-			int i;
 
 			block = block->NextActor;
 			// Don't recheck things that were already checked
@@ -889,53 +1278,15 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 			}
 			if (centeronly)
 			{
-				// Block boundaries for compatibility mode
-				fixed_t blockleft = (curx << MAPBLOCKSHIFT) + bmaporgx;
-				fixed_t blockright = blockleft + MAPBLOCKSIZE;
-				fixed_t blockbottom = (cury << MAPBLOCKSHIFT) + bmaporgy;
-				fixed_t blocktop = blockbottom + MAPBLOCKSIZE;
-
 				// only return actors with the center in this block
-				if (me->x >= blockleft && me->x < blockright &&
-					me->y >= blockbottom && me->y < blocktop)
+				if (IsCenterInBlock(me))
 				{
 					return me;
 				}
 			}
-			else
+			else if (AddToHash(me))
 			{
-				size_t hash = ((size_t)me >> 3) % countof(Buckets);
-				for (i = Buckets[hash]; i >= 0; )
-				{
-					entry = GetHashEntry(i);
-					if (entry->Actor == me)
-					{ // I've already been checked. Skip to the next actor.
-						break;
-					}
-					i = entry->Next;
-				}
-				if (i < 0)
-				{ // Add me to the hash table and return me.
-					if (NumFixedHash < (int)countof(FixedHash))
-					{
-						entry = &FixedHash[NumFixedHash];
-						entry->Next = Buckets[hash];
-						Buckets[hash] = NumFixedHash++;
-					}
-					else
-					{
-						if (DynHash.Size() == 0)
-						{
-							DynHash.Grow(50);
-						}
-						i = DynHash.Reserve(1);
-						entry = &DynHash[i];
-						entry->Next = Buckets[hash];
-						Buckets[hash] = i + countof(FixedHash);
-					}
-					entry->Actor = me;
-					return me;
-				}
+				return me;
 			}
 		}
 
@@ -958,6 +1309,52 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 TArray<intercept_t> FPathTraverse::intercepts(128);
 
 
+//===========================================================================
+//
+// P_LinesCrossedC
+//
+// Reference version of the batched crossing test. The SIMD versions are
+// in p_lineside_sse2.cpp and p_lineside_avx2.cpp.
+//
+//===========================================================================
+
+void P_LinesCrossedC (fixed_t tx, fixed_t ty, fixed_t tdx, fixed_t tdy, const FLineSideBatch &batch, BYTE *crossed)
+{
+	divline_t trace = { tx, ty, tdx, tdy };
+
+	for (int i = 0; i < batch.Count; ++i)
+	{
+		crossed[i] = P_PointOnDivlineSide (batch.x1[i], batch.y1[i], &trace) !=
+					 P_PointOnDivlineSide (batch.x2[i], batch.y2[i], &trace);
+	}
+}
+
+typedef void (*LinesCrossedFunc) (fixed_t tx, fixed_t ty, fixed_t tdx, fixed_t tdy, const FLineSideBatch &batch, BYTE *crossed);
+
+// 0 = always use the scalar version, 1 = pick the best version for this CPU.
+CUSTOM_CVAR (Int, simd_linecrossing, 1, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+{
+	if (self < 0 || self > 1)
+		self = 1;
+}
+
+static LinesCrossedFunc P_GetLinesCrossedFunc ()
+{
+	if (simd_linecrossing == 0)
+		return P_LinesCrossedC;
+#ifdef HAVE_LINESIDE_AVX2
+	if (CPU.bAVX2)
+		return P_LinesCrossedAVX2;
+#endif
+#ifdef HAVE_LINESIDE_SSE2
+#if !defined(_M_X64) && !defined(__amd64__) && !defined(__SSE2__)
+	if (CPU.bSSE2)
+#endif
+		return P_LinesCrossedSSE2;
+#endif
+	return P_LinesCrossedC;
+}
+
 //===========================================================================
 //
 // FPathTraverse :: AddLineIntercepts.
@@ -968,6 +1365,11 @@ TArray<intercept_t> FPathTraverse::intercepts(128);
 // A line is crossed if its endpoints
 // are on opposite sides of the trace.
 //
+// Long traces test all lines of the block at once with
+// P_LinesCrossed*. Everything that follows the side test
+// is done in the original line order, so the result is
+// the same as testing the lines one by one.
+//
 //===========================================================================
 
 void FPathTraverse::AddLineIntercepts(int bx, int by)
@@ -975,46 +1377,92 @@ void FPathTraverse::AddLineIntercepts(int bx, int by)
 	FBlockLinesIterator it(bx, by, bx, by, true);
 	line_t *ld;
 
-	while ((ld = it.Next()))
+	// avoid precision problems with two routines
+	if ( trace.dx > FRACUNIT*16
+		 || trace.dy > FRACUNIT*16
+		 || trace.dx < -FRACUNIT*16
+		 || trace.dy < -FRACUNIT*16)
 	{
-		int 				s1;
-		int 				s2;
-		fixed_t 			frac;
-		divline_t			dl;
+		static TArray<line_t *> lines;
+		static TArray<fixed_t> coords[4];
+		static TArray<BYTE> crossed;
+		unsigned int count = 0;
 
-		// avoid precision problems with two routines
-		if ( trace.dx > FRACUNIT*16
-			 || trace.dy > FRACUNIT*16
-			 || trace.dx < -FRACUNIT*16
-			 || trace.dy < -FRACUNIT*16)
+		while ((ld = it.Next()))
 		{
-			s1 = P_PointOnDivlineSide (ld->v1->x, ld->v1->y, &trace);
-			s2 = P_PointOnDivlineSide (ld->v2->x, ld->v2->y, &trace);
+			if (count >= lines.Size())
+			{
+				// Leave room for the padding the SIMD versions read.
+				unsigned int newsize = MAX<unsigned int>(64, lines.Size() * 2);
+				lines.Resize (newsize);
+				for (int j = 0; j < 4; ++j)
+				{
+					coords[j].Resize (newsize + LINESIDE_BATCH_ALIGN);
+				}
+				crossed.Resize (newsize + LINESIDE_BATCH_ALIGN);
+			}
+			lines[count] = ld;
+			coords[0][count] = ld->v1->x;
+			coords[1][count] = ld->v1->y;
+			coords[2][count] = ld->v2->x;
+			coords[3][count] = ld->v2->y;
+			count++;
 		}
-		else
+		if (count == 0)
+			return;
+
+		FLineSideBatch batch = { &coords[0][0], &coords[1][0], &coords[2][0], &coords[3][0], (int)count };
+		P_GetLinesCrossedFunc() (trace.x, trace.y, trace.dx, trace.dy, batch, &crossed[0]);
+
+		for (unsigned int i = 0; i < count; ++i)
 		{
-			s1 = P_PointOnLineSide (trace.x, trace.y, ld);
-			s2 = P_PointOnLineSide (trace.x+trace.dx, trace.y+trace.dy, ld);
+			if (!crossed[i]) continue;	// line isn't crossed
+
+			AddLineIntercept (lines[i]);
 		}
-		
-		if (s1 == s2) continue;	// line isn't crossed
-		
-		// hit the line
-		P_MakeDivline (ld, &dl);
-		frac = P_InterceptVector (&trace, &dl);
+	}
+	else
+	{
+		while ((ld = it.Next()))
+		{
+			int s1 = P_PointOnLineSide (trace.x, trace.y, ld);
+			int s2 = P_PointOnLineSide (trace.x+trace.dx, trace.y+trace.dy, ld);
 
-		if (frac < 0) continue;	// behind source
-			
-		intercept_t newintercept;
+			if (s1 == s2) continue;	// line isn't crossed
 
-		newintercept.frac = frac;
-		newintercept.isaline = true;
-		newintercept.done = false;
-		newintercept.d.line = ld;
-		intercepts.Push (newintercept);
+			AddLineIntercept (ld);
+		}
 	}
 }
 
+//===========================================================================
+//
+// FPathTraverse :: AddLineIntercept
+//
+// Adds a line that is known to be crossed by the trace.
+//
+//===========================================================================
+
+void FPathTraverse::AddLineIntercept(line_t *ld)
+{
+	fixed_t 			frac;
+	divline_t			dl;
+
+	// hit the line
+	P_MakeDivline (ld, &dl);
+	frac = P_InterceptVector (&trace, &dl);
+
+	if (frac < 0) return;	// behind source
+		
+	intercept_t newintercept;
+
+	newintercept.frac = frac;
+	newintercept.isaline = true;
+	newintercept.done = false;
+	newintercept.d.line = ld;
+	intercepts.Push (newintercept);
+}
+
 
 //===========================================================================
 //
@@ -1544,3 +1992,105 @@ static AActor *RoughBlockCheck (AActor *mo, int index, void *param)
 	}
 	return NULL;
 }
+
+//===========================================================================
+//
+// CCMD blockmapbench
+//
+// Compares the blocklinks chains with the compact blockmap by spawning a
+// dense crowd of inert actors and doing the same blockmap queries as
+// P_CheckPosition and P_RadiusAttack for each of them with both layouts.
+//
+//===========================================================================
+
+static FRandom pr_blockmapbench ("BlockmapBench");
+
+static unsigned int BlockmapBenchPass (TArray<AActor *> &actors, fixed_t range, int passes, cycle_t &clock)
+{
+	unsigned int found = 0;
+
+	clock.Reset();
+	clock.Clock();
+	for (int pass = 0; pass < passes; ++pass)
+	{
+		for (unsigned int i = 0; i < actors.Size(); ++i)
+		{
+			FBlockThingsIterator it(FBoundingBox(actors[i]->x, actors[i]->y, range == 0 ? actors[i]->radius : range));
+			AActor *th;
+
+			while ((th = it.Next()))
+			{
+				found++;
+			}
+		}
+	}
+	clock.Unclock();
+	return found;
+}
+
+CCMD (blockmapbench)
+{
+	if (gamestate != GS_LEVEL || NETWORK_GetState() != NETSTATE_SINGLE)
+	{
+		Printf ("blockmapbench can only be used in a single player game.\n");
+		return;
+	}
+
+	const int count = argv.argc() > 1 ? clamp (atoi (argv[1]), 1, 100000) : 2000;
+	const int passes = argv.argc() > 2 ? clamp (atoi (argv[2]), 1, 1000) : 20;
+
+	// Fill the area around the player so the crowd is as dense as an
+	// invasion horde rather than spread across the whole map.
+	AActor *center = players[consoleplayer].mo;
+	fixed_t cx = center != NULL ? center->x : bmaporgx + (bmapwidth << (MAPBLOCKSHIFT-1));
+	fixed_t cy = center != NULL ? center->y : bmaporgy + (bmapheight << (MAPBLOCKSHIFT-1));
+
+	TArray<AActor *> actors;
+	for (int i = 0; i < count; ++i)
+	{
+		fixed_t x = cx + pr_blockmapbench.Random2() * 8 * FRACUNIT;
+		fixed_t y = cy + pr_blockmapbench.Random2() * 8 * FRACUNIT;
+		AActor *mo = Spawn (RUNTIME_CLASS(AActor), x, y, ONFLOORZ, NO_REPLACE);
+		mo->UnlinkFromWorld ();
+		mo->radius = (16 + (pr_blockmapbench() & 31)) * FRACUNIT;
+		mo->LinkToWorld ();
+		actors.Push (mo);
+	}
+
+	const bool wasActive = CompactBlockmap.IsActive();
+	cycle_t clock;
+	double listTime[2], compactTime[2];
+	unsigned int listFound[2], compactFound[2];
+
+	CompactBlockmap.Clear ();
+	listFound[0] = BlockmapBenchPass (actors, 0, passes, clock);
+	listTime[0] = clock.TimeMS();
+	listFound[1] = BlockmapBenchPass (actors, 128*FRACUNIT, passes, clock);
+	listTime[1] = clock.TimeMS();
+
+	CompactBlockmap.Init ();
+	CompactBlockmap.LinkAllActors ();
+	compactFound[0] = BlockmapBenchPass (actors, 0, passes, clock);
+	compactTime[0] = clock.TimeMS();
+	compactFound[1] = BlockmapBenchPass (actors, 128*FRACUNIT, passes, clock);
+	compactTime[1] = clock.TimeMS();
+
+	if (!wasActive)
+	{
+		CompactBlockmap.Clear ();
+	}
+
+	for (unsigned int i = 0; i < actors.Size(); ++i)
+	{
+		actors[i]->Destroy ();
+	}
+
+	static const char *const queries[2] = { "CheckPosition", "RadiusAttack" };
+	Printf ("%d actors, %d passes\n", count, passes);
+	for (int i = 0; i < 2; ++i)
+	{
+		Printf ("%-14s blocklinks: %8.2f ms  compact: %8.2f ms  (%u / %u actors found)%s\n", queries[i],
+			listTime[i], compactTime[i], listFound[i], compactFound[i],
+			listFound[i] != compactFound[i] ? TEXTCOLOR_RED " MISMATCH" : "");
+	}
+}
@@ -0,0 +1,572 @@
+/*
+** p_reject.cpp
+** Builds a REJECT table for maps that come without a usable one
+**
+** Most maps made with modern editors ship an empty REJECT lump, so every
+** sight check has to trace through the blockmap. When genreject is set,
+** one is computed at load time from the two-sided lines of the map and
+** stored in the cache directory next to the node cache.
+**
+** A sight line can only get from one sector to another by crossing two-
+** sided lines, and since it is straight, every line it crosses after a
+** line L must have some part beyond L, and L must have some part before
+** it. For every line a sight line can leave its sector through, the
+** sectors that can be reached through lines that pass this test are
+** flooded. Anything that is not reached can never be seen, no matter how
+** the map's doors, lifts and polyobjects move. This is a much coarser test
+** than the visibility checks of a dedicated REJECT builder, but it never
+** rejects anything that could be visible.
+**
+** All of this only holds if a sector's lines really enclose the area the
+** BSP assigns to it. Old maps often have unclosed sectors or sidedefs that
+** point to the wrong sector, so any sector that fails these checks is left
+** out of the table.
+**
+** Since the table is only a conservative approximation, P_CheckSight
+** consults it after the stealth check, so that the random number sequence
+** is the same as without it.
+*/
+
+#include "doomtype.h"
+#include "doomstat.h"
+#include "templates.h"
+#include "c_cvars.h"
+#include "m_swap.h"
+#include "m_crc32.h"
+#include "i_system.h"
+#include "stats.h"
+#include "p_local.h"
+#include "p_setup.h"
+#include "r_state.h"
+#include "workerpool.h"
+
+CVAR (Bool, genreject, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
+
+#define REJECT_MAGIC		"REJ2"
+#define REJECT_HEADER		40
+
+// Number of source sectors each worker handles at a time.
+enum { REJECT_BATCH = 16 };
+
+// Beyond this the table would take more than 32 MB.
+enum { REJECT_MAXSECTORS = 16384 };
+
+// How far, in map units, a line may be on the wrong side of another and
+// still count as touching it. This is far more than the rounding of the
+// fixed point vertices, but too little to matter for the table.
+#define REJECT_TOLERANCE	(1. / 16)
+
+// A two-sided line as seen from one of its sectors. It is oriented so that
+// points beyond it, in the sector it leads to, are on the positive side.
+struct FRejectPortal
+{
+	double x1, y1, dx, dy;
+	double Slack;				// REJECT_TOLERANCE scaled by the line's length
+	int ToSector;
+
+	double Side (double x, double y) const
+	{
+		return (y - y1) * dx - (x - x1) * dy;
+	}
+};
+
+struct FRejectBuilder
+{
+	TArray<FRejectPortal> Portals;	// sorted by the sector they lead out of
+	TArray<int> FirstPortal;		// numsectors + 1 entries
+	TArray<bool> SeesAll;			// sectors that cannot be rejected at all
+	TArray<int> OddSectors;			// the sectors marked in SeesAll
+	int RowBytes;
+
+	void Init ();
+	void MarkOpenSectors ();
+	void MarkMisassignedSectors ();
+	void BuildRow (int sector, BYTE *row, TArray<int> &stamps, int &stamp, TArray<int> &queue) const;
+	void Reach (int sector, BYTE *row, TArray<int> &stamps, int stamp, TArray<int> &queue) const;
+	static bool CanFollow (const FRejectPortal &p, const FRejectPortal &r);
+};
+
+//==========================================================================
+//
+// FRejectBuilder :: Init
+//
+// Collects the two-sided lines of the map. Sectors with self-referencing
+// lines are usually render hacks whose area does not match their lines,
+// so these are treated as seeing and being seen by everything.
+//
+//==========================================================================
+
+void FRejectBuilder::Init ()
+{
+	TArray<int> counts;
+	int i;
+
+	counts.Resize (numsectors);
+	SeesAll.Resize (numsectors);
+	for (i = 0; i < numsectors; ++i)
+	{
+		counts[i] = 0;
+		SeesAll[i] = false;
+	}
+
+	MarkOpenSectors ();
+	MarkMisassignedSectors ();
+
+	for (i = 0; i < numlines; ++i)
+	{
+		line_t *line = &lines[i];
+		if (line->frontsector == NULL || line->backsector == NULL)
+		{
+			continue;
+		}
+		if (line->frontsector == line->backsector)
+		{
+			SeesAll[line->frontsector - sectors] = true;
+		}
+		counts[line->frontsector - sectors]++;
+		counts[line->backsector - sectors]++;
+	}
+
+	FirstPortal.Resize (numsectors + 1);
+	FirstPortal[0] = 0;
+	for (i = 0; i < numsectors; ++i)
+	{
+		FirstPortal[i + 1] = FirstPortal[i] + counts[i];
+		counts[i] = FirstPortal[i];
+	}
+	Portals.Resize (FirstPortal[numsectors]);
+
+	for (i = 0; i < numlines; ++i)
+	{
+		line_t *line = &lines[i];
+		if (line->frontsector == NULL || line->backsector == NULL)
+		{
+			continue;
+		}
+		double x1 = FIXED2FLOAT(line->v1->x), y1 = FIXED2FLOAT(line->v1->y);
+		double x2 = FIXED2FLOAT(line->v2->x), y2 = FIXED2FLOAT(line->v2->y);
+		double slack = REJECT_TOLERANCE * sqrt ((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+
+		// From front to back, the back side of the line is the far side.
+		FRejectPortal &front = Portals[counts[line->frontsector - sectors]++];
+		front.x1 = x1;
+		front.y1 = y1;
+		front.dx = x2 - x1;
+		front.dy = y2 - y1;
+		front.Slack = slack;
+		front.ToSector = int(line->backsector - sectors);
+
+		FRejectPortal &back = Portals[counts[line->backsector - sectors]++];
+		back.x1 = x2;
+		back.y1 = y2;
+		back.dx = x1 - x2;
+		back.dy = y1 - y2;
+		back.Slack = slack;
+		back.ToSector = int(line->frontsector - sectors);
+	}
+
+	for (i = 0; i < numsectors; ++i)
+	{
+		if (SeesAll[i]) OddSectors.Push (i);
+	}
+	RowBytes = (numsectors + 7) >> 3;
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: MarkOpenSectors
+//
+// A sector is closed if, walking its lines with the sector on the right,
+// every vertex is entered as often as it is left. Vertices are compared by
+// position, since maps often have several vertices at the same spot.
+//
+//==========================================================================
+
+struct FRejectVertexUse
+{
+	int Sector;
+	fixed_t x, y;
+	int Delta;		// +1 for each line leaving the vertex, -1 for each entering
+};
+
+static int STACK_ARGS CompareVertexUses (const void *a, const void *b)
+{
+	const FRejectVertexUse *va = (const FRejectVertexUse *)a;
+	const FRejectVertexUse *vb = (const FRejectVertexUse *)b;
+
+	if (va->Sector != vb->Sector) return va->Sector < vb->Sector ? -1 : 1;
+	if (va->x != vb->x) return va->x < vb->x ? -1 : 1;
+	if (va->y != vb->y) return va->y < vb->y ? -1 : 1;
+	return 0;
+}
+
+void FRejectBuilder::MarkOpenSectors ()
+{
+	TArray<FRejectVertexUse> uses;
+	FRejectVertexUse use;
+	int i;
+
+	for (i = 0; i < numlines; ++i)
+	{
+		line_t *line = &lines[i];
+		for (int side = 0; side < 2; ++side)
+		{
+			sector_t *sec = side == 0 ? line->frontsector : line->backsector;
+			if (sec == NULL)
+			{
+				continue;
+			}
+			vertex_t *from = side == 0 ? line->v1 : line->v2;
+			vertex_t *to = side == 0 ? line->v2 : line->v1;
+
+			use.Sector = int(sec - sectors);
+			use.x = from->x;
+			use.y = from->y;
+			use.Delta = 1;
+			uses.Push (use);
+			use.x = to->x;
+			use.y = to->y;
+			use.Delta = -1;
+			uses.Push (use);
+		}
+	}
+	if (uses.Size() == 0)
+	{
+		return;
+	}
+	qsort (&uses[0], uses.Size(), sizeof(FRejectVertexUse), CompareVertexUses);
+
+	for (unsigned int j = 0; j < uses.Size(); )
+	{
+		unsigned int k = j;
+		int balance = 0;
+		for (; k < uses.Size() && CompareVertexUses (&uses[j], &uses[k]) == 0; ++k)
+		{
+			balance += uses[k].Delta;
+		}
+		if (balance != 0)
+		{
+			SeesAll[uses[j].Sector] = true;
+		}
+		j = k;
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: MarkMisassignedSectors
+//
+// An actor's sector comes from the subsector it is in, which takes it from
+// its first seg. If the other segs of the subsector belong to sidedefs of
+// different sectors, the sectors' lines do not bound the areas actors can
+// be in, so none of the sectors involved can be rejected.
+//
+//==========================================================================
+
+void FRejectBuilder::MarkMisassignedSectors ()
+{
+	for (int i = 0; i < numsubsectors; ++i)
+	{
+		subsector_t *sub = &subsectors[i];
+		sector_t *sec = NULL;
+
+		for (DWORD j = 0; j < sub->numlines; ++j)
+		{
+			side_t *side = sub->firstline[j].sidedef;
+			if (side == NULL || side->sector == NULL)
+			{
+				continue;	// a GL miniseg or a broken sidedef
+			}
+			if (sec == NULL)
+			{
+				sec = side->sector;
+			}
+			else if (side->sector != sec)
+			{
+				SeesAll[sec - sectors] = true;
+				SeesAll[side->sector - sectors] = true;
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: CanFollow
+//
+// Returns false if no straight line that crosses p can cross r after it.
+// Lines that only touch are allowed, so that this errs on the safe side.
+// Side() is scaled by the length of the line it is called on, so is the
+// tolerance.
+//
+//==========================================================================
+
+bool FRejectBuilder::CanFollow (const FRejectPortal &p, const FRejectPortal &r)
+{
+	// Some part of r must be beyond p...
+	if (p.Side (r.x1, r.y1) < -p.Slack && p.Side (r.x1 + r.dx, r.y1 + r.dy) < -p.Slack)
+	{
+		return false;
+	}
+	// ...and some part of p must be before r.
+	if (r.Side (p.x1, p.y1) > r.Slack && r.Side (p.x1 + p.dx, p.y1 + p.dy) > r.Slack)
+	{
+		return false;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: Reach
+//
+// Adds a sector to the flood. The lines of the sectors in SeesAll do not
+// bound their areas properly, so a sight line that enters one of them may
+// leave through the lines of any other. Reaching one reaches them all.
+//
+//==========================================================================
+
+void FRejectBuilder::Reach (int sector, BYTE *row, TArray<int> &stamps, int stamp, TArray<int> &queue) const
+{
+	stamps[sector] = stamp;
+	row[sector >> 3] |= 1 << (sector & 7);
+	queue.Push (sector);
+
+	if (SeesAll[sector])
+	{
+		for (unsigned int i = 0; i < OddSectors.Size(); ++i)
+		{
+			int odd = OddSectors[i];
+			if (stamps[odd] != stamp)
+			{
+				stamps[odd] = stamp;
+				row[odd >> 3] |= 1 << (odd & 7);
+				queue.Push (odd);
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: BuildRow
+//
+// Sets the bits of all sectors that may be visible from the given one.
+// stamps must have one entry per sector and is used to mark the sectors
+// that were already flooded for the current line.
+//
+//==========================================================================
+
+void FRejectBuilder::BuildRow (int sector, BYTE *row, TArray<int> &stamps, int &stamp, TArray<int> &queue) const
+{
+	if (SeesAll[sector])
+	{
+		memset (row, 0xFF, RowBytes);
+		return;
+	}
+
+	memset (row, 0, RowBytes);
+	row[sector >> 3] |= 1 << (sector & 7);
+
+	for (int i = FirstPortal[sector]; i < FirstPortal[sector + 1]; ++i)
+	{
+		const FRejectPortal &p = Portals[i];
+
+		++stamp;
+		queue.Clear ();
+		Reach (p.ToSector, row, stamps, stamp, queue);
+
+		for (unsigned int q = 0; q < queue.Size(); ++q)
+		{
+			int from = queue[q];
+			for (int j = FirstPortal[from]; j < FirstPortal[from + 1]; ++j)
+			{
+				const FRejectPortal &r = Portals[j];
+				if (stamps[r.ToSector] != stamp && CanFollow (p, r))
+				{
+					Reach (r.ToSector, row, stamps, stamp, queue);
+				}
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// Identifies the geometry the table was built from. The map checksum
+// does not cover the vertices of binary maps, so they are hashed here,
+// along with the sectors the subsectors' segs belong to, since those
+// depend on the nodes in use.
+//
+//==========================================================================
+
+static DWORD RejectGeometryCRC ()
+{
+	DWORD crc = 0;
+
+	for (int i = 0; i < numlines; ++i)
+	{
+		DWORD data[6] =
+		{
+			LittleLong(DWORD(lines[i].v1->x)), LittleLong(DWORD(lines[i].v1->y)),
+			LittleLong(DWORD(lines[i].v2->x)), LittleLong(DWORD(lines[i].v2->y)),
+			LittleLong(DWORD(lines[i].frontsector != NULL ? lines[i].frontsector - sectors : -1)),
+			LittleLong(DWORD(lines[i].backsector != NULL ? lines[i].backsector - sectors : -1))
+		};
+		crc = AddCRC32 (crc, (const BYTE *)data, sizeof(data));
+	}
+	for (int i = 0; i < numsubsectors; ++i)
+	{
+		for (DWORD j = 0; j < subsectors[i].numlines; ++j)
+		{
+			side_t *side = subsectors[i].firstline[j].sidedef;
+			DWORD sec = LittleLong(DWORD(side != NULL && side->sector != NULL ? side->sector - sectors : -1));
+			crc = AddCRC32 (crc, (const BYTE *)&sec, sizeof(sec));
+		}
+	}
+	return crc;
+}
+
+//==========================================================================
+//
+// Cache files consist of the magic, the sector and line counts, the map
+// checksum, the geometry CRC, the uncompressed size, a CRC32 of the rest
+// of the file and the zlib compressed table.
+//
+//==========================================================================
+
+static void MakeRejectHeader (MapData *map, BYTE header[REJECT_HEADER], DWORD geometry, DWORD size)
+{
+	DWORD counts[2] = { LittleLong(DWORD(numsectors)), LittleLong(DWORD(numlines)) };
+
+	memcpy (header, REJECT_MAGIC, 4);
+	memcpy (header + 4, counts, 8);
+	map->GetChecksum (header + 12);
+	geometry = LittleLong(geometry);
+	memcpy (header + 28, &geometry, 4);
+	size = LittleLong(size);
+	memcpy (header + 32, &size, 4);
+	memset (header + 36, 0, 4);
+}
+
+static bool LoadCachedReject (MapData *map, const FString &path, DWORD geometry, int size)
+{
+	TArray<BYTE> data;
+	BYTE header[REJECT_HEADER];
+
+	if (!P_ReadCacheFile (path, data))
+	{
+		return false;
+	}
+
+	MakeRejectHeader (map, header, geometry, size);
+	if (data.Size() > REJECT_HEADER && memcmp (&data[0], header, REJECT_HEADER - 4) == 0 &&
+		LittleLong(*(DWORD *)&data[REJECT_HEADER - 4]) == CalcCRC32 (&data[REJECT_HEADER], data.Size() - REJECT_HEADER))
+	{
+		uLongf outlen = size;
+		rejectmatrix = new BYTE[size];
+		if (uncompress (rejectmatrix, &outlen, &data[REJECT_HEADER], data.Size() - REJECT_HEADER) == Z_OK &&
+			outlen == uLongf(size))
+		{
+			return true;
+		}
+		delete[] rejectmatrix;
+		rejectmatrix = NULL;
+	}
+	DPrintf ("Reject cache %s is out of date or damaged\n", path.GetChars());
+	remove (path);
+	return false;
+}
+
+static void CacheReject (MapData *map, const FString &path, DWORD geometry, int size)
+{
+	uLongf outlen = compressBound (size);
+	BYTE *data = new BYTE[REJECT_HEADER + outlen];
+
+	if (compress (data + REJECT_HEADER, &outlen, rejectmatrix, size) == Z_OK)
+	{
+		MakeRejectHeader (map, data, geometry, size);
+		DWORD crc = LittleLong(CalcCRC32 (data + REJECT_HEADER, outlen));
+		memcpy (data + REJECT_HEADER - 4, &crc, 4);
+		P_WriteCacheFile (path, data, REJECT_HEADER + outlen);
+	}
+	delete[] data;
+}
+
+//==========================================================================
+//
+// P_BuildReject
+//
+// Called by P_LoadReject if the map has no usable REJECT lump. Returns
+// true if rejectmatrix was set up.
+//
+//==========================================================================
+
+bool P_BuildReject (MapData *map)
+{
+	if (!genreject || numsectors <= 1 || numsectors > REJECT_MAXSECTORS)
+	{
+		return false;
+	}
+
+	const int size = (numsectors * numsectors + 7) >> 3;
+	DWORD geometry = RejectGeometryCRC ();
+	FString path = P_GetCacheName (map, ".rej", false);
+
+	if (LoadCachedReject (map, path, geometry, size))
+	{
+		return true;
+	}
+
+	cycle_t buildtime;
+	buildtime.Reset ();
+	buildtime.Clock ();
+
+	FRejectBuilder builder;
+	builder.Init ();
+
+	// Rows are built byte aligned on the worker threads and packed into
+	// the REJECT layout afterwards.
+	TArray<BYTE> rows;
+	rows.Resize (builder.RowBytes * numsectors);
+
+	WorkerPool.ParallelFor ((numsectors + REJECT_BATCH - 1) / REJECT_BATCH, [&](unsigned int batch)
+	{
+		TArray<int> stamps, queue;
+		int stamp = 0;
+		int end = MIN<int> (numsectors, (batch + 1) * REJECT_BATCH);
+
+		stamps.Resize (numsectors);
+		memset (&stamps[0], 0, numsectors * sizeof(int));
+		for (int i = batch * REJECT_BATCH; i < end; ++i)
+		{
+			builder.BuildRow (i, &rows[i * builder.RowBytes], stamps, stamp, queue);
+		}
+	});
+
+	// A set bit in REJECT means the sectors cannot see each other. Anything
+	// that sees everything can also be seen by everything.
+	rejectmatrix = new BYTE[size];
+	memset (rejectmatrix, 0, size);
+	int rejected = 0;
+	for (int i = 0; i < numsectors; ++i)
+	{
+		const BYTE *row = &rows[i * builder.RowBytes];
+		for (int j = 0; j < numsectors; ++j)
+		{
+			if (!(row[j >> 3] & (1 << (j & 7))) && !builder.SeesAll[j])
+			{
+				unsigned int bit = unsigned(i) * numsectors + j;
+				rejectmatrix[bit >> 3] |= 1 << (bit & 7);
+				rejected++;
+			}
+		}
+	}
+
+	buildtime.Unclock ();
+	DPrintf ("REJECT generation took %.3f sec (%.1f%% of sector pairs rejected)\n",
+		buildtime.TimeMS() * 0.001, rejected * 100. / (double(numsectors) * numsectors));
+
+	CacheReject (map, P_GetCacheName (map, ".rej", true), geometry, size);
+	return true;
+}
@@ -115,6 +115,9 @@ CVAR (Bool, genblockmap, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, gennodes, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, genglnodes, false, CVAR_SERVERINFO);
 CVAR (Bool, showloadtimes, false, 0);
+// Iteration order differs from blocklinks, which changes gameplay. So this is
+// server info, which demos record, and is latched until the next new game.
+CVAR (Bool, compactblockmap, false, CVAR_ARCHIVE|CVAR_SERVERINFO|CVAR_LATCH);
 
 static void P_InitTagLists ();
 static void P_Shutdown ();
@@ -200,6 +203,7 @@ FBlockNode**	blocklinks;		// for thing chains
 //	used as a PVS lookup as well.
 //
 BYTE*			rejectmatrix;
+bool			rejectbuilt;
 
 bool		ForceNodeBuild;
 
@@ -3180,6 +3184,15 @@ void P_LoadBlockMap (MapData * map)
 	memset (blocklinks, 0, count*sizeof(*blocklinks));
 	blockmap = blockmaplump+4;
 
+	if (compactblockmap)
+	{
+		CompactBlockmap.Init ();
+	}
+	else
+	{
+		CompactBlockmap.Clear ();
+	}
+
 	// [BC] Also, build the node list for the bot pathing module.
 	// [K6/BB] This is handled in CSkullBot(), unless we already have bots in game (from the previous map).
 	if (( NETWORK_InClientMode() == false ) &&
@@ -3391,6 +3404,8 @@ void P_LoadReject (MapData * map, bool junk)
 	const int neededsize = (numsectors * numsectors + 7) >> 3;
 	int rejectsize;
 
+	rejectbuilt = false;
+
 	if (strnicmp (map->MapLumps[ML_REJECT].Name, "REJECT", 8) != 0)
 	{
 		rejectsize = 0;
@@ -3408,6 +3423,7 @@ void P_LoadReject (MapData * map, bool junk)
 				neededsize-rejectsize==1?"":"s");
 		}
 		rejectmatrix = NULL;
+		rejectbuilt = P_BuildReject (map);
 	}
 	else
 	{
@@ -3443,6 +3459,7 @@ void P_LoadReject (MapData * map, bool junk)
 		// Reject has no data, so pretend it isn't there.
 		delete[] rejectmatrix;
 		rejectmatrix = NULL;
+		rejectbuilt = P_BuildReject (map);
 	}
 }
 
@@ -3830,6 +3847,7 @@ void P_FreeLevelData ()
 		delete[] blocklinks;
 		blocklinks = NULL;
 	}
+	CompactBlockmap.Clear ();
 	if (PolyBlockMap != NULL)
 	{
 		for (int i = bmapwidth*bmapheight-1; i >= 0; --i)
@@ -3850,6 +3868,7 @@ void P_FreeLevelData ()
 		delete[] rejectmatrix;
 		rejectmatrix = NULL;
 	}
+	rejectbuilt = false;
 	if (linebuffer != NULL)
 	{
 		delete[] linebuffer;
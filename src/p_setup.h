@@ -126,6 +126,10 @@ fixed_t GetUDMFFixed(int type, int index, const char *key);
 bool P_LoadGLNodes(MapData * map);
 bool P_CheckNodes(MapData * map, bool rebuilt, int buildtime);
 bool P_CheckForGLNodes();
+FString P_GetCacheName(MapData *map, const char *ext, bool create);
+bool P_ReadCacheFile(const char *path, TArray<BYTE> &data);
+bool P_WriteCacheFile(const char *path, const BYTE *data, size_t len);
+bool P_BuildReject(MapData *map);
 void P_SetRenderSector();
 
 
@@ -24,10 +24,40 @@
 #include "r_state.h"
 
 #include "stats.h"
+#include "c_cvars.h"
+#include "network.h"
 
 static FRandom pr_botchecksight ("BotCheckSight");
 static FRandom pr_checksight ("CheckSight");
 
+// Remembers the results of sight traces within a tic. The trace only depends
+// on the positions of both actors and the level geometry, so an entry is
+// valid as long as neither actor moved and no sector, polyobject or line
+// that could block sight changed since it was made (see P_InvalidateSightCache).
+CVAR (Bool, sightcache, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+enum
+{
+	SIGHTCACHE_SIZE = 2048,		// must be a power of 2
+	// Every flag SightCheck looks at must be part of the key.
+	SIGHTCACHE_FLAGS = SF_SEEPASTSHOOTABLELINES|SF_SEEPASTBLOCKEVERYTHING|SF_IGNOREWATERBOUNDARY,
+};
+
+struct FSightCacheEntry
+{
+	const AActor *t1, *t2;
+	const sector_t *sector1;
+	fixed_t x1, y1, z1, height1;
+	fixed_t x2, y2, z2, height2;
+	DWORD stamp;
+	int flags;
+	bool result;
+};
+
+static FSightCacheEntry SightCache[SIGHTCACHE_SIZE];
+static DWORD SightCacheStamp = 1;
+static int SightCacheHits, SightCacheMisses;
+
 /*
 ==============================================================================
 
@@ -42,6 +72,7 @@ This uses specialized forms of the maputils routines for optimized performance
 static int sightcounts[6];
 static cycle_t SightCycles;
 static cycle_t MaxSightCycles;
+static int SightChecks, SightRejects;
 
 static TArray<intercept_t> intercepts (128);
 
@@ -655,6 +686,7 @@ bool P_CheckSight (const AActor *t1, const AActor *t2, int flags)
 	SightCycles.Clock();
 
 	bool res;
+	FSightCacheEntry *entry = NULL;
 
 	assert (t1 != NULL);
 	assert (t2 != NULL);
@@ -667,13 +699,16 @@ bool P_CheckSight (const AActor *t1, const AActor *t2, int flags)
 	const sector_t *s2 = t2->Sector;
 	int pnum = int(s1 - sectors) * numsectors + int(s2 - sectors);
 
+	SightChecks++;
+
 //
 // check for trivial rejection
 //
-	if (rejectmatrix != NULL &&
+	if (rejectmatrix != NULL && !rejectbuilt &&
 		(rejectmatrix[pnum>>3] & (1 << (pnum & 7))))
 	{
 sightcounts[0]++;
+		SightRejects++;
 		res = false;			// can't possibly be connected
 		goto done;
 	}
@@ -692,6 +727,15 @@ sightcounts[0]++;
 		}
 	}
 
+	// A generated REJECT is only checked now, so that it doesn't change
+	// how often pr_checksight is called.
+	if (rejectbuilt && (rejectmatrix[pnum>>3] & (1 << (pnum & 7))))
+	{
+		SightRejects++;
+		res = false;
+		goto done;
+	}
+
 	// killough 4/19/98: make fake floors and ceilings block monster view
 
 	if (!(flags & SF_IGNOREWATERBOUNDARY))
@@ -716,12 +760,48 @@ sightcounts[0]++;
 	// An unobstructed LOS is possible.
 	// Now look from eyes of t1 to any part of t2.
 
+	// Clients don't get told about every sector change, so they always trace.
+	if (sightcache && !NETWORK_InClientMode())
+	{
+		size_t hash = ((size_t)t1 >> 3) * 31 + ((size_t)t2 >> 3) + (flags & SIGHTCACHE_FLAGS);
+		entry = &SightCache[(hash ^ (hash >> 11)) & (SIGHTCACHE_SIZE - 1)];
+
+		if (entry->stamp == SightCacheStamp && entry->t1 == t1 && entry->t2 == t2 &&
+			entry->flags == (flags & SIGHTCACHE_FLAGS) && entry->sector1 == t1->Sector &&
+			entry->x1 == t1->x && entry->y1 == t1->y && entry->z1 == t1->z && entry->height1 == t1->height &&
+			entry->x2 == t2->x && entry->y2 == t2->y && entry->z2 == t2->z && entry->height2 == t2->height)
+		{
+			SightCacheHits++;
+			res = entry->result;
+			goto done;
+		}
+	}
+
 	validcount++;
 	{
 		SightCheck s(t1, t2, flags);
 		res = s.P_SightPathTraverse (t1->x, t1->y, t2->x, t2->y);
 	}
 
+	if (entry != NULL)
+	{
+		SightCacheMisses++;
+		entry->t1 = t1;
+		entry->t2 = t2;
+		entry->sector1 = t1->Sector;
+		entry->x1 = t1->x;
+		entry->y1 = t1->y;
+		entry->z1 = t1->z;
+		entry->height1 = t1->height;
+		entry->x2 = t2->x;
+		entry->y2 = t2->y;
+		entry->z2 = t2->z;
+		entry->height2 = t2->height;
+		entry->flags = flags & SIGHTCACHE_FLAGS;
+		entry->stamp = SightCacheStamp;
+		entry->result = res;
+	}
+
 done:
 	SightCycles.Unclock();
 	return res;
@@ -736,6 +816,43 @@ ADD_STAT (sight)
 	return out;
 }
 
+ADD_STAT (reject)
+{
+	FString out;
+	out.Format ("%s REJECT, %d checks, %d rejected (%.1f%%)",
+		rejectmatrix == NULL ? "no" : rejectbuilt ? "generated" : "map",
+		SightChecks, SightRejects, SightChecks > 0 ? SightRejects * 100. / SightChecks : 0.);
+	return out;
+}
+
+ADD_STAT (sightcache)
+{
+	FString out;
+	int total = SightCacheHits + SightCacheMisses;
+	out.Format ("%d traces, %d hits, %d misses (%.1f%% hit rate)",
+		total, SightCacheHits, SightCacheMisses, total > 0 ? SightCacheHits * 100. / total : 0.);
+	return out;
+}
+
+//==========================================================================
+//
+// P_InvalidateSightCache
+//
+// Called at the start of every tic and whenever something that can block
+// sight changes, like a moving sector plane or polyobject.
+//
+//==========================================================================
+
+void P_InvalidateSightCache ()
+{
+	if (++SightCacheStamp == 0)
+	{
+		// The stamp wrapped around, so old entries could look valid again.
+		memset (SightCache, 0, sizeof(SightCache));
+		SightCacheStamp = 1;
+	}
+}
+
 void P_ResetSightCounters (bool full)
 {
 	if (full)
@@ -748,6 +865,7 @@ void P_ResetSightCounters (bool full)
 	}
 	SightCycles.Reset();
 	memset (sightcounts, 0, sizeof(sightcounts));
+	SightCacheHits = SightCacheMisses = 0;
 }
 
 
@@ -1910,6 +1910,35 @@ void DScroller::Tick ()
 	}
 }
 
+//-----------------------------------------------------------------------------
+//
+// Every scroller only moves the offsets of one sidedef, one plane or one
+// carrying sector. Reading the control sector's height is fine, since
+// scrollers don't move planes.
+//
+//-----------------------------------------------------------------------------
+
+const void *DScroller::GetParallelTickKey () const
+{
+	switch (m_Type)
+	{
+	case sc_side:
+		return &sides[m_Affectee];
+
+	case sc_floor:
+		return &sectors[m_Affectee].planes[sector_t::floor];
+
+	case sc_ceiling:
+		return &sectors[m_Affectee].planes[sector_t::ceiling];
+
+	case sc_carry:
+		return &level.Scrolls[m_Affectee];
+
+	default:
+		return this;
+	}
+}
+
 //*****************************************************************************
 //
 void DScroller::UpdateToClient( ULONG ulClient )
@@ -71,6 +71,9 @@ public:
 	void Serialize (FArchive &arc);
 	void Tick ();
 
+	const void *GetParallelTickKey () const;
+	bool CanTickInParallel () const { return true; }
+
 	bool AffectsWall (int wallnum) const { return m_Type == sc_side && m_Affectee == wallnum; }
 	int GetWallNum () const { return m_Type == sc_side ? m_Affectee : -1; }
 	void SetRate (fixed_t dx, fixed_t dy) { m_dx = dx; m_dy = dy; }
@@ -252,6 +255,9 @@ class DLighting : public DSectorEffect
 public:
 	DLighting (sector_t *sector);
 
+	// Lights only change the light level of their own sector.
+	const void *GetParallelTickKey () const { return m_Sector; }
+
 	// [BB] Necessary for GAME_ResetMap
 	bool bNotMapSpawned;
 protected:
@@ -266,6 +272,8 @@ public:
 	DFireFlicker (sector_t *sector, int upper, int lower);
 	void		Serialize (FArchive &arc);
 	void		Tick ();
+	// Needs a random number when the count runs out.
+	bool		CanTickInParallel () const { return m_Count != 1; }
 
 	// [BC] Create this object for this new client entering the game.
 	void	UpdateToClient( ULONG ulClient );
@@ -284,6 +292,7 @@ public:
 	DFlicker (sector_t *sector, int upper, int lower);
 	void		Serialize (FArchive &arc);
 	void		Tick ();
+	bool		CanTickInParallel () const { return m_Count != 0; }
 
 	// [BC] Create this object for this new client entering the game.
 	void	UpdateToClient( ULONG ulClient );
@@ -303,6 +312,7 @@ public:
 	DLightFlash (sector_t *sector, int min, int max);
 	void		Serialize (FArchive &arc);
 	void		Tick ();
+	bool		CanTickInParallel () const { return m_Count != 1; }
 
 	// [BC] Create this object for this new client entering the game.
 	void	UpdateToClient( ULONG ulClient );
@@ -327,6 +337,7 @@ public:
 	DStrobe (sector_t *sector, int upper, int lower, int utics, int ltics);
 	void		Serialize (FArchive &arc);
 	void		Tick ();
+	bool		CanTickInParallel () const { return true; }
 
 	// [BC] Create this object for this new client entering the game.
 	void	UpdateToClient( ULONG ulClient );
@@ -350,6 +361,7 @@ public:
 	DGlow (sector_t *sector);
 	void		Serialize (FArchive &arc);
 	void		Tick ();
+	bool		CanTickInParallel () const { return true; }
 
 	// [BC] Create this object for this new client entering the game.
 	void		UpdateToClient( ULONG ulClient );
@@ -369,6 +381,8 @@ public:
 	DGlow2 (sector_t *sector, int start, int end, int tics, bool oneshot);
 	void		Serialize (FArchive &arc);
 	void		Tick ();
+	// Destroys itself when a one-shot fade is done.
+	bool		CanTickInParallel () const { return !m_OneShot || m_Tics < m_MaxTics; }
 
 	// [BC] Create this object for this new client entering the game.
 	void		UpdateToClient( ULONG ulClient );
@@ -394,6 +408,7 @@ public:
 	DPhased (sector_t *sector, int baselevel, int phase);
 	void		Serialize (FArchive &arc);
 	void		Tick ();
+	bool		CanTickInParallel () const { return true; }
 
 	// [BC] Create this object for this new client entering the game.
 	void		UpdateToClient( ULONG ulClient );
@@ -121,6 +121,9 @@ void P_Ticker (void)
 
 	P_NewPspriteTick();
 
+	// Sight check results are only reused within the same tic.
+	P_InvalidateSightCache();
+
 	// [BC] Server doesn't need any of this.
 	if ( NETWORK_GetState( ) != NETSTATE_SERVER )
 	{
@@ -46,9 +46,16 @@
 #include "r_state.h"
 #include "r_data/colormaps.h"
 #include "w_wad.h"
+#include "md5.h"
+#include "c_cvars.h"
 // [BB] New #includes.
 #include "g_game.h"
 
+// Tokenized TEXTMAP lumps at least this big are cached.
+#define UDMF_MINCACHESIZE	(256*1024)
+
+CVAR (Bool, udmf_cachemaps, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
 //===========================================================================
 //
 // Maps for Hexen namespace need to filter out all extended line and sector
@@ -188,7 +195,7 @@ void UDMFParserBase::Skip()
 FName UDMFParserBase::ParseKey(bool checkblock, bool *isblock)
 {
 	sc.MustGetString();
-	FName key = sc.String;
+	FName key = sc.GetName();
 	if (checkblock)
 	{
 		if (sc.CheckToken('{'))
@@ -1645,7 +1652,24 @@ public:
 		floordrop = false;
 
 		map->Read(ML_TEXTMAP, buffer);
-		sc.OpenMem(Wads.GetLumpFullName(map->lumpnum), buffer, map->Size(ML_TEXTMAP));
+
+		// Large maps keep their tokens in the cache directory.
+		bool usecache = udmf_cachemaps && map->Size(ML_TEXTMAP) >= UDMF_MINCACHESIZE;
+		BYTE md5[16];
+		if (usecache)
+		{
+			MD5Context context;
+			context.Update((const BYTE *)buffer, map->Size(ML_TEXTMAP));
+			context.Final(md5);
+		}
+		if (!usecache || !sc.OpenCache(Wads.GetLumpFullName(map->lumpnum), P_GetCacheName(map, ".udc", false), md5))
+		{
+			sc.OpenMem(Wads.GetLumpFullName(map->lumpnum), buffer, map->Size(ML_TEXTMAP));
+			if (usecache && sc.IsTokenized())
+			{
+				sc.SaveCache(P_GetCacheName(map, ".udc", true), md5);
+			}
+		}
 		delete [] buffer;
 		sc.SetCMode(true);
 		if (sc.CheckString("namespace"))
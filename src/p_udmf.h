@@ -5,10 +5,86 @@
 #include "m_fixed.h"
 #include "tables.h"
 
+//===========================================================================
+//
+// FUDMFScanner
+//
+// Implements the part of FScanner's interface the UDMF parsers use. Text
+// that sticks to the UDMF grammar is split into tokens in one go, with
+// numbers already converted and every distinct key turned into an FName
+// only once. The tokens can be stored in a cache file, so that the next
+// load of the same map does not need to look at the text at all. Anything
+// the tokenizer does not understand is handed to a regular FScanner.
+// Both assume C mode.
+//
+//===========================================================================
+
+class FUDMFScanner
+{
+public:
+	FUDMFScanner();
+
+	void OpenMem(const char *name, const char *buffer, int size);
+	bool OpenCache(const char *name, const char *path, const BYTE md5[16]);
+	void SaveCache(const char *path, const BYTE md5[16]) const;
+	bool IsTokenized() const { return !UseFallback; }
+
+	void SetCMode(bool cmode);
+
+	bool GetString();
+	void MustGetString();
+	void MustGetStringName(const char *name);
+	bool CheckString(const char *name);
+
+	bool GetToken();
+	void MustGetAnyToken();
+	void MustGetToken(int token);
+	bool CheckToken(int token);
+
+	void UnGet();
+	bool Compare(const char *text);
+	FName GetName();
+
+	void ScriptError(const char *message, ...);
+	void ScriptMessage(const char *message, ...);
+
+	const char *String;
+	int TokenType;
+	int Number;
+	double Float;
+
+private:
+	struct FToken
+	{
+		int Type;
+		int Line;
+		unsigned int Text;		// identifier index, or offset into TextPool
+		unsigned int Value;		// index into Values for numbers
+	};
+
+	TArray<FToken> Tokens;
+	TArray<double> Values;
+	TArray<char> TextPool;
+	TArray<unsigned int> IdentText;		// offsets of the identifiers' text
+	TArray<FName> Idents;
+	unsigned int Pos;
+	bool GotToken;			// the last token was read with GetToken
+	FString Work;
+	FString ScriptName;
+
+	FScanner Fallback;
+	bool UseFallback;
+
+	bool Tokenize(const char *buffer, int size);
+	void CopyFromFallback();
+	void SetString(const FToken &token, bool tokens);
+	int GetMessageLine() const;
+};
+
 class UDMFParserBase
 {
 protected:
-	FScanner sc;
+	FUDMFScanner sc;
 	FName namespc;
 	int namespace_bits;
 	FString parsedString;
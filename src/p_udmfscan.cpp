@@ -0,0 +1,708 @@
+/*
+** p_udmfscan.cpp
+** Tokenizer and token cache for UDMF text maps
+**
+** The UDMF grammar only knows identifiers, numbers, strings and a handful
+** of punctuation characters, so the whole lump is split into tokens in a
+** single pass instead of going through FScanner token by token. Numbers
+** are converted while doing so, and every distinct identifier is looked
+** up in the name table once instead of every time a key is parsed.
+**
+** Large maps store the tokens in the cache directory, keyed by the MD5 of
+** their TEXTMAP lump. The file holds the tokens, values and text in
+** native byte order behind a header with a CRC32, so loading it is little
+** more than a memcpy.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include "doomtype.h"
+#include "i_system.h"
+#include "cmdlib.h"
+#include "templates.h"
+#include "v_text.h"
+#include "m_crc32.h"
+#include "p_setup.h"
+#include "p_udmf.h"
+
+#define UDMFCACHE_MAGIC		"UDC1"
+#define UDMFCACHE_HEADER	40
+
+static inline bool IsIdentStart(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static inline bool IsIdentChar(char c)
+{
+	return IsIdentStart(c) || (c >= '0' && c <= '9');
+}
+
+static inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline bool IsHexDigit(char c)
+{
+	return IsDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+FUDMFScanner::FUDMFScanner()
+{
+	String = "";
+	TokenType = 0;
+	Number = 0;
+	Float = 0;
+	Pos = 0;
+	GotToken = false;
+	UseFallback = true;
+}
+
+//===========================================================================
+//
+// Splits the text into tokens. Returns false if it contains anything
+// that does not belong into a UDMF map, or that FScanner might treat
+// differently, like a keyword used as a value.
+//
+//===========================================================================
+
+bool FUDMFScanner::Tokenize(const char *buffer, int size)
+{
+	const char *p = buffer;
+	const char *end = buffer + size;
+	int line = 1;
+
+	// Distinct identifiers, hashed by their exact text.
+	TArray<int> identhash;
+	unsigned int hashmask = 1023;
+	identhash.Resize(hashmask + 1);
+	memset(&identhash[0], -1, identhash.Size() * sizeof(int));
+
+	Tokens.Clear();
+	Values.Clear();
+	TextPool.Clear();
+	IdentText.Clear();
+	Idents.Clear();
+
+	for (;;)
+	{
+		// Skip whitespace and comments.
+		while (p < end)
+		{
+			if (*p == '\n')
+			{
+				line++;
+				p++;
+			}
+			else if ((unsigned char)*p <= ' ')
+			{
+				p++;
+			}
+			else if (*p == '/' && p + 1 < end && p[1] == '/')
+			{
+				while (p < end && *p != '\n') p++;
+			}
+			else if (*p == '/' && p + 1 < end && p[1] == '*')
+			{
+				for (p += 2; p < end && !(p[0] == '*' && p + 1 < end && p[1] == '/'); p++)
+				{
+					if (*p == '\n') line++;
+				}
+				if (p >= end) return false;
+				p += 2;
+			}
+			else break;
+		}
+		if (p >= end)
+		{
+			break;
+		}
+
+		FToken token;
+		const char *start = p;
+		token.Line = line;
+		token.Text = 0;
+		token.Value = 0;
+
+		if (IsIdentStart(*p))
+		{
+			unsigned int hash = 2166136261u;
+			while (p < end && IsIdentChar(*p))
+			{
+				hash = (hash ^ (BYTE)*p) * 16777619u;
+				p++;
+			}
+			size_t len = p - start;
+
+			unsigned int slot = hash & hashmask;
+			int index;
+			while ((index = identhash[slot]) >= 0)
+			{
+				const char *text = &TextPool[IdentText[index]];
+				if (strncmp(text, start, len) == 0 && text[len] == 0) break;
+				slot = (slot + 1) & hashmask;
+			}
+			if (index < 0)
+			{
+				index = IdentText.Push(TextPool.Size());
+				TextPool.Reserve(len + 1);
+				memcpy(&TextPool[IdentText[index]], start, len);
+				TextPool[IdentText[index] + len] = 0;
+				identhash[slot] = index;
+
+				if (IdentText.Size() * 2 > hashmask)
+				{
+					// Rehash into a table twice as big.
+					hashmask = hashmask * 2 + 1;
+					identhash.Resize(hashmask + 1);
+					memset(&identhash[0], -1, identhash.Size() * sizeof(int));
+					for (unsigned int i = 0; i < IdentText.Size(); ++i)
+					{
+						unsigned int h = 2166136261u;
+						for (const char *c = &TextPool[IdentText[i]]; *c != 0; ++c)
+						{
+							h = (h ^ (BYTE)*c) * 16777619u;
+						}
+						for (slot = h & hashmask; identhash[slot] >= 0; slot = (slot + 1) & hashmask)
+						{
+						}
+						identhash[slot] = i;
+					}
+				}
+			}
+			token.Text = index;
+			token.Type = (len == 4 && strnicmp(start, "true", 4) == 0) ? TK_True :
+						(len == 5 && strnicmp(start, "false", 5) == 0) ? TK_False : TK_Identifier;
+		}
+		else if (IsDigit(*p) || (*p == '.' && p + 1 < end && IsDigit(p[1])) ||
+			(*p == '-' && p + 1 < end && (IsDigit(p[1]) || (p[1] == '.' && p + 2 < end && IsDigit(p[2])))))
+		{
+			bool isfloat = false;
+
+			if (*p == '-') p++;
+			if (p + 2 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && IsHexDigit(p[2]))
+			{
+				for (p += 2; p < end && IsHexDigit(*p); p++)
+				{
+				}
+			}
+			else
+			{
+				while (p < end && IsDigit(*p)) p++;
+				if (p < end && *p == '.')
+				{
+					isfloat = true;
+					for (p++; p < end && IsDigit(*p); p++)
+					{
+					}
+				}
+				if (p + 1 < end && (*p == 'e' || *p == 'E'))
+				{
+					const char *e = p + 1;
+					if (e < end && (*e == '+' || *e == '-')) e++;
+					if (e < end && IsDigit(*e))
+					{
+						isfloat = true;
+						for (p = e; p < end && IsDigit(*p); p++)
+						{
+						}
+					}
+				}
+			}
+			// Suffixes and numbers running into names are left to FScanner.
+			if (p < end && (IsIdentChar(*p) || *p == '.'))
+			{
+				return false;
+			}
+
+			size_t len = p - start;
+			token.Text = TextPool.Reserve(len + 1);
+			memcpy(&TextPool[token.Text], start, len);
+			TextPool[token.Text + len] = 0;
+
+			const char *text = &TextPool[token.Text];
+			token.Type = isfloat ? TK_FloatConst : TK_IntConst;
+			token.Value = Values.Push(isfloat ? strtod(text, NULL) : double(int(strtol(text, NULL, 0))));
+		}
+		else if (*p == '"')
+		{
+			for (p++; p < end && *p != '"'; p++)
+			{
+				if (*p == '\\' && p + 1 < end && p[1] == '"')
+				{
+					p++;
+				}
+				else if (*p == '\n' || *p == '\r')
+				{
+					// FScanner's line counting differs between its modes here.
+					return false;
+				}
+			}
+			if (p >= end) return false;
+
+			size_t len = p - start - 1;
+			token.Text = TextPool.Reserve(len + 1);
+			memcpy(&TextPool[token.Text], start + 1, len);
+			TextPool[token.Text + len] = 0;
+			token.Type = TK_StringConst;
+			p++;
+		}
+		else if (*p == '{' || *p == '}' || *p == '=' || *p == ';' || *p == '+' || *p == '-')
+		{
+			token.Type = *p++;
+
+			// A bare word as a value could be one of FScanner's keywords.
+			unsigned int count = Tokens.Size();
+			if (token.Type == ';' && count >= 2 && Tokens[count - 1].Type == TK_Identifier &&
+				Tokens[count - 2].Type == '=')
+			{
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+		Tokens.Push(token);
+	}
+
+	Idents.Resize(IdentText.Size());
+	for (unsigned int i = 0; i < IdentText.Size(); ++i)
+	{
+		Idents[i] = &TextPool[IdentText[i]];
+	}
+	return true;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+void FUDMFScanner::OpenMem(const char *name, const char *buffer, int size)
+{
+	ScriptName = name;
+	Pos = 0;
+	GotToken = false;
+	UseFallback = !Tokenize(buffer, size);
+	if (UseFallback)
+	{
+		Tokens.Clear();
+		Values.Clear();
+		TextPool.Clear();
+		IdentText.Clear();
+		Idents.Clear();
+		Fallback.OpenMem(name, buffer, size);
+		Fallback.SetViewMode(true);
+	}
+}
+
+//===========================================================================
+//
+// Loads the tokens from a cache file. Returns false if there is none or
+// it does not belong to this text.
+//
+//===========================================================================
+
+bool FUDMFScanner::OpenCache(const char *name, const char *path, const BYTE md5[16])
+{
+	TArray<BYTE> data;
+
+	if (!P_ReadCacheFile(path, data))
+	{
+		return false;
+	}
+
+	DWORD counts[4];
+	if (data.Size() >= UDMFCACHE_HEADER && memcmp(&data[0], UDMFCACHE_MAGIC, 4) == 0 &&
+		memcmp(&data[4], md5, 16) == 0)
+	{
+		memcpy(counts, &data[20], sizeof(counts));
+		size_t size = UDMFCACHE_HEADER + size_t(counts[0]) * sizeof(FToken) + size_t(counts[1]) * sizeof(double) +
+			size_t(counts[2]) * sizeof(unsigned int) + counts[3];
+
+		if (counts[0] > 0 && counts[3] > 0 && size == data.Size() &&
+			*(DWORD *)&data[36] == CalcCRC32(&data[UDMFCACHE_HEADER], data.Size() - UDMFCACHE_HEADER))
+		{
+			const BYTE *p = &data[UDMFCACHE_HEADER];
+
+			Tokens.Resize(counts[0]);
+			memcpy(&Tokens[0], p, counts[0] * sizeof(FToken));
+			p += counts[0] * sizeof(FToken);
+			Values.Resize(counts[1]);
+			if (counts[1] > 0) memcpy(&Values[0], p, counts[1] * sizeof(double));
+			p += counts[1] * sizeof(double);
+			IdentText.Resize(counts[2]);
+			if (counts[2] > 0) memcpy(&IdentText[0], p, counts[2] * sizeof(unsigned int));
+			p += counts[2] * sizeof(unsigned int);
+			TextPool.Resize(counts[3]);
+			memcpy(&TextPool[0], p, counts[3]);
+
+			bool ok = TextPool[counts[3] - 1] == 0;
+			for (unsigned int i = 0; ok && i < counts[2]; ++i)
+			{
+				ok = IdentText[i] < counts[3];
+			}
+			for (unsigned int i = 0; ok && i < counts[0]; ++i)
+			{
+				const FToken &token = Tokens[i];
+				switch (token.Type)
+				{
+				case TK_Identifier:
+				case TK_True:
+				case TK_False:
+					ok = token.Text < counts[2];
+					break;
+				case TK_IntConst:
+				case TK_FloatConst:
+					ok = token.Text < counts[3] && token.Value < counts[1];
+					break;
+				case TK_StringConst:
+					ok = token.Text < counts[3];
+					break;
+				}
+			}
+			if (ok)
+			{
+				Idents.Resize(IdentText.Size());
+				for (unsigned int i = 0; i < IdentText.Size(); ++i)
+				{
+					Idents[i] = &TextPool[IdentText[i]];
+				}
+				ScriptName = name;
+				Pos = 0;
+				GotToken = false;
+				UseFallback = false;
+				return true;
+			}
+		}
+	}
+
+	DPrintf("UDMF cache %s is out of date or damaged\n", path);
+	Tokens.Clear();
+	Values.Clear();
+	TextPool.Clear();
+	IdentText.Clear();
+	Idents.Clear();
+	remove(path);
+	return false;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+void FUDMFScanner::SaveCache(const char *path, const BYTE md5[16]) const
+{
+	if (UseFallback)
+	{
+		return;
+	}
+
+	DWORD counts[4] = { Tokens.Size(), Values.Size(), IdentText.Size(), TextPool.Size() };
+	TArray<BYTE> data;
+
+	data.Resize(UDMFCACHE_HEADER + Tokens.Size() * sizeof(FToken) + Values.Size() * sizeof(double) +
+		IdentText.Size() * sizeof(unsigned int) + TextPool.Size());
+
+	BYTE *p = &data[0];
+	memcpy(p, UDMFCACHE_MAGIC, 4);
+	memcpy(p + 4, md5, 16);
+	memcpy(p + 20, counts, sizeof(counts));
+	p += UDMFCACHE_HEADER;
+	memcpy(p, &Tokens[0], Tokens.Size() * sizeof(FToken));
+	p += Tokens.Size() * sizeof(FToken);
+	if (Values.Size() > 0) memcpy(p, &Values[0], Values.Size() * sizeof(double));
+	p += Values.Size() * sizeof(double);
+	if (IdentText.Size() > 0) memcpy(p, &IdentText[0], IdentText.Size() * sizeof(unsigned int));
+	p += IdentText.Size() * sizeof(unsigned int);
+	memcpy(p, &TextPool[0], TextPool.Size());
+
+	DWORD crc = CalcCRC32(&data[UDMFCACHE_HEADER], data.Size() - UDMFCACHE_HEADER);
+	memcpy(&data[36], &crc, 4);
+	P_WriteCacheFile(path, &data[0], data.Size());
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+void FUDMFScanner::SetCMode(bool cmode)
+{
+	if (UseFallback) Fallback.SetCMode(cmode);
+}
+
+void FUDMFScanner::CopyFromFallback()
+{
+	String = Fallback.String;
+	TokenType = Fallback.TokenType;
+	Number = Fallback.Number;
+	Float = Fallback.Float;
+}
+
+//===========================================================================
+//
+// Sets String the way FScanner would for this token. Strings keep their
+// escape sequences when read with GetString and lose them with GetToken.
+//
+//===========================================================================
+
+void FUDMFScanner::SetString(const FToken &token, bool tokens)
+{
+	switch (token.Type)
+	{
+	case TK_Identifier:
+	case TK_True:
+	case TK_False:
+		String = &TextPool[IdentText[token.Text]];
+		break;
+
+	case TK_IntConst:
+	case TK_FloatConst:
+		String = &TextPool[token.Text];
+		break;
+
+	case TK_StringConst:
+		Work = &TextPool[token.Text];
+		if (tokens)
+		{
+			strbin(Work.LockBuffer());
+			Work.UnlockBuffer();
+		}
+		else
+		{
+			Work.Substitute("\\\"", "\"");
+		}
+		String = Work;
+		break;
+
+	default:
+		Work = char(token.Type);
+		String = Work;
+		break;
+	}
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+bool FUDMFScanner::GetString()
+{
+	if (UseFallback)
+	{
+		bool res = Fallback.GetString();
+		CopyFromFallback();
+		return res;
+	}
+	if (Pos >= Tokens.Size())
+	{
+		return false;
+	}
+	GotToken = false;
+	SetString(Tokens[Pos++], false);
+	return true;
+}
+
+void FUDMFScanner::MustGetString()
+{
+	if (!GetString())
+	{
+		ScriptError("Missing string (unexpected end of file).");
+	}
+}
+
+void FUDMFScanner::MustGetStringName(const char *name)
+{
+	MustGetString();
+	if (!Compare(name))
+	{
+		ScriptError("Expected '%s', got '%s'.", name, String);
+	}
+}
+
+bool FUDMFScanner::CheckString(const char *name)
+{
+	if (GetString())
+	{
+		if (Compare(name))
+		{
+			return true;
+		}
+		UnGet();
+	}
+	return false;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+bool FUDMFScanner::GetToken()
+{
+	if (UseFallback)
+	{
+		bool res = Fallback.GetToken();
+		CopyFromFallback();
+		return res;
+	}
+	if (Pos >= Tokens.Size())
+	{
+		return false;
+	}
+
+	const FToken &token = Tokens[Pos++];
+	GotToken = true;
+	TokenType = token.Type;
+	if (token.Type == TK_IntConst)
+	{
+		Number = int(Values[token.Value]);
+		Float = Number;
+	}
+	else if (token.Type == TK_FloatConst)
+	{
+		Float = Values[token.Value];
+	}
+	SetString(token, true);
+	return true;
+}
+
+void FUDMFScanner::MustGetAnyToken()
+{
+	if (!GetToken())
+	{
+		ScriptError("Missing token (unexpected end of file).");
+	}
+}
+
+void FUDMFScanner::MustGetToken(int token)
+{
+	MustGetAnyToken();
+	if (TokenType != token)
+	{
+		FString tok1 = FScanner::TokenName(token);
+		FString tok2 = FScanner::TokenName(TokenType, String);
+		ScriptError("Expected %s but got %s instead.", tok1.GetChars(), tok2.GetChars());
+	}
+}
+
+bool FUDMFScanner::CheckToken(int token)
+{
+	if (GetToken())
+	{
+		if (TokenType == token)
+		{
+			return true;
+		}
+		UnGet();
+	}
+	return false;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+void FUDMFScanner::UnGet()
+{
+	if (UseFallback)
+	{
+		Fallback.UnGet();
+	}
+	else if (Pos > 0)
+	{
+		Pos--;
+	}
+}
+
+bool FUDMFScanner::Compare(const char *text)
+{
+	return stricmp(text, String) == 0;
+}
+
+//===========================================================================
+//
+// Returns the last string as a name. Identifiers already have one.
+//
+//===========================================================================
+
+FName FUDMFScanner::GetName()
+{
+	if (!UseFallback && Pos > 0)
+	{
+		const FToken &token = Tokens[Pos - 1];
+		if (token.Type == TK_Identifier || token.Type == TK_True || token.Type == TK_False)
+		{
+			return Idents[token.Text];
+		}
+	}
+	return String;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+int FUDMFScanner::GetMessageLine() const
+{
+	if (Tokens.Size() == 0)
+	{
+		return 1;
+	}
+	return Tokens[MIN(Pos > 0 ? Pos - 1 : 0, Tokens.Size() - 1)].Line;
+}
+
+void FUDMFScanner::ScriptError(const char *message, ...)
+{
+	FString composed;
+	va_list arglist;
+
+	va_start(arglist, message);
+	composed.VFormat(message, arglist);
+	va_end(arglist);
+
+	if (UseFallback)
+	{
+		Fallback.ScriptError("%s", composed.GetChars());
+	}
+	I_Error("Script error, \"%s\" line %d:\n%s\n", ScriptName.GetChars(), GetMessageLine(), composed.GetChars());
+}
+
+void FUDMFScanner::ScriptMessage(const char *message, ...)
+{
+	FString composed;
+	va_list arglist;
+
+	va_start(arglist, message);
+	composed.VFormat(message, arglist);
+	va_end(arglist);
+
+	if (UseFallback)
+	{
+		Fallback.ScriptMessage("%s", composed.GetChars());
+		return;
+	}
+	Printf(TEXTCOLOR_RED "Script error, \"%s\" line %d:\n" TEXTCOLOR_RED "%s\n", ScriptName.GetChars(),
+		GetMessageLine(), composed.GetChars());
+}
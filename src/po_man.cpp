@@ -1630,6 +1630,9 @@ void FPolyObj::LinkPolyobj ()
 	polyblock_t **link;
 	polyblock_t *tempLink;
 
+	// The polyobject's lines may now block sight somewhere else.
+	P_InvalidateSightCache();
+
 	// calculate the polyobj bbox
 	Bounds.ClearBox();
 	for(unsigned i = 0; i < Sidedefs.Size(); i++)
@@ -40,6 +40,8 @@
 #include "i_system.h"
 #include "po_man.h"
 #include "farchive.h"
+#include "c_cvars.h"
+#include "workerpool.h"
 
 //==========================================================================
 //
@@ -196,8 +198,33 @@ int FInterpolator::CountInterpolations ()
 //
 //==========================================================================
 
+EXTERN_CVAR (Bool, parallelthinkers)
+
 void FInterpolator::UpdateInterpolations()
 {
+	// Every interpolation only copies the current position of what it
+	// interpolates into its own fields, so they can all be updated at once.
+	if (parallelthinkers && count >= 1024)
+	{
+		static TArray<DInterpolation *> list;
+
+		list.Clear();
+		for (DInterpolation *probe = Head; probe != NULL; probe = probe->Next)
+		{
+			list.Push(probe);
+		}
+		const unsigned int num = list.Size();
+		WorkerPool.ParallelFor ((num + 255) / 256, [num](unsigned int chunk)
+		{
+			const unsigned int end = MIN<unsigned int>(num, (chunk + 1) * 256);
+			for (unsigned int i = chunk * 256; i < end; ++i)
+			{
+				list[i]->UpdateInterpolation ();
+			}
+		});
+		return;
+	}
+
 	for (DInterpolation *probe = Head; probe != NULL; probe = probe->Next)
 	{
 		probe->UpdateInterpolation ();
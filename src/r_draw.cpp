@@ -46,6 +46,7 @@
 #include "gi.h"
 #include "stats.h"
 #include "x86.h"
+#include "r_drawsimd.h"
 
 #undef RANGECHECK
 
@@ -84,7 +85,18 @@ void (*R_DrawSpanTranslucent)(void);
 void (*R_DrawSpanMaskedTranslucent)(void);
 void (*R_DrawSpanAddClamp)(void);
 void (*R_DrawSpanMaskedAddClamp)(void);
+void (*R_DrawAddColumn)(void);
+void (*R_DrawAddClampColumn)(void);
+void (*R_DrawSubClampColumn)(void);
+void (*R_DrawRevSubClampColumn)(void);
 void (STACK_ARGS *rt_map4cols)(int,int,int);
+void (STACK_ARGS *rt_subclamp4cols)(int,int,int);
+void (STACK_ARGS *rt_revsubclamp4cols)(int,int,int);
+#ifndef X86_ASM
+void (STACK_ARGS *rt_add4cols)(int,int,int);
+void (STACK_ARGS *rt_addclamp4cols)(int,int,int);
+void (*R_SpanDrawers[NUM_SPANDRAWERS])(const FSpanDrawerArgs &args);
+#endif
 
 //
 // R_DrawColumn
@@ -1058,21 +1070,36 @@ void R_SetupSpanBits(FTexture *tex)
 #endif
 }
 
+//==========================================================================
+//
+// R_SetupSpanArgs
+//
+// Collects the span drawer globals, so the span can be drawn later.
+//
+//==========================================================================
+
+void R_SetupSpanArgs (FSpanDrawerArgs &args)
+{
+	args.dest = ylookup[ds_y] + ds_x1 + dc_destorg;
+	args.count = ds_x2 - ds_x1 + 1;
+	args.xfrac = ds_xfrac;
+	args.yfrac = ds_yfrac;
+	args.xstep = ds_xstep;
+	args.ystep = ds_ystep;
+	args.xbits = ds_xbits;
+	args.ybits = ds_ybits;
+	args.source = ds_source;
+	args.colormap = ds_colormap;
+	args.srcblend = dc_srcblend;
+	args.destblend = dc_destblend;
+	args.color = ds_color;
+}
+
 //
 // Draws the actual span.
 #ifndef X86_ASM
 void R_DrawSpanP_C (void)
 {
-	dsfixed_t			xfrac;
-	dsfixed_t			yfrac;
-	dsfixed_t			xstep;
-	dsfixed_t			ystep;
-	BYTE*				dest;
-	const BYTE*			source = ds_source;
-	const BYTE*			colormap = ds_colormap;
-	int 				count;
-	int 				spot;
-
 #ifdef RANGECHECK 
 	if (ds_x2 < ds_x1 || ds_x1 < 0
 		|| ds_x2 >= screen->width || ds_y > screen->height)
@@ -1081,18 +1108,34 @@ void R_DrawSpanP_C (void)
 	}
 //		dscount++;
 #endif
+	FSpanDrawerArgs args;
+	R_SetupSpanArgs (args);
+	R_DrawSpanP_C (args);
+}
 
-	xfrac = ds_xfrac;
-	yfrac = ds_yfrac;
+void R_DrawSpanP_C (const FSpanDrawerArgs &args)
+{
+	dsfixed_t			xfrac;
+	dsfixed_t			yfrac;
+	dsfixed_t			xstep;
+	dsfixed_t			ystep;
+	BYTE*				dest;
+	const BYTE*			source = args.source;
+	const BYTE*			colormap = args.colormap;
+	int 				count;
+	int 				spot;
 
-	dest = ylookup[ds_y] + ds_x1 + dc_destorg;
+	xfrac = args.xfrac;
+	yfrac = args.yfrac;
 
-	count = ds_x2 - ds_x1 + 1;
+	dest = args.dest;
 
-	xstep = ds_xstep;
-	ystep = ds_ystep;
+	count = args.count;
 
-	if (ds_xbits == 6 && ds_ybits == 6)
+	xstep = args.xstep;
+	ystep = args.ystep;
+
+	if (args.xbits == 6 && args.ybits == 6)
 	{
 		// 64x64 is the most common case by far, so special case it.
 		do
@@ -1111,9 +1154,9 @@ void R_DrawSpanP_C (void)
 	}
 	else
 	{
-		BYTE yshift = 32 - ds_ybits;
-		BYTE xshift = yshift - ds_xbits;
-		int xmask = ((1 << ds_xbits) - 1) << ds_ybits;
+		BYTE yshift = 32 - args.ybits;
+		BYTE xshift = yshift - args.xbits;
+		int xmask = ((1 << args.xbits) - 1) << args.ybits;
 
 		do
 		{
@@ -1133,28 +1176,35 @@ void R_DrawSpanP_C (void)
 
 // [RH] Draw a span with holes
 void R_DrawSpanMaskedP_C (void)
+{
+	FSpanDrawerArgs args;
+	R_SetupSpanArgs (args);
+	R_DrawSpanMaskedP_C (args);
+}
+
+void R_DrawSpanMaskedP_C (const FSpanDrawerArgs &args)
 {
 	dsfixed_t			xfrac;
 	dsfixed_t			yfrac;
 	dsfixed_t			xstep;
 	dsfixed_t			ystep;
 	BYTE*				dest;
-	const BYTE*			source = ds_source;
-	const BYTE*			colormap = ds_colormap;
+	const BYTE*			source = args.source;
+	const BYTE*			colormap = args.colormap;
 	int 				count;
 	int 				spot;
 
-	xfrac = ds_xfrac;
-	yfrac = ds_yfrac;
+	xfrac = args.xfrac;
+	yfrac = args.yfrac;
 
-	dest = ylookup[ds_y] + ds_x1 + dc_destorg;
+	dest = args.dest;
 
-	count = ds_x2 - ds_x1 + 1;
+	count = args.count;
 
-	xstep = ds_xstep;
-	ystep = ds_ystep;
+	xstep = args.xstep;
+	ystep = args.ystep;
 
-	if (ds_xbits == 6 && ds_ybits == 6)
+	if (args.xbits == 6 && args.ybits == 6)
 	{
 		// 64x64 is the most common case by far, so special case it.
 		do
@@ -1174,9 +1224,9 @@ void R_DrawSpanMaskedP_C (void)
 	}
 	else
 	{
-		BYTE yshift = 32 - ds_ybits;
-		BYTE xshift = yshift - ds_xbits;
-		int xmask = ((1 << ds_xbits) - 1) << ds_ybits;
+		BYTE yshift = 32 - args.ybits;
+		BYTE xshift = yshift - args.xbits;
+		int xmask = ((1 << args.xbits) - 1) << args.ybits;
 		do
 		{
 			BYTE texdata;
@@ -1196,30 +1246,37 @@ void R_DrawSpanMaskedP_C (void)
 #endif
 
 void R_DrawSpanTranslucentP_C (void)
+{
+	FSpanDrawerArgs args;
+	R_SetupSpanArgs (args);
+	R_DrawSpanTranslucentP_C (args);
+}
+
+void R_DrawSpanTranslucentP_C (const FSpanDrawerArgs &args)
 {
 	dsfixed_t			xfrac;
 	dsfixed_t			yfrac;
 	dsfixed_t			xstep;
 	dsfixed_t			ystep;
 	BYTE*				dest;
-	const BYTE*			source = ds_source;
-	const BYTE*			colormap = ds_colormap;
+	const BYTE*			source = args.source;
+	const BYTE*			colormap = args.colormap;
 	int 				count;
 	int 				spot;
-	DWORD *fg2rgb = dc_srcblend;
-	DWORD *bg2rgb = dc_destblend;
+	DWORD *fg2rgb = args.srcblend;
+	DWORD *bg2rgb = args.destblend;
 
-	xfrac = ds_xfrac;
-	yfrac = ds_yfrac;
+	xfrac = args.xfrac;
+	yfrac = args.yfrac;
 
-	dest = ylookup[ds_y] + ds_x1 + dc_destorg;
+	dest = args.dest;
 
-	count = ds_x2 - ds_x1 + 1;
+	count = args.count;
 
-	xstep = ds_xstep;
-	ystep = ds_ystep;
+	xstep = args.xstep;
+	ystep = args.ystep;
 
-	if (ds_xbits == 6 && ds_ybits == 6)
+	if (args.xbits == 6 && args.ybits == 6)
 	{
 		// 64x64 is the most common case by far, so special case it.
 		do
@@ -1237,9 +1294,9 @@ void R_DrawSpanTranslucentP_C (void)
 	}
 	else
 	{
-		BYTE yshift = 32 - ds_ybits;
-		BYTE xshift = yshift - ds_xbits;
-		int xmask = ((1 << ds_xbits) - 1) << ds_ybits;
+		BYTE yshift = 32 - args.ybits;
+		BYTE xshift = yshift - args.xbits;
+		int xmask = ((1 << args.xbits) - 1) << args.ybits;
 		do
 		{
 			spot = ((xfrac >> xshift) & xmask) + (yfrac >> yshift);
@@ -1256,30 +1313,37 @@ void R_DrawSpanTranslucentP_C (void)
 }
 
 void R_DrawSpanMaskedTranslucentP_C (void)
+{
+	FSpanDrawerArgs args;
+	R_SetupSpanArgs (args);
+	R_DrawSpanMaskedTranslucentP_C (args);
+}
+
+void R_DrawSpanMaskedTranslucentP_C (const FSpanDrawerArgs &args)
 {
 	dsfixed_t			xfrac;
 	dsfixed_t			yfrac;
 	dsfixed_t			xstep;
 	dsfixed_t			ystep;
 	BYTE*				dest;
-	const BYTE*			source = ds_source;
-	const BYTE*			colormap = ds_colormap;
+	const BYTE*			source = args.source;
+	const BYTE*			colormap = args.colormap;
 	int 				count;
 	int 				spot;
-	DWORD *fg2rgb = dc_srcblend;
-	DWORD *bg2rgb = dc_destblend;
+	DWORD *fg2rgb = args.srcblend;
+	DWORD *bg2rgb = args.destblend;
 
-	xfrac = ds_xfrac;
-	yfrac = ds_yfrac;
+	xfrac = args.xfrac;
+	yfrac = args.yfrac;
 
-	dest = ylookup[ds_y] + ds_x1 + dc_destorg;
+	dest = args.dest;
 
-	count = ds_x2 - ds_x1 + 1;
+	count = args.count;
 
-	xstep = ds_xstep;
-	ystep = ds_ystep;
+	xstep = args.xstep;
+	ystep = args.ystep;
 
-	if (ds_xbits == 6 && ds_ybits == 6)
+	if (args.xbits == 6 && args.ybits == 6)
 	{
 		// 64x64 is the most common case by far, so special case it.
 		do
@@ -1304,9 +1368,9 @@ void R_DrawSpanMaskedTranslucentP_C (void)
 	}
 	else
 	{
-		BYTE yshift = 32 - ds_ybits;
-		BYTE xshift = yshift - ds_xbits;
-		int xmask = ((1 << ds_xbits) - 1) << ds_ybits;
+		BYTE yshift = 32 - args.ybits;
+		BYTE xshift = yshift - args.xbits;
+		int xmask = ((1 << args.xbits) - 1) << args.ybits;
 		do
 		{
 			BYTE texdata;
@@ -1330,30 +1394,37 @@ void R_DrawSpanMaskedTranslucentP_C (void)
 }
 
 void R_DrawSpanAddClampP_C (void)
+{
+	FSpanDrawerArgs args;
+	R_SetupSpanArgs (args);
+	R_DrawSpanAddClampP_C (args);
+}
+
+void R_DrawSpanAddClampP_C (const FSpanDrawerArgs &args)
 {
 	dsfixed_t			xfrac;
 	dsfixed_t			yfrac;
 	dsfixed_t			xstep;
 	dsfixed_t			ystep;
 	BYTE*				dest;
-	const BYTE*			source = ds_source;
-	const BYTE*			colormap = ds_colormap;
+	const BYTE*			source = args.source;
+	const BYTE*			colormap = args.colormap;
 	int 				count;
 	int 				spot;
-	DWORD *fg2rgb = dc_srcblend;
-	DWORD *bg2rgb = dc_destblend;
+	DWORD *fg2rgb = args.srcblend;
+	DWORD *bg2rgb = args.destblend;
 
-	xfrac = ds_xfrac;
-	yfrac = ds_yfrac;
+	xfrac = args.xfrac;
+	yfrac = args.yfrac;
 
-	dest = ylookup[ds_y] + ds_x1 + dc_destorg;
+	dest = args.dest;
 
-	count = ds_x2 - ds_x1 + 1;
+	count = args.count;
 
-	xstep = ds_xstep;
-	ystep = ds_ystep;
+	xstep = args.xstep;
+	ystep = args.ystep;
 
-	if (ds_xbits == 6 && ds_ybits == 6)
+	if (args.xbits == 6 && args.ybits == 6)
 	{
 		// 64x64 is the most common case by far, so special case it.
 		do
@@ -1374,9 +1445,9 @@ void R_DrawSpanAddClampP_C (void)
 	}
 	else
 	{
-		BYTE yshift = 32 - ds_ybits;
-		BYTE xshift = yshift - ds_xbits;
-		int xmask = ((1 << ds_xbits) - 1) << ds_ybits;
+		BYTE yshift = 32 - args.ybits;
+		BYTE xshift = yshift - args.xbits;
+		int xmask = ((1 << args.xbits) - 1) << args.ybits;
 		do
 		{
 			spot = ((xfrac >> xshift) & xmask) + (yfrac >> yshift);
@@ -1396,30 +1467,37 @@ void R_DrawSpanAddClampP_C (void)
 }
 
 void R_DrawSpanMaskedAddClampP_C (void)
+{
+	FSpanDrawerArgs args;
+	R_SetupSpanArgs (args);
+	R_DrawSpanMaskedAddClampP_C (args);
+}
+
+void R_DrawSpanMaskedAddClampP_C (const FSpanDrawerArgs &args)
 {
 	dsfixed_t			xfrac;
 	dsfixed_t			yfrac;
 	dsfixed_t			xstep;
 	dsfixed_t			ystep;
 	BYTE*				dest;
-	const BYTE*			source = ds_source;
-	const BYTE*			colormap = ds_colormap;
+	const BYTE*			source = args.source;
+	const BYTE*			colormap = args.colormap;
 	int 				count;
 	int 				spot;
-	DWORD *fg2rgb = dc_srcblend;
-	DWORD *bg2rgb = dc_destblend;
+	DWORD *fg2rgb = args.srcblend;
+	DWORD *bg2rgb = args.destblend;
 
-	xfrac = ds_xfrac;
-	yfrac = ds_yfrac;
+	xfrac = args.xfrac;
+	yfrac = args.yfrac;
 
-	dest = ylookup[ds_y] + ds_x1 + dc_destorg;
+	dest = args.dest;
 
-	count = ds_x2 - ds_x1 + 1;
+	count = args.count;
 
-	xstep = ds_xstep;
-	ystep = ds_ystep;
+	xstep = args.xstep;
+	ystep = args.ystep;
 
-	if (ds_xbits == 6 && ds_ybits == 6)
+	if (args.xbits == 6 && args.ybits == 6)
 	{
 		// 64x64 is the most common case by far, so special case it.
 		do
@@ -1447,9 +1525,9 @@ void R_DrawSpanMaskedAddClampP_C (void)
 	}
 	else
 	{
-		BYTE yshift = 32 - ds_ybits;
-		BYTE xshift = yshift - ds_xbits;
-		int xmask = ((1 << ds_xbits) - 1) << ds_ybits;
+		BYTE yshift = 32 - args.ybits;
+		BYTE xshift = yshift - args.xbits;
+		int xmask = ((1 << args.xbits) - 1) << args.ybits;
 		do
 		{
 			BYTE texdata;
@@ -1481,6 +1559,11 @@ void R_FillSpan (void)
 	memset (ylookup[ds_y] + ds_x1 + dc_destorg, ds_color, ds_x2 - ds_x1 + 1);
 }
 
+void R_FillSpan (const FSpanDrawerArgs &args)
+{
+	memset (args.dest, args.color, args.count);
+}
+
 // Draw a voxel slab
 //
 // "Build Engine & Tools" Copyright (c) 1993-1997 Ken Silverman
@@ -1579,7 +1662,7 @@ extern "C" void STACK_ARGS R_DrawSlabC(int dx, fixed_t v, int dy, fixed_t vi, co
 
 #ifndef X86_ASM
 static DWORD STACK_ARGS vlinec1 ();
-static int vlinebits;
+int vlinebits;
 
 DWORD (STACK_ARGS *dovline1)() = vlinec1;
 DWORD (STACK_ARGS *doprevline1)() = vlinec1;
@@ -1595,7 +1678,7 @@ void (STACK_ARGS *dovline4)() = vlinec4;
 
 static DWORD STACK_ARGS mvlinec1();
 static void STACK_ARGS mvlinec4();
-static int mvlinebits;
+int mvlinebits;
 
 DWORD (STACK_ARGS *domvline1)() = mvlinec1;
 void (STACK_ARGS *domvline4)() = mvlinec4;
@@ -1664,16 +1747,61 @@ void setupvline (int fracbits)
 }
 
 #if !defined(X86_ASM)
+void R_SetupWallArgs (FWallDrawerArgs &args, int bits)
+{
+	args.dest = dc_dest;
+	args.count = dc_count;
+	args.pitch = dc_pitch;
+	args.bits = bits;
+}
+
+void R_SetupWallArgs1 (FWallDrawerArgs &args, int bits)
+{
+	R_SetupWallArgs (args, bits);
+	args.frac[0] = dc_texturefrac;
+	args.step[0] = dc_iscale;
+	args.source[0] = dc_source;
+	args.colormap[0] = dc_colormap;
+}
+
+void R_SetupWallArgs4 (FWallDrawerArgs &args, int bits)
+{
+	R_SetupWallArgs (args, bits);
+	for (int i = 0; i < 4; ++i)
+	{
+		args.frac[i] = vplce[i];
+		args.step[i] = vince[i];
+		args.source[i] = bufplce[i];
+		args.colormap[i] = palookupoffse[i];
+	}
+}
+
+// The four column drawers leave vplce pointing past the columns they drew.
+static inline void AdvanceWallArgs4 (int count)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		vplce[i] += count * vince[i];
+	}
+}
+
 DWORD STACK_ARGS vlinec1 ()
 {
-	DWORD fracstep = dc_iscale;
-	DWORD frac = dc_texturefrac;
-	BYTE *colormap = dc_colormap;
-	int count = dc_count;
-	const BYTE *source = dc_source;
-	BYTE *dest = dc_dest;
-	int bits = vlinebits;
-	int pitch = dc_pitch;
+	FWallDrawerArgs args;
+	R_SetupWallArgs1 (args, vlinebits);
+	return vlinec1 (args);
+}
+
+DWORD vlinec1 (const FWallDrawerArgs &args)
+{
+	DWORD fracstep = args.step[0];
+	DWORD frac = args.frac[0];
+	const BYTE *colormap = args.colormap[0];
+	int count = args.count;
+	const BYTE *source = args.source[0];
+	BYTE *dest = args.dest;
+	int bits = args.bits;
+	int pitch = args.pitch;
 
 	do
 	{
@@ -1685,20 +1813,32 @@ DWORD STACK_ARGS vlinec1 ()
 	return frac;
 }
 
+#ifndef X64_ASM
 void STACK_ARGS vlinec4 ()
 {
-	BYTE *dest = dc_dest;
-	int count = dc_count;
-	int bits = vlinebits;
-	DWORD place;
+	FWallDrawerArgs args;
+	R_SetupWallArgs4 (args, vlinebits);
+	vlinec4 (args);
+	AdvanceWallArgs4 (args.count);
+}
+#endif
+
+// Also used with X64_ASM, where the drawer threads cannot call vlinetallasm4.
+void vlinec4 (const FWallDrawerArgs &args)
+{
+	BYTE *dest = args.dest;
+	int count = args.count;
+	int bits = args.bits;
+	int pitch = args.pitch;
+	DWORD place0 = args.frac[0], place1 = args.frac[1], place2 = args.frac[2], place3 = args.frac[3];
 
 	do
 	{
-		dest[0] = palookupoffse[0][bufplce[0][(place=vplce[0])>>bits]]; vplce[0] = place+vince[0];
-		dest[1] = palookupoffse[1][bufplce[1][(place=vplce[1])>>bits]]; vplce[1] = place+vince[1];
-		dest[2] = palookupoffse[2][bufplce[2][(place=vplce[2])>>bits]]; vplce[2] = place+vince[2];
-		dest[3] = palookupoffse[3][bufplce[3][(place=vplce[3])>>bits]]; vplce[3] = place+vince[3];
-		dest += dc_pitch;
+		dest[0] = args.colormap[0][args.source[0][place0>>bits]]; place0 += args.step[0];
+		dest[1] = args.colormap[1][args.source[1][place1>>bits]]; place1 += args.step[1];
+		dest[2] = args.colormap[2][args.source[2][place2>>bits]]; place2 += args.step[2];
+		dest[3] = args.colormap[3][args.source[3][place3>>bits]]; place3 += args.step[3];
+		dest += pitch;
 	} while (--count);
 }
 #endif
@@ -1717,14 +1857,21 @@ void setupmvline (int fracbits)
 #if !defined(X86_ASM)
 DWORD STACK_ARGS mvlinec1 ()
 {
-	DWORD fracstep = dc_iscale;
-	DWORD frac = dc_texturefrac;
-	BYTE *colormap = dc_colormap;
-	int count = dc_count;
-	const BYTE *source = dc_source;
-	BYTE *dest = dc_dest;
-	int bits = mvlinebits;
-	int pitch = dc_pitch;
+	FWallDrawerArgs args;
+	R_SetupWallArgs1 (args, mvlinebits);
+	return mvlinec1 (args);
+}
+
+DWORD mvlinec1 (const FWallDrawerArgs &args)
+{
+	DWORD fracstep = args.step[0];
+	DWORD frac = args.frac[0];
+	const BYTE *colormap = args.colormap[0];
+	int count = args.count;
+	const BYTE *source = args.source[0];
+	BYTE *dest = args.dest;
+	int bits = args.bits;
+	int pitch = args.pitch;
 
 	do
 	{
@@ -1742,20 +1889,29 @@ DWORD STACK_ARGS mvlinec1 ()
 
 void STACK_ARGS mvlinec4 ()
 {
-	BYTE *dest = dc_dest;
-	int count = dc_count;
-	int bits = mvlinebits;
-	DWORD place;
+	FWallDrawerArgs args;
+	R_SetupWallArgs4 (args, mvlinebits);
+	mvlinec4 (args);
+	AdvanceWallArgs4 (args.count);
+}
+
+void mvlinec4 (const FWallDrawerArgs &args)
+{
+	BYTE *dest = args.dest;
+	int count = args.count;
+	int bits = args.bits;
+	int pitch = args.pitch;
+	DWORD place0 = args.frac[0], place1 = args.frac[1], place2 = args.frac[2], place3 = args.frac[3];
 
 	do
 	{
 		BYTE pix;
 
-		pix = bufplce[0][(place=vplce[0])>>bits]; if(pix) dest[0] = palookupoffse[0][pix]; vplce[0] = place+vince[0];
-		pix = bufplce[1][(place=vplce[1])>>bits]; if(pix) dest[1] = palookupoffse[1][pix]; vplce[1] = place+vince[1];
-		pix = bufplce[2][(place=vplce[2])>>bits]; if(pix) dest[2] = palookupoffse[2][pix]; vplce[2] = place+vince[2];
-		pix = bufplce[3][(place=vplce[3])>>bits]; if(pix) dest[3] = palookupoffse[3][pix]; vplce[3] = place+vince[3];
-		dest += dc_pitch;
+		pix = args.source[0][place0>>bits]; if(pix) dest[0] = args.colormap[0][pix]; place0 += args.step[0];
+		pix = args.source[1][place1>>bits]; if(pix) dest[1] = args.colormap[1][pix]; place1 += args.step[1];
+		pix = args.source[2][place2>>bits]; if(pix) dest[2] = args.colormap[2][pix]; place2 += args.step[2];
+		pix = args.source[3][place3>>bits]; if(pix) dest[3] = args.colormap[3][pix]; place3 += args.step[3];
+		dest += pitch;
 	} while (--count);
 }
 #endif
@@ -2196,11 +2352,30 @@ void R_InitColumnDrawers ()
 	R_DrawSpan					= R_DrawSpanP_C;
 	R_DrawSpanMasked			= R_DrawSpanMaskedP_C;
 	rt_map4cols					= rt_map4cols_c;
+	rt_add4cols					= rt_add4cols_c;
+	rt_addclamp4cols			= rt_addclamp4cols_c;
 #endif
 	R_DrawSpanTranslucent		= R_DrawSpanTranslucentP_C;
 	R_DrawSpanMaskedTranslucent = R_DrawSpanMaskedTranslucentP_C;
 	R_DrawSpanAddClamp			= R_DrawSpanAddClampP_C;
 	R_DrawSpanMaskedAddClamp	= R_DrawSpanMaskedAddClampP_C;
+	R_DrawAddColumn				= R_DrawAddColumnP_C;
+	R_DrawAddClampColumn		= R_DrawAddClampColumnP_C;
+	R_DrawSubClampColumn		= R_DrawSubClampColumnP_C;
+	R_DrawRevSubClampColumn		= R_DrawRevSubClampColumnP_C;
+	rt_subclamp4cols			= rt_subclamp4cols_c;
+	rt_revsubclamp4cols			= rt_revsubclamp4cols_c;
+
+#ifndef X86_ASM
+	R_SpanDrawers[SPANDRAWER_Normal]			= R_DrawSpanP_C;
+	R_SpanDrawers[SPANDRAWER_Masked]			= R_DrawSpanMaskedP_C;
+	R_SpanDrawers[SPANDRAWER_Translucent]		= R_DrawSpanTranslucentP_C;
+	R_SpanDrawers[SPANDRAWER_MaskedTranslucent]	= R_DrawSpanMaskedTranslucentP_C;
+	R_SpanDrawers[SPANDRAWER_AddClamp]			= R_DrawSpanAddClampP_C;
+	R_SpanDrawers[SPANDRAWER_MaskedAddClamp]	= R_DrawSpanMaskedAddClampP_C;
+
+	R_InitSIMDDrawers ();
+#endif
 }
 
 // [RH] Choose column drawers in a single place
@@ -2269,7 +2444,7 @@ static bool R_SetBlendFunc (int op, fixed_t fglevel, fixed_t bglevel, int flags)
 			}
 			else if (dc_translation == NULL)
 			{
-				colfunc = R_DrawAddColumnP_C;
+				colfunc = R_DrawAddColumn;
 				hcolfunc_post1 = rt_add1col;
 				hcolfunc_post4 = rt_add4cols;
 			}
@@ -2290,7 +2465,7 @@ static bool R_SetBlendFunc (int op, fixed_t fglevel, fixed_t bglevel, int flags)
 			}
 			else if (dc_translation == NULL)
 			{
-				colfunc = R_DrawAddClampColumnP_C;
+				colfunc = R_DrawAddClampColumn;
 				hcolfunc_post1 = rt_addclamp1col;
 				hcolfunc_post4 = rt_addclamp4cols;
 			}
@@ -2312,7 +2487,7 @@ static bool R_SetBlendFunc (int op, fixed_t fglevel, fixed_t bglevel, int flags)
 		}
 		else if (dc_translation == NULL)
 		{
-			colfunc = R_DrawSubClampColumnP_C;
+			colfunc = R_DrawSubClampColumn;
 			hcolfunc_post1 = rt_subclamp1col;
 			hcolfunc_post4 = rt_subclamp4cols;
 		}
@@ -2337,7 +2512,7 @@ static bool R_SetBlendFunc (int op, fixed_t fglevel, fixed_t bglevel, int flags)
 		}
 		else if (dc_translation == NULL)
 		{
-			colfunc = R_DrawRevSubClampColumnP_C;
+			colfunc = R_DrawRevSubClampColumn;
 			hcolfunc_post1 = rt_revsubclamp1col;
 			hcolfunc_post4 = rt_revsubclamp4cols;
 		}
@@ -2453,25 +2628,25 @@ void R_FinishSetPatchStyle ()
 
 bool R_GetTransMaskDrawers (fixed_t (**tmvline1)(), void (**tmvline4)())
 {
-	if (colfunc == R_DrawAddColumnP_C)
+	if (colfunc == R_DrawAddColumn)
 	{
 		*tmvline1 = tmvline1_add;
 		*tmvline4 = tmvline4_add;
 		return true;
 	}
-	if (colfunc == R_DrawAddClampColumnP_C)
+	if (colfunc == R_DrawAddClampColumn)
 	{
 		*tmvline1 = tmvline1_addclamp;
 		*tmvline4 = tmvline4_addclamp;
 		return true;
 	}
-	if (colfunc == R_DrawSubClampColumnP_C)
+	if (colfunc == R_DrawSubClampColumn)
 	{
 		*tmvline1 = tmvline1_subclamp;
 		*tmvline4 = tmvline4_subclamp;
 		return true;
 	}
-	if (colfunc == R_DrawRevSubClampColumnP_C)
+	if (colfunc == R_DrawRevSubClampColumn)
 	{
 		*tmvline1 = tmvline1_revsubclamp;
 		*tmvline4 = tmvline4_revsubclamp;
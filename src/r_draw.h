@@ -79,6 +79,29 @@ extern DWORD (STACK_ARGS *domvline1) ();
 extern void (STACK_ARGS *domvline4) ();
 extern void setupmvline (int);
 
+// Everything a wall column drawer reads from the globals. The single column
+// drawers only use the first element of each array.
+struct FWallDrawerArgs
+{
+	BYTE *dest;
+	int count;
+	int pitch;
+	int bits;
+	DWORD frac[4];
+	DWORD step[4];
+	const BYTE *source[4];
+	const BYTE *colormap[4];
+};
+
+#ifndef X86_ASM
+void R_SetupWallArgs1 (FWallDrawerArgs &args, int bits);
+void R_SetupWallArgs4 (FWallDrawerArgs &args, int bits);
+DWORD vlinec1 (const FWallDrawerArgs &args);
+void vlinec4 (const FWallDrawerArgs &args);
+DWORD mvlinec1 (const FWallDrawerArgs &args);
+void mvlinec4 (const FWallDrawerArgs &args);
+#endif
+
 extern void setuptmvline (int);
 
 // The Spectre/Invisibility effect.
@@ -87,6 +110,12 @@ extern void (*R_DrawFuzzColumn)(void);
 // [RH] Draw shaded column
 extern void (*R_DrawShadedColumn)(void);
 
+// Translucent column drawers for the different blend operations.
+extern void (*R_DrawAddColumn)(void);
+extern void (*R_DrawAddClampColumn)(void);
+extern void (*R_DrawSubClampColumn)(void);
+extern void (*R_DrawRevSubClampColumn)(void);
+
 // Draw with color translation tables, for player sprite rendering,
 //	Green/Red/Blue/Indigo shirts.
 extern void (*R_DrawTranslatedColumn)(void);
@@ -144,8 +173,8 @@ void rt_tlaterevsubclamp1col (int hx, int sx, int yl, int yh);
 void STACK_ARGS rt_map4cols_c (int sx, int yl, int yh);
 void STACK_ARGS rt_add4cols_c (int sx, int yl, int yh);
 void STACK_ARGS rt_addclamp4cols_c (int sx, int yl, int yh);
-void STACK_ARGS rt_subclamp4cols (int sx, int yl, int yh);
-void STACK_ARGS rt_revsubclamp4cols (int sx, int yl, int yh);
+void STACK_ARGS rt_subclamp4cols_c (int sx, int yl, int yh);
+void STACK_ARGS rt_revsubclamp4cols_c (int sx, int yl, int yh);
 
 void STACK_ARGS rt_tlate4cols (int sx, int yl, int yh);
 void STACK_ARGS rt_tlateadd4cols (int sx, int yl, int yh);
@@ -164,6 +193,8 @@ void STACK_ARGS rt_addclamp4cols_asm (int sx, int yl, int yh);
 }
 
 extern void (STACK_ARGS *rt_map4cols)(int sx, int yl, int yh);
+extern void (STACK_ARGS *rt_subclamp4cols)(int sx, int yl, int yh);
+extern void (STACK_ARGS *rt_revsubclamp4cols)(int sx, int yl, int yh);
 
 #ifdef X86_ASM
 #define rt_copy1col			rt_copy1col_asm
@@ -177,8 +208,8 @@ extern void (STACK_ARGS *rt_map4cols)(int sx, int yl, int yh);
 #define rt_copy4cols		rt_copy4cols_c
 #define rt_map1col			rt_map1col_c
 #define rt_shaded4cols		rt_shaded4cols_c
-#define rt_add4cols			rt_add4cols_c
-#define rt_addclamp4cols	rt_addclamp4cols_c
+extern void (STACK_ARGS *rt_add4cols)(int sx, int yl, int yh);
+extern void (STACK_ARGS *rt_addclamp4cols)(int sx, int yl, int yh);
 #endif
 
 void rt_draw4cols (int sx);
@@ -214,6 +245,13 @@ void	R_DrawSpanMaskedP_C (void);
 
 void	R_DrawSpanTranslucentP_C (void);
 void	R_DrawSpanMaskedTranslucentP_C (void);
+void	R_DrawSpanAddClampP_C (void);
+void	R_DrawSpanMaskedAddClampP_C (void);
+
+void	R_DrawAddColumnP_C (void);
+void	R_DrawAddClampColumnP_C (void);
+void	R_DrawSubClampColumnP_C (void);
+void	R_DrawRevSubClampColumnP_C (void);
 
 void	R_DrawTlatedLucentColumnP_C (void);
 #define R_DrawTlatedLucentColumn R_DrawTlatedLucentColumnP_C
@@ -252,6 +290,46 @@ extern "C" const BYTE*		ds_source;
 
 extern "C" int				ds_color;		// [RH] For flat color (no texturing)
 
+// Everything a span drawer reads from the globals.
+struct FSpanDrawerArgs
+{
+	BYTE *dest;
+	int count;
+	dsfixed_t xfrac, yfrac;
+	dsfixed_t xstep, ystep;
+	int xbits, ybits;
+	const BYTE *source;
+	const BYTE *colormap;
+	DWORD *srcblend, *destblend;
+	int color;
+};
+
+void R_SetupSpanArgs (FSpanDrawerArgs &args);
+#ifndef X86_ASM
+void R_DrawSpanP_C (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedP_C (const FSpanDrawerArgs &args);
+
+// The drawers behind R_DrawSpan, R_DrawSpanMasked, etc., taking their
+// arguments directly.
+enum ESpanDrawer
+{
+	SPANDRAWER_Normal,
+	SPANDRAWER_Masked,
+	SPANDRAWER_Translucent,
+	SPANDRAWER_MaskedTranslucent,
+	SPANDRAWER_AddClamp,
+	SPANDRAWER_MaskedAddClamp,
+
+	NUM_SPANDRAWERS
+};
+extern void (*R_SpanDrawers[NUM_SPANDRAWERS])(const FSpanDrawerArgs &args);
+#endif
+void R_DrawSpanTranslucentP_C (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedTranslucentP_C (const FSpanDrawerArgs &args);
+void R_DrawSpanAddClampP_C (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedAddClampP_C (const FSpanDrawerArgs &args);
+void R_FillSpan (const FSpanDrawerArgs &args);
+
 extern BYTE shadetables[/*NUMCOLORMAPS*16*256*/];
 extern FDynamicColormap ShadeFakeColormap[16];
 extern BYTE identitymap[256];
@@ -0,0 +1,376 @@
+//-----------------------------------------------------------------------------
+//
+// Zandronum Source
+// Copyright (C) 2026 Zandronum Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// Filename: r_drawqueue.cpp
+//
+// Description: Records the wall and flat drawers so they can be run by several
+// threads, each drawing its own part of the screen.
+//
+//-----------------------------------------------------------------------------
+
+#include <limits.h>
+
+#include "doomtype.h"
+#include "c_cvars.h"
+#include "r_local.h"
+#include "r_draw.h"
+#include "r_drawqueue.h"
+#include "stats.h"
+#include "tarray.h"
+#include "workerpool.h"
+#include "zstring.h"
+
+//*****************************************************************************
+//	DEFINES
+
+// The view is split into at most this many bands.
+#define	MAX_DRAWER_BANDS	64
+
+enum EDrawerCommandType
+{
+	DRAWCMD_VLINE1,
+	DRAWCMD_VLINE4,
+	DRAWCMD_MVLINE1,
+	DRAWCMD_MVLINE4,
+
+	// Everything from here on is a span, in the order of ESpanDrawer.
+	DRAWCMD_SPAN,
+	DRAWCMD_FILLSPAN = DRAWCMD_SPAN + NUM_SPANDRAWERS,
+};
+
+//*****************************************************************************
+struct FDrawerCommand
+{
+	BYTE	Type;
+
+	// First row of the view that is drawn to.
+	int		Y;
+
+	union
+	{
+		FWallDrawerArgs		Wall;
+		FSpanDrawerArgs		Span;
+	};
+};
+
+//*****************************************************************************
+//	VARIABLES
+
+bool	DrawerQueueActive;
+
+#ifndef X86_ASM
+extern int vlinebits;
+extern int mvlinebits;
+#endif
+
+static	TArray<FDrawerCommand>	g_Commands;
+static	int						g_lNumBands;
+static	int						g_lQueueHeight;
+static	int						g_lPhase;
+static	cycle_t					g_BandCycles[NUM_DRAWERPHASES][MAX_DRAWER_BANDS];
+static	int						g_lLastNumBands;
+
+//*****************************************************************************
+//	CONSOLE VARIABLES
+
+// Number of bands the walls and flats are split into. Each band is drawn by
+// one thread from the worker pool. 0 draws everything on the main thread.
+CUSTOM_CVAR( Int, r_drawerthreads, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG )
+{
+	if ( self < 0 )
+		self = 0;
+	else if ( self > MAX_DRAWER_BANDS )
+		self = MAX_DRAWER_BANDS;
+}
+
+//*****************************************************************************
+//	FUNCTIONS
+
+#ifndef X86_ASM
+
+static void drawqueue_ExecuteWall( const FDrawerCommand &Command, int lTop, int lBottom )
+{
+	const int	lY1 = Command.Y;
+	const int	lY2 = Command.Y + Command.Wall.count;
+
+	if (( lY2 <= lTop ) || ( lY1 >= lBottom ))
+		return;
+
+	FWallDrawerArgs	Args = Command.Wall;
+	const int		lNumColumns = (( Command.Type == DRAWCMD_VLINE4 ) || ( Command.Type == DRAWCMD_MVLINE4 )) ? 4 : 1;
+
+	// Skip the rows above the band. The texture positions are stepped the
+	// same way the drawers step them, so the result is identical.
+	if ( lY1 < lTop )
+	{
+		const int	lSkip = lTop - lY1;
+
+		Args.dest += lSkip * Args.pitch;
+		Args.count -= lSkip;
+		for ( int i = 0; i < lNumColumns; i++ )
+			Args.frac[i] += lSkip * Args.step[i];
+	}
+	if ( lY2 > lBottom )
+		Args.count -= lY2 - lBottom;
+
+	switch ( Command.Type )
+	{
+	case DRAWCMD_VLINE1:	vlinec1( Args );	break;
+	case DRAWCMD_VLINE4:	vlinec4( Args );	break;
+	case DRAWCMD_MVLINE1:	mvlinec1( Args );	break;
+	case DRAWCMD_MVLINE4:	mvlinec4( Args );	break;
+	}
+}
+
+//*****************************************************************************
+//
+static void drawqueue_ExecuteSpan( const FDrawerCommand &Command )
+{
+	if ( Command.Type == DRAWCMD_FILLSPAN )
+		R_FillSpan( Command.Span );
+	else
+		R_SpanDrawers[Command.Type - DRAWCMD_SPAN]( Command.Span );
+}
+
+//*****************************************************************************
+//
+static void drawqueue_ExecuteBand( unsigned int Band )
+{
+	cycle_t	&Cycles = g_BandCycles[g_lPhase][Band];
+
+	Cycles.Clock( );
+
+	// The outer bands also take anything outside the view, so that nothing
+	// is lost if a drawer ever writes there.
+	const int	lTop = ( Band == 0 ) ? INT_MIN : static_cast<int>( Band * g_lQueueHeight / g_lNumBands );
+	const int	lBottom = ( static_cast<int>( Band ) == g_lNumBands - 1 ) ? INT_MAX : static_cast<int>(( Band + 1 ) * g_lQueueHeight / g_lNumBands );
+
+	for ( unsigned int i = 0; i < g_Commands.Size( ); i++ )
+	{
+		const FDrawerCommand	&Command = g_Commands[i];
+
+		if ( Command.Type < DRAWCMD_SPAN )
+			drawqueue_ExecuteWall( Command, lTop, lBottom );
+		else if (( Command.Y >= lTop ) && ( Command.Y < lBottom ))
+			drawqueue_ExecuteSpan( Command );
+	}
+
+	Cycles.Unclock( );
+}
+
+//*****************************************************************************
+//
+static FDrawerCommand &drawqueue_AddCommand( BYTE Type, int lY )
+{
+	FDrawerCommand	&Command = g_Commands[g_Commands.Reserve( 1 )];
+
+	Command.Type = Type;
+	Command.Y = lY;
+	return Command;
+}
+
+//*****************************************************************************
+//
+static int drawqueue_GetRow( const BYTE *pDest )
+{
+	return static_cast<int>(( pDest - dc_destorg ) / dc_pitch );
+}
+
+#endif	// !X86_ASM
+
+//*****************************************************************************
+//
+bool R_BeginDrawerQueue( )
+{
+#ifndef X86_ASM
+	if (( r_drawerthreads <= 0 ) || DrawerQueueActive )
+		return false;
+
+	g_lNumBands = r_drawerthreads;
+	g_lQueueHeight = viewheight;
+	g_lPhase = DRAWERPHASE_WALLS;
+	g_lLastNumBands = g_lNumBands;
+	for ( int lPhase = 0; lPhase < NUM_DRAWERPHASES; lPhase++ )
+	{
+		for ( int lBand = 0; lBand < g_lNumBands; lBand++ )
+			g_BandCycles[lPhase][lBand].Reset( );
+	}
+
+	g_Commands.Clear( );
+	DrawerQueueActive = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+//*****************************************************************************
+//
+void R_FlushDrawerQueue( )
+{
+#ifndef X86_ASM
+	if ( g_Commands.Size( ) == 0 )
+		return;
+
+	WorkerPool.ParallelFor( g_lNumBands, drawqueue_ExecuteBand );
+	g_Commands.Clear( );
+#endif
+}
+
+//*****************************************************************************
+//
+void R_NextDrawerPhase( )
+{
+	R_FlushDrawerQueue( );
+	if ( g_lPhase < NUM_DRAWERPHASES - 1 )
+		g_lPhase++;
+}
+
+//*****************************************************************************
+//
+void R_EndDrawerQueue( )
+{
+	R_FlushDrawerQueue( );
+	DrawerQueueActive = false;
+}
+
+//*****************************************************************************
+//
+DWORD R_QueueVLine1( bool bMasked )
+{
+#ifndef X86_ASM
+	FDrawerCommand	&Command = drawqueue_AddCommand( bMasked ? DRAWCMD_MVLINE1 : DRAWCMD_VLINE1, drawqueue_GetRow( dc_dest ));
+
+	R_SetupWallArgs1( Command.Wall, bMasked ? mvlinebits : vlinebits );
+	return dc_texturefrac + (DWORD)dc_count * (DWORD)dc_iscale;
+#else
+	return 0;
+#endif
+}
+
+//*****************************************************************************
+//
+void R_QueueVLine4( bool bMasked )
+{
+#ifndef X86_ASM
+	FDrawerCommand	&Command = drawqueue_AddCommand( bMasked ? DRAWCMD_MVLINE4 : DRAWCMD_VLINE4, drawqueue_GetRow( dc_dest ));
+
+	R_SetupWallArgs4( Command.Wall, bMasked ? mvlinebits : vlinebits );
+
+	// wallscan continues the columns from where the drawer left them.
+	for ( int i = 0; i < 4; i++ )
+		vplce[i] += dc_count * vince[i];
+#endif
+}
+
+//*****************************************************************************
+//
+void R_QueueSpan( )
+{
+#ifndef X86_ASM
+	void	(*const SpanFuncs[NUM_SPANDRAWERS])( void ) =
+	{
+		R_DrawSpan, R_DrawSpanMasked, R_DrawSpanTranslucent,
+		R_DrawSpanMaskedTranslucent, R_DrawSpanAddClamp, R_DrawSpanMaskedAddClamp
+	};
+	BYTE	Type = DRAWCMD_FILLSPAN;
+
+	if ( spanfunc != static_cast<void (*)( void )>( R_FillSpan ))
+	{
+		int	lDrawer = 0;
+
+		while (( lDrawer < NUM_SPANDRAWERS ) && ( spanfunc != SpanFuncs[lDrawer] ))
+			lDrawer++;
+
+		if ( lDrawer == NUM_SPANDRAWERS )
+		{
+			// A drawer that can't be recorded.
+			FDirectDrawing	Direct;
+			spanfunc( );
+			return;
+		}
+		Type = static_cast<BYTE>( DRAWCMD_SPAN + lDrawer );
+	}
+
+	R_SetupSpanArgs( drawqueue_AddCommand( Type, ds_y ).Span );
+#endif
+}
+
+//*****************************************************************************
+//
+FString R_GetDrawerThreadStats( int Phase )
+{
+	FString	Out;
+
+	for ( int lBand = 0; lBand < g_lLastNumBands; lBand++ )
+		Out.AppendFormat( "%s%.1f", ( lBand == 0 ) ? "" : " ", g_BandCycles[Phase][lBand].TimeMS( ));
+
+	return Out;
+}
+
+//*****************************************************************************
+//
+FDirectDrawing::FDirectDrawing( bool bEnable )
+{
+	_bPaused = false;
+	if ( bEnable )
+		Begin( );
+}
+
+//*****************************************************************************
+//
+void FDirectDrawing::Begin( )
+{
+	if (( _bPaused == false ) && DrawerQueueActive )
+	{
+		R_FlushDrawerQueue( );
+		DrawerQueueActive = false;
+		_bPaused = true;
+	}
+}
+
+//*****************************************************************************
+//
+FDirectDrawing::~FDirectDrawing( )
+{
+	if ( _bPaused )
+		DrawerQueueActive = true;
+}
@@ -0,0 +1,109 @@
+//-----------------------------------------------------------------------------
+//
+// Zandronum Source
+// Copyright (C) 2026 Zandronum Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// Filename: r_drawqueue.h
+//
+// Description: Records the wall and flat drawers so they can be run by several
+// threads, each drawing its own part of the screen.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __R_DRAWQUEUE_H__
+#define __R_DRAWQUEUE_H__
+
+#include "doomtype.h"
+
+class FString;
+
+// While the queue is active, wallscan and R_MapPlane don't draw anything but
+// only record the drawer calls. The recorded calls are run when the queue is
+// flushed: Each thread draws one horizontal band of the view and executes
+// all calls in their original order, clipped to its band. The result is the
+// same as if the calls had been made directly.
+extern bool	DrawerQueueActive;
+
+enum EDrawerPhase
+{
+	DRAWERPHASE_WALLS,
+	DRAWERPHASE_PLANES,
+
+	NUM_DRAWERPHASES
+};
+
+// Starts recording if r_drawerthreads is enabled. Returns false if it isn't.
+bool	R_BeginDrawerQueue( );
+
+// Runs all recorded calls. The time is added to the current phase.
+void	R_FlushDrawerQueue( );
+
+// Flushes, then counts the following calls towards the next phase.
+void	R_NextDrawerPhase( );
+
+// Flushes and stops recording.
+void	R_EndDrawerQueue( );
+
+// Record the current drawer globals. The column versions behave like the
+// drawers they replace and return or advance the texture positions.
+DWORD	R_QueueVLine1( bool bMasked );
+void	R_QueueVLine4( bool bMasked );
+void	R_QueueSpan( );
+
+// Per thread time spent in a phase during the last frame.
+FString	R_GetDrawerThreadStats( int Phase );
+
+//*****************************************************************************
+// Code that draws to the screen directly while the queue is active must
+// flush it first, so that it draws on top of everything recorded before.
+// Constructed disabled, the flush is put off until Begin is called, so that
+// code which may not draw anything doesn't flush for nothing.
+class FDirectDrawing
+{
+public:
+	FDirectDrawing( bool bEnable = true );
+	~FDirectDrawing( );
+
+	void	Begin( );
+
+private:
+	bool	_bPaused;
+};
+
+#endif	// __R_DRAWQUEUE_H__
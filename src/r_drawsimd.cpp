@@ -0,0 +1,408 @@
+#include <string.h>
+
+#include "doomtype.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "r_local.h"
+#include "r_drawsimd.h"
+#include "v_video.h"
+#include "stats.h"
+#include "x86.h"
+#include "v_text.h"
+
+// 0 = only use the C drawers, 1 = use SSE2 at most, 2 = use the best
+// version for this CPU. Off by default: most of these drawers are bound by
+// the byte table lookups, and bench_drawers shows the C versions beating
+// the vectorized ones for most of them.
+CUSTOM_CVAR (Int, r_simddrawers, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG|CVAR_NOINITCALL)
+{
+	if (self < 0 || self > 2)
+	{
+		self = 0;
+		return;
+	}
+	R_InitColumnDrawers ();
+}
+
+#ifndef X86_ASM
+
+typedef void (STACK_ARGS *FourColsFunc)(int sx, int yl, int yh);
+
+struct FDrawerSet
+{
+	const char *Name;
+	int Level;				// Needed r_simddrawers value
+	void (*Columns[4])();
+	void (*Spans[NUM_SPANDRAWERS])(const FSpanDrawerArgs &args);
+	FourColsFunc Map4Cols;
+	FourColsFunc Blend4Cols[4];
+};
+
+static const char *const ColumnNames[4] = { "add column", "addclamp column", "subclamp column", "revsubclamp column" };
+static const char *const SpanNames[NUM_SPANDRAWERS] = { "span", "masked span", "translucent span", "masked translucent span", "addclamp span", "masked addclamp span" };
+static const char *const Blend4ColsNames[4] = { "rt_add4cols", "rt_addclamp4cols", "rt_subclamp4cols", "rt_revsubclamp4cols" };
+
+static const FDrawerSet CDrawers =
+{
+	"C", 0,
+	{ R_DrawAddColumnP_C, R_DrawAddClampColumnP_C, R_DrawSubClampColumnP_C, R_DrawRevSubClampColumnP_C },
+	{ R_DrawSpanP_C, R_DrawSpanMaskedP_C, R_DrawSpanTranslucentP_C, R_DrawSpanMaskedTranslucentP_C, R_DrawSpanAddClampP_C, R_DrawSpanMaskedAddClampP_C },
+	rt_map4cols_c,
+	{ rt_add4cols_c, rt_addclamp4cols_c, rt_subclamp4cols_c, rt_revsubclamp4cols_c },
+};
+
+#ifdef HAVE_DRAWERS_SSE2
+static const FDrawerSet SSE2Drawers =
+{
+	"SSE2", 1,
+	{ R_DrawAddColumnP_SSE2, R_DrawAddClampColumnP_SSE2, R_DrawSubClampColumnP_SSE2, R_DrawRevSubClampColumnP_SSE2 },
+	{ R_DrawSpanP_SSE2, R_DrawSpanMaskedP_SSE2, R_DrawSpanTranslucentP_SSE2, R_DrawSpanMaskedTranslucentP_SSE2, R_DrawSpanAddClampP_SSE2, R_DrawSpanMaskedAddClampP_SSE2 },
+	rt_map4cols_sse2,
+	{ rt_add4cols_sse2, rt_addclamp4cols_sse2, rt_subclamp4cols_sse2, rt_revsubclamp4cols_sse2 },
+};
+#endif
+
+#ifdef HAVE_DRAWERS_AVX2
+static const FDrawerSet AVX2Drawers =
+{
+	"AVX2", 2,
+	{ R_DrawAddColumnP_AVX2, R_DrawAddClampColumnP_AVX2, R_DrawSubClampColumnP_AVX2, R_DrawRevSubClampColumnP_AVX2 },
+	{ R_DrawSpanP_AVX2, R_DrawSpanMaskedP_AVX2, R_DrawSpanTranslucentP_AVX2, R_DrawSpanMaskedTranslucentP_AVX2, R_DrawSpanAddClampP_AVX2, R_DrawSpanMaskedAddClampP_AVX2 },
+	rt_map4cols_sse2,	// Nothing to gain from AVX2 here.
+	{ rt_add4cols_avx2, rt_addclamp4cols_avx2, rt_subclamp4cols_avx2, rt_revsubclamp4cols_avx2 },
+};
+#endif
+
+// Returns the vectorized drawers that can be used on this CPU, best first.
+static int R_GetSIMDDrawerSets (const FDrawerSet **sets)
+{
+	int count = 0;
+
+#ifdef HAVE_DRAWERS_AVX2
+	if (CPU.bAVX2)
+	{
+		sets[count++] = &AVX2Drawers;
+	}
+#endif
+#ifdef HAVE_DRAWERS_SSE2
+#if !defined(_M_X64) && !defined(__amd64__) && !defined(__SSE2__)
+	if (CPU.bSSE2)
+#endif
+	{
+		sets[count++] = &SSE2Drawers;
+	}
+#endif
+	return count;
+}
+
+// The R_DrawSpan* pointers take no arguments, so they call the chosen
+// drawer through these.
+template<int Drawer> static void R_DrawSpanVia ()
+{
+	FSpanDrawerArgs args;
+	R_SetupSpanArgs (args);
+	R_SpanDrawers[Drawer] (args);
+}
+
+#endif
+
+//==========================================================================
+//
+// R_InitSIMDDrawers
+//
+// Called by R_InitColumnDrawers after it set up the C drawers.
+//
+//==========================================================================
+
+void R_InitSIMDDrawers ()
+{
+#ifndef X86_ASM
+	const FDrawerSet *sets[2];
+	int count = R_GetSIMDDrawerSets (sets);
+	const FDrawerSet *use = NULL;
+
+	for (int i = 0; i < count && use == NULL; ++i)
+	{
+		if (sets[i]->Level <= r_simddrawers)
+		{
+			use = sets[i];
+		}
+	}
+	if (use == NULL)
+	{
+		return;
+	}
+
+	R_DrawAddColumn = use->Columns[0];
+	R_DrawAddClampColumn = use->Columns[1];
+	R_DrawSubClampColumn = use->Columns[2];
+	R_DrawRevSubClampColumn = use->Columns[3];
+	for (int i = 0; i < NUM_SPANDRAWERS; ++i)
+	{
+		R_SpanDrawers[i] = use->Spans[i];
+	}
+	R_DrawSpan = R_DrawSpanVia<SPANDRAWER_Normal>;
+	R_DrawSpanMasked = R_DrawSpanVia<SPANDRAWER_Masked>;
+	R_DrawSpanTranslucent = R_DrawSpanVia<SPANDRAWER_Translucent>;
+	R_DrawSpanMaskedTranslucent = R_DrawSpanVia<SPANDRAWER_MaskedTranslucent>;
+	R_DrawSpanAddClamp = R_DrawSpanVia<SPANDRAWER_AddClamp>;
+	R_DrawSpanMaskedAddClamp = R_DrawSpanVia<SPANDRAWER_MaskedAddClamp>;
+	rt_map4cols = use->Map4Cols;
+	rt_add4cols = use->Blend4Cols[0];
+	rt_addclamp4cols = use->Blend4Cols[1];
+	rt_subclamp4cols = use->Blend4Cols[2];
+	rt_revsubclamp4cols = use->Blend4Cols[3];
+#endif
+}
+
+//==========================================================================
+//
+// CCMD bench_drawers
+//
+// Draws the same random columns and spans with the C drawers and with
+// every vectorized version this CPU supports. Prints the time each one
+// took and whether the pixels are identical to those of the C drawers.
+//
+//==========================================================================
+
+#ifndef X86_ASM
+
+enum
+{
+	BENCH_PITCH = 256,
+	BENCH_HEIGHT = 256,
+	BENCH_CALLS = 256,
+};
+
+enum
+{
+	BENCH_Columns,
+	BENCH_Spans,
+	BENCH_Map4Cols,
+	BENCH_Blend4Cols,
+};
+
+struct FBenchColumn
+{
+	BYTE *Dest;
+	int Count;
+	fixed_t Frac, Step;
+	DWORD *SrcBlend, *DestBlend;
+};
+
+struct FBench4Cols
+{
+	int SX, YL, YH;
+	DWORD *SrcBlend, *DestBlend;
+};
+
+struct FDrawerBench
+{
+	BYTE Screen[BENCH_PITCH * BENCH_HEIGHT];
+	BYTE StartScreen[BENCH_PITCH * BENCH_HEIGHT];
+	BYTE Reference[BENCH_PITCH * BENCH_HEIGHT];
+	BYTE Texture[256 * 256];
+	BYTE Colormap[256];
+	BYTE Temp[BENCH_HEIGHT * 4];
+	FBenchColumn Columns[BENCH_CALLS];
+	FSpanDrawerArgs Spans[BENCH_CALLS];
+	FBench4Cols FourCols[BENCH_CALLS];
+};
+
+static DWORD BenchSeed;
+
+static DWORD BenchRandom ()
+{
+	BenchSeed = BenchSeed * 1664525 + 1013904223;
+	return BenchSeed >> 8;
+}
+
+// Add without clamping needs blend levels that don't overflow.
+static void BenchPickBlend (bool clamped, DWORD *&srcblend, DWORD *&destblend)
+{
+	int fglevel = BenchRandom() % 65;
+	if (clamped)
+	{
+		srcblend = Col2RGB8_LessPrecision[fglevel];
+		destblend = Col2RGB8_LessPrecision[BenchRandom() % 65];
+	}
+	else
+	{
+		srcblend = Col2RGB8[fglevel];
+		destblend = Col2RGB8[64 - fglevel];
+	}
+}
+
+static void BenchSetup (FDrawerBench &bench, int kind, int index)
+{
+	BenchSeed = 1 + kind * 16 + index;
+	for (int i = 0; i < BENCH_PITCH * BENCH_HEIGHT; ++i)
+	{
+		bench.StartScreen[i] = BYTE(BenchRandom());
+	}
+	for (int i = 0; i < 256 * 256; ++i)
+	{
+		// Leave some holes for the masked drawers.
+		DWORD r = BenchRandom();
+		bench.Texture[i] = (r & 7) == 0 ? 0 : BYTE(r >> 3);
+	}
+	for (int i = 0; i < 256; ++i)
+	{
+		bench.Colormap[i] = BYTE(BenchRandom());
+	}
+	for (int i = 0; i < BENCH_HEIGHT * 4; ++i)
+	{
+		bench.Temp[i] = BYTE(BenchRandom());
+	}
+	for (int i = 0; i < BENCH_CALLS; ++i)
+	{
+		int x = BenchRandom() % BENCH_PITCH;
+		int y = BenchRandom() % BENCH_HEIGHT;
+
+		FBenchColumn &col = bench.Columns[i];
+		col.Dest = bench.Screen + y * BENCH_PITCH + x;
+		col.Count = 1 + BenchRandom() % (BENCH_HEIGHT - y);
+		col.Frac = BenchRandom() & 0xffff;
+		col.Step = BenchRandom() & 0x1ffff;
+		BenchPickBlend (index != 0, col.SrcBlend, col.DestBlend);
+
+		FSpanDrawerArgs &span = bench.Spans[i];
+		span.dest = bench.Screen + y * BENCH_PITCH + x;
+		span.count = 1 + BenchRandom() % (BENCH_PITCH - x);
+		span.xfrac = BenchRandom() * 0x101;
+		span.yfrac = BenchRandom() * 0x101;
+		span.xstep = BenchRandom() * 0x11;
+		span.ystep = BenchRandom() * 0x11;
+		span.xbits = (i & 1) ? 6 : 2 + BenchRandom() % 7;
+		span.ybits = (i & 1) ? 6 : 2 + BenchRandom() % 7;
+		span.source = bench.Texture;
+		span.colormap = bench.Colormap;
+		BenchPickBlend (index >= SPANDRAWER_AddClamp, span.srcblend, span.destblend);
+		span.color = 0;
+
+		FBench4Cols &four = bench.FourCols[i];
+		four.SX = (BenchRandom() % (BENCH_PITCH / 4)) * 4;
+		four.YL = y;
+		four.YH = y + BenchRandom() % (BENCH_HEIGHT - y);
+		BenchPickBlend (index != 0, four.SrcBlend, four.DestBlend);
+	}
+}
+
+static double BenchRun (FDrawerBench &bench, const FDrawerSet &set, int kind, int index, int iterations)
+{
+	cycle_t clock;
+
+	memcpy (bench.Screen, bench.StartScreen, sizeof(bench.Screen));
+	clock.Reset();
+	clock.Clock();
+	for (int it = 0; it < iterations; ++it)
+	{
+		for (int i = 0; i < BENCH_CALLS; ++i)
+		{
+			switch (kind)
+			{
+			case BENCH_Columns:
+			{
+				const FBenchColumn &col = bench.Columns[i];
+				dc_dest = col.Dest;
+				dc_count = col.Count;
+				dc_texturefrac = col.Frac;
+				dc_iscale = col.Step;
+				dc_srcblend = col.SrcBlend;
+				dc_destblend = col.DestBlend;
+				set.Columns[index] ();
+				break;
+			}
+
+			case BENCH_Spans:
+				set.Spans[index] (bench.Spans[i]);
+				break;
+
+			case BENCH_Map4Cols:
+				set.Map4Cols (bench.FourCols[i].SX, bench.FourCols[i].YL, bench.FourCols[i].YH);
+				break;
+
+			case BENCH_Blend4Cols:
+				dc_srcblend = bench.FourCols[i].SrcBlend;
+				dc_destblend = bench.FourCols[i].DestBlend;
+				set.Blend4Cols[index] (bench.FourCols[i].SX, bench.FourCols[i].YL, bench.FourCols[i].YH);
+				break;
+			}
+		}
+	}
+	clock.Unclock();
+	return clock.TimeMS();
+}
+
+CCMD (bench_drawers)
+{
+	static const struct { int Kind, Count; const char *const *Names; } kinds[] =
+	{
+		{ BENCH_Columns, 4, ColumnNames },
+		{ BENCH_Spans, NUM_SPANDRAWERS, SpanNames },
+		{ BENCH_Map4Cols, 1, NULL },
+		{ BENCH_Blend4Cols, 4, Blend4ColsNames },
+	};
+	const FDrawerSet *sets[2];
+	int numsets = R_GetSIMDDrawerSets (sets);
+	int iterations = argv.argc() > 1 ? MAX (1, atoi (argv[1])) : 100;
+
+	if (numsets == 0)
+	{
+		Printf ("No vectorized drawers are available on this CPU.\n");
+		return;
+	}
+
+	// The column drawers use the screen globals, so they are pointed to the
+	// benchmark's own buffers for the duration.
+	FDrawerBench *bench = new FDrawerBench;
+	int *savedylookup = new int[BENCH_HEIGHT];
+	memcpy (savedylookup, ylookup, sizeof(int) * BENCH_HEIGHT);
+	BYTE *saveddestorg = dc_destorg;
+	BYTE *savedtemp = dc_temp;
+	int savedpitch = dc_pitch;
+	lighttable_t *savedcolormap = dc_colormap;
+	const BYTE *savedsource = dc_source;
+
+	for (int i = 0; i < BENCH_HEIGHT; ++i)
+	{
+		ylookup[i] = i * BENCH_PITCH;
+	}
+	dc_destorg = bench->Screen;
+	dc_temp = bench->Temp;
+	dc_pitch = BENCH_PITCH;
+	dc_colormap = bench->Colormap;
+	dc_source = bench->Texture;
+
+	for (size_t k = 0; k < countof(kinds); ++k)
+	{
+		for (int index = 0; index < kinds[k].Count; ++index)
+		{
+			BenchSetup (*bench, kinds[k].Kind, index);
+			double ctime = BenchRun (*bench, CDrawers, kinds[k].Kind, index, iterations);
+			memcpy (bench->Reference, bench->Screen, sizeof(bench->Screen));
+
+			FString line;
+			line.Format ("%-24s C %.2f ms", kinds[k].Names != NULL ? kinds[k].Names[index] : "rt_map4cols", ctime);
+			for (int s = 0; s < numsets; ++s)
+			{
+				double time = BenchRun (*bench, *sets[s], kinds[k].Kind, index, iterations);
+				bool same = memcmp (bench->Reference, bench->Screen, sizeof(bench->Screen)) == 0;
+				line.AppendFormat ("  %s %.2f ms (%.2fx)%s", sets[s]->Name, time, time > 0 ? ctime / time : 0.,
+					same ? "" : TEXTCOLOR_RED " MISMATCH" TEXTCOLOR_NORMAL);
+			}
+			Printf ("%s\n", line.GetChars());
+		}
+	}
+
+	memcpy (ylookup, savedylookup, sizeof(int) * BENCH_HEIGHT);
+	dc_destorg = saveddestorg;
+	dc_temp = savedtemp;
+	dc_pitch = savedpitch;
+	dc_colormap = savedcolormap;
+	dc_source = savedsource;
+	delete[] savedylookup;
+	delete bench;
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef __R_DRAWSIMD_H__
+#define __R_DRAWSIMD_H__
+
+#include "r_draw.h"
+
+//==========================================================================
+//
+// Vectorized drawers
+//
+// SSE2 and AVX2 versions of the blending column drawers, the span drawers
+// and the rt_*4cols functions for builds without the ia32 assembly. They
+// draw exactly the same pixels as the C versions. R_InitColumnDrawers
+// picks them according to the CPU and r_simddrawers.
+//
+//==========================================================================
+
+// The blending arithmetic of the C drawers for a single pixel. Returns the
+// index into RGB32k.
+struct FBlendAdd
+{
+	static inline DWORD Pixel (DWORD fg, DWORD bg)
+	{
+		DWORD a = (fg + bg) | 0x1f07c1f;
+		return a & (a >> 15);
+	}
+};
+
+struct FBlendAddClamp
+{
+	static inline DWORD Pixel (DWORD fg, DWORD bg)
+	{
+		DWORD a = fg + bg;
+		DWORD b = a;
+
+		a |= 0x01f07c1f;
+		b &= 0x40100400;
+		a &= 0x3fffffff;
+		b = b - (b >> 5);
+		a |= b;
+		return a & (a >> 15);
+	}
+};
+
+struct FBlendSubClamp
+{
+	static inline DWORD Pixel (DWORD fg, DWORD bg)
+	{
+		DWORD a = (fg | 0x40100400) - bg;
+		DWORD b = a;
+
+		b &= 0x40100400;
+		b = b - (b >> 5);
+		a &= b;
+		a |= 0x01f07c1f;
+		return a & (a >> 15);
+	}
+};
+
+struct FBlendRevSubClamp
+{
+	static inline DWORD Pixel (DWORD fg, DWORD bg)
+	{
+		return FBlendSubClamp::Pixel (bg, fg);
+	}
+};
+
+#if !defined(X86_ASM) && (defined(_M_X64) || defined(__amd64__) || defined(__SSE2__) || \
+	((defined(_M_IX86) || defined(__i386__)) && !defined(DISABLE_SSE)))
+#define HAVE_DRAWERS_SSE2
+void R_DrawAddColumnP_SSE2 ();
+void R_DrawAddClampColumnP_SSE2 ();
+void R_DrawSubClampColumnP_SSE2 ();
+void R_DrawRevSubClampColumnP_SSE2 ();
+void R_DrawSpanP_SSE2 (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedP_SSE2 (const FSpanDrawerArgs &args);
+void R_DrawSpanTranslucentP_SSE2 (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedTranslucentP_SSE2 (const FSpanDrawerArgs &args);
+void R_DrawSpanAddClampP_SSE2 (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedAddClampP_SSE2 (const FSpanDrawerArgs &args);
+void STACK_ARGS rt_map4cols_sse2 (int sx, int yl, int yh);
+void STACK_ARGS rt_add4cols_sse2 (int sx, int yl, int yh);
+void STACK_ARGS rt_addclamp4cols_sse2 (int sx, int yl, int yh);
+void STACK_ARGS rt_subclamp4cols_sse2 (int sx, int yl, int yh);
+void STACK_ARGS rt_revsubclamp4cols_sse2 (int sx, int yl, int yh);
+#endif
+
+#if !defined(X86_ASM) && (defined(_M_X64) || defined(__amd64__) || defined(_M_IX86) || defined(__i386__)) && !defined(DISABLE_AVX2)
+#define HAVE_DRAWERS_AVX2
+void R_DrawAddColumnP_AVX2 ();
+void R_DrawAddClampColumnP_AVX2 ();
+void R_DrawSubClampColumnP_AVX2 ();
+void R_DrawRevSubClampColumnP_AVX2 ();
+void R_DrawSpanP_AVX2 (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedP_AVX2 (const FSpanDrawerArgs &args);
+void R_DrawSpanTranslucentP_AVX2 (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedTranslucentP_AVX2 (const FSpanDrawerArgs &args);
+void R_DrawSpanAddClampP_AVX2 (const FSpanDrawerArgs &args);
+void R_DrawSpanMaskedAddClampP_AVX2 (const FSpanDrawerArgs &args);
+void STACK_ARGS rt_add4cols_avx2 (int sx, int yl, int yh);
+void STACK_ARGS rt_addclamp4cols_avx2 (int sx, int yl, int yh);
+void STACK_ARGS rt_subclamp4cols_avx2 (int sx, int yl, int yh);
+void STACK_ARGS rt_revsubclamp4cols_avx2 (int sx, int yl, int yh);
+#endif
+
+// Sets the drawer pointers to the vectorized versions, if enabled.
+void R_InitSIMDDrawers ();
+
+#endif
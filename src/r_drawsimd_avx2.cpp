@@ -0,0 +1,254 @@
+#include "r_drawsimd.h"
+
+#if defined(HAVE_DRAWERS_AVX2) && defined(__AVX2__)
+
+#include <immintrin.h>
+#include "v_video.h"
+
+// Eight pixels at a time. The blend tables hold DWORDs, so they can be read
+// with gathers. The colormaps and RGB32k are byte tables, which are still
+// read one pixel at a time.
+
+static inline __m256i BlendVec (FBlendAdd, __m256i fg, __m256i bg)
+{
+	__m256i a = _mm256_or_si256 (_mm256_add_epi32 (fg, bg), _mm256_set1_epi32 (0x1f07c1f));
+	return _mm256_and_si256 (a, _mm256_srli_epi32 (a, 15));
+}
+
+static inline __m256i BlendVec (FBlendAddClamp, __m256i fg, __m256i bg)
+{
+	__m256i a = _mm256_add_epi32 (fg, bg);
+	__m256i b = _mm256_and_si256 (a, _mm256_set1_epi32 (0x40100400));
+	a = _mm256_and_si256 (_mm256_or_si256 (a, _mm256_set1_epi32 (0x01f07c1f)), _mm256_set1_epi32 (0x3fffffff));
+	b = _mm256_sub_epi32 (b, _mm256_srli_epi32 (b, 5));
+	a = _mm256_or_si256 (a, b);
+	return _mm256_and_si256 (a, _mm256_srli_epi32 (a, 15));
+}
+
+static inline __m256i BlendVec (FBlendSubClamp, __m256i fg, __m256i bg)
+{
+	__m256i a = _mm256_sub_epi32 (_mm256_or_si256 (fg, _mm256_set1_epi32 (0x40100400)), bg);
+	__m256i b = _mm256_and_si256 (a, _mm256_set1_epi32 (0x40100400));
+	b = _mm256_sub_epi32 (b, _mm256_srli_epi32 (b, 5));
+	a = _mm256_or_si256 (_mm256_and_si256 (a, b), _mm256_set1_epi32 (0x01f07c1f));
+	return _mm256_and_si256 (a, _mm256_srli_epi32 (a, 15));
+}
+
+static inline __m256i BlendVec (FBlendRevSubClamp, __m256i fg, __m256i bg)
+{
+	return BlendVec (FBlendSubClamp(), bg, fg);
+}
+
+static inline __m256i Lookup (const DWORD *table, const DWORD *index)
+{
+	return _mm256_i32gather_epi32 ((const int *)table, _mm256_loadu_si256 ((const __m256i *)index), 4);
+}
+
+//==========================================================================
+//
+// Column drawers
+//
+//==========================================================================
+
+template<class Blend> static void DrawBlendColumn ()
+{
+	int count = dc_count;
+	if (count <= 0)
+		return;
+
+	BYTE *dest = dc_dest;
+	fixed_t frac = dc_texturefrac;
+	const fixed_t fracstep = dc_iscale;
+	const BYTE *colormap = dc_colormap;
+	const BYTE *source = dc_source;
+	const int pitch = dc_pitch;
+	const DWORD *fg2rgb = dc_srcblend;
+	const DWORD *bg2rgb = dc_destblend;
+
+	for (; count >= 8; count -= 8)
+	{
+		DWORD fg[8], bg[8], idx[8];
+
+		for (int i = 0; i < 8; ++i)
+		{
+			fg[i] = colormap[source[frac >> FRACBITS]];
+			bg[i] = dest[i * pitch];
+			frac += fracstep;
+		}
+		_mm256_storeu_si256 ((__m256i *)idx, BlendVec (Blend(), Lookup (fg2rgb, fg), Lookup (bg2rgb, bg)));
+		for (int i = 0; i < 8; ++i)
+		{
+			dest[i * pitch] = RGB32k[0][0][idx[i]];
+		}
+		dest += pitch * 8;
+	}
+	for (; count > 0; --count)
+	{
+		*dest = RGB32k[0][0][Blend::Pixel (fg2rgb[colormap[source[frac >> FRACBITS]]], bg2rgb[*dest])];
+		dest += pitch;
+		frac += fracstep;
+	}
+}
+
+void R_DrawAddColumnP_AVX2 ()			{ DrawBlendColumn<FBlendAdd> (); }
+void R_DrawAddClampColumnP_AVX2 ()		{ DrawBlendColumn<FBlendAddClamp> (); }
+void R_DrawSubClampColumnP_AVX2 ()		{ DrawBlendColumn<FBlendSubClamp> (); }
+void R_DrawRevSubClampColumnP_AVX2 ()	{ DrawBlendColumn<FBlendRevSubClamp> (); }
+
+//==========================================================================
+//
+// Span drawers
+//
+// Whatever is left at the end of the span is drawn by the C drawer.
+//
+//==========================================================================
+
+struct FNoBlend {};
+
+static inline bool IsBlended (FNoBlend) { return false; }
+template<class Blend> static inline bool IsBlended (Blend) { return true; }
+
+// Never called, but DrawSpan<FNoBlend> must compile.
+static inline __m256i BlendVec (FNoBlend, __m256i fg, __m256i bg)
+{
+	return fg;
+}
+
+template<class Blend, bool Masked> static void DrawSpan (const FSpanDrawerArgs &args, void (*drawrest)(const FSpanDrawerArgs &))
+{
+	const int yshift = 32 - args.ybits;
+	const int xshift = yshift - args.xbits;
+	const __m256i xmask = _mm256_set1_epi32 (((1 << args.xbits) - 1) << args.ybits);
+	const __m128i xshiftv = _mm_cvtsi32_si128 (xshift);
+	const __m128i yshiftv = _mm_cvtsi32_si128 (yshift);
+	const __m256i lanes = _mm256_set_epi32 (7, 6, 5, 4, 3, 2, 1, 0);
+	const __m256i xstep = _mm256_set1_epi32 (args.xstep * 8);
+	const __m256i ystep = _mm256_set1_epi32 (args.ystep * 8);
+	const BYTE *source = args.source;
+	const BYTE *colormap = args.colormap;
+	const DWORD *fg2rgb = args.srcblend;
+	const DWORD *bg2rgb = args.destblend;
+	BYTE *dest = args.dest;
+	int count = args.count;
+
+	// The products wrap around exactly like the C drawers' repeated adds.
+	__m256i xfrac = _mm256_add_epi32 (_mm256_set1_epi32 (args.xfrac), _mm256_mullo_epi32 (lanes, _mm256_set1_epi32 (args.xstep)));
+	__m256i yfrac = _mm256_add_epi32 (_mm256_set1_epi32 (args.yfrac), _mm256_mullo_epi32 (lanes, _mm256_set1_epi32 (args.ystep)));
+
+	for (; count >= 8; count -= 8, dest += 8)
+	{
+		DWORD spot[8];
+
+		_mm256_storeu_si256 ((__m256i *)spot, _mm256_add_epi32 (
+			_mm256_and_si256 (_mm256_srl_epi32 (xfrac, xshiftv), xmask), _mm256_srl_epi32 (yfrac, yshiftv)));
+		xfrac = _mm256_add_epi32 (xfrac, xstep);
+		yfrac = _mm256_add_epi32 (yfrac, ystep);
+
+		if (!IsBlended (Blend()))
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				BYTE texdata = source[spot[i]];
+				if (!Masked || texdata != 0)
+				{
+					dest[i] = colormap[texdata];
+				}
+			}
+		}
+		else
+		{
+			DWORD fg[8], idx[8];
+			BYTE texdata[8];
+
+			for (int i = 0; i < 8; ++i)
+			{
+				texdata[i] = source[spot[i]];
+				fg[i] = colormap[texdata[i]];
+			}
+			__m256i bg = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *)dest));
+			bg = _mm256_i32gather_epi32 ((const int *)bg2rgb, bg, 4);
+			_mm256_storeu_si256 ((__m256i *)idx, BlendVec (Blend(), Lookup (fg2rgb, fg), bg));
+			for (int i = 0; i < 8; ++i)
+			{
+				if (!Masked || texdata[i] != 0)
+				{
+					dest[i] = RGB32k[0][0][idx[i]];
+				}
+			}
+		}
+	}
+	if (count > 0)
+	{
+		FSpanDrawerArgs rest = args;
+		rest.dest = dest;
+		rest.count = count;
+		rest.xfrac = _mm_cvtsi128_si32 (_mm256_castsi256_si128 (xfrac));
+		rest.yfrac = _mm_cvtsi128_si32 (_mm256_castsi256_si128 (yfrac));
+		drawrest (rest);
+	}
+}
+
+void R_DrawSpanP_AVX2 (const FSpanDrawerArgs &args)					{ DrawSpan<FNoBlend, false> (args, R_DrawSpanP_C); }
+void R_DrawSpanMaskedP_AVX2 (const FSpanDrawerArgs &args)				{ DrawSpan<FNoBlend, true> (args, R_DrawSpanMaskedP_C); }
+void R_DrawSpanTranslucentP_AVX2 (const FSpanDrawerArgs &args)			{ DrawSpan<FBlendAdd, false> (args, R_DrawSpanTranslucentP_C); }
+void R_DrawSpanMaskedTranslucentP_AVX2 (const FSpanDrawerArgs &args)	{ DrawSpan<FBlendAdd, true> (args, R_DrawSpanMaskedTranslucentP_C); }
+void R_DrawSpanAddClampP_AVX2 (const FSpanDrawerArgs &args)			{ DrawSpan<FBlendAddClamp, false> (args, R_DrawSpanAddClampP_C); }
+void R_DrawSpanMaskedAddClampP_AVX2 (const FSpanDrawerArgs &args)		{ DrawSpan<FBlendAddClamp, true> (args, R_DrawSpanMaskedAddClampP_C); }
+
+//==========================================================================
+//
+// rt_*4cols
+//
+// Two rows of the four columns are one vector.
+//
+//==========================================================================
+
+template<class Blend> static void Blend4Cols (int sx, int yl, int yh)
+{
+	int count = yh - yl;
+	if (count < 0)
+		return;
+	count++;
+
+	const BYTE *colormap = dc_colormap;
+	const DWORD *fg2rgb = dc_srcblend;
+	const DWORD *bg2rgb = dc_destblend;
+	BYTE *dest = ylookup[yl] + sx + dc_destorg;
+	const BYTE *source = &dc_temp[yl*4];
+	const int pitch = dc_pitch;
+
+	for (; count >= 2; count -= 2)
+	{
+		DWORD fg[8], bg[8], idx[8];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			fg[i] = colormap[source[i]];
+			fg[i + 4] = colormap[source[i + 4]];
+			bg[i] = dest[i];
+			bg[i + 4] = dest[pitch + i];
+		}
+		_mm256_storeu_si256 ((__m256i *)idx, BlendVec (Blend(), Lookup (fg2rgb, fg), Lookup (bg2rgb, bg)));
+		for (int i = 0; i < 4; ++i)
+		{
+			dest[i] = RGB32k[0][0][idx[i]];
+			dest[pitch + i] = RGB32k[0][0][idx[i + 4]];
+		}
+		source += 8;
+		dest += pitch * 2;
+	}
+	if (count > 0)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			dest[i] = RGB32k[0][0][Blend::Pixel (fg2rgb[colormap[source[i]]], bg2rgb[dest[i]])];
+		}
+	}
+}
+
+void STACK_ARGS rt_add4cols_avx2 (int sx, int yl, int yh)			{ Blend4Cols<FBlendAdd> (sx, yl, yh); }
+void STACK_ARGS rt_addclamp4cols_avx2 (int sx, int yl, int yh)		{ Blend4Cols<FBlendAddClamp> (sx, yl, yh); }
+void STACK_ARGS rt_subclamp4cols_avx2 (int sx, int yl, int yh)		{ Blend4Cols<FBlendSubClamp> (sx, yl, yh); }
+void STACK_ARGS rt_revsubclamp4cols_avx2 (int sx, int yl, int yh)	{ Blend4Cols<FBlendRevSubClamp> (sx, yl, yh); }
+
+#endif
@@ -0,0 +1,265 @@
+#include "r_drawsimd.h"
+
+#ifdef HAVE_DRAWERS_SSE2
+
+#include <string.h>
+#include <emmintrin.h>
+#include "v_video.h"
+
+// SSE2 has no gather, so the table lookups are still done one pixel at a
+// time. What is vectorized is the texture coordinate stepping and the
+// blending arithmetic, four pixels at once.
+
+static inline __m128i BlendVec (FBlendAdd, __m128i fg, __m128i bg)
+{
+	__m128i a = _mm_or_si128 (_mm_add_epi32 (fg, bg), _mm_set1_epi32 (0x1f07c1f));
+	return _mm_and_si128 (a, _mm_srli_epi32 (a, 15));
+}
+
+static inline __m128i BlendVec (FBlendAddClamp, __m128i fg, __m128i bg)
+{
+	__m128i a = _mm_add_epi32 (fg, bg);
+	__m128i b = _mm_and_si128 (a, _mm_set1_epi32 (0x40100400));
+	a = _mm_and_si128 (_mm_or_si128 (a, _mm_set1_epi32 (0x01f07c1f)), _mm_set1_epi32 (0x3fffffff));
+	b = _mm_sub_epi32 (b, _mm_srli_epi32 (b, 5));
+	a = _mm_or_si128 (a, b);
+	return _mm_and_si128 (a, _mm_srli_epi32 (a, 15));
+}
+
+static inline __m128i BlendVec (FBlendSubClamp, __m128i fg, __m128i bg)
+{
+	__m128i a = _mm_sub_epi32 (_mm_or_si128 (fg, _mm_set1_epi32 (0x40100400)), bg);
+	__m128i b = _mm_and_si128 (a, _mm_set1_epi32 (0x40100400));
+	b = _mm_sub_epi32 (b, _mm_srli_epi32 (b, 5));
+	a = _mm_or_si128 (_mm_and_si128 (a, b), _mm_set1_epi32 (0x01f07c1f));
+	return _mm_and_si128 (a, _mm_srli_epi32 (a, 15));
+}
+
+static inline __m128i BlendVec (FBlendRevSubClamp, __m128i fg, __m128i bg)
+{
+	return BlendVec (FBlendSubClamp(), bg, fg);
+}
+
+//==========================================================================
+//
+// Column drawers
+//
+//==========================================================================
+
+template<class Blend> static void DrawBlendColumn ()
+{
+	int count = dc_count;
+	if (count <= 0)
+		return;
+
+	BYTE *dest = dc_dest;
+	fixed_t frac = dc_texturefrac;
+	const fixed_t fracstep = dc_iscale;
+	const BYTE *colormap = dc_colormap;
+	const BYTE *source = dc_source;
+	const int pitch = dc_pitch;
+	const DWORD *fg2rgb = dc_srcblend;
+	const DWORD *bg2rgb = dc_destblend;
+
+	for (; count >= 4; count -= 4)
+	{
+		DWORD fg[4], bg[4], idx[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			fg[i] = fg2rgb[colormap[source[frac >> FRACBITS]]];
+			bg[i] = bg2rgb[dest[i * pitch]];
+			frac += fracstep;
+		}
+		_mm_storeu_si128 ((__m128i *)idx, BlendVec (Blend(),
+			_mm_loadu_si128 ((const __m128i *)fg), _mm_loadu_si128 ((const __m128i *)bg)));
+		for (int i = 0; i < 4; ++i)
+		{
+			dest[i * pitch] = RGB32k[0][0][idx[i]];
+		}
+		dest += pitch * 4;
+	}
+	for (; count > 0; --count)
+	{
+		*dest = RGB32k[0][0][Blend::Pixel (fg2rgb[colormap[source[frac >> FRACBITS]]], bg2rgb[*dest])];
+		dest += pitch;
+		frac += fracstep;
+	}
+}
+
+void R_DrawAddColumnP_SSE2 ()			{ DrawBlendColumn<FBlendAdd> (); }
+void R_DrawAddClampColumnP_SSE2 ()		{ DrawBlendColumn<FBlendAddClamp> (); }
+void R_DrawSubClampColumnP_SSE2 ()		{ DrawBlendColumn<FBlendSubClamp> (); }
+void R_DrawRevSubClampColumnP_SSE2 ()	{ DrawBlendColumn<FBlendRevSubClamp> (); }
+
+//==========================================================================
+//
+// Span drawers
+//
+// The texture coordinates of four pixels are stepped together. Whatever
+// is left at the end of the span is drawn by the C drawer.
+//
+//==========================================================================
+
+struct FNoBlend {};
+
+static inline bool IsBlended (FNoBlend) { return false; }
+template<class Blend> static inline bool IsBlended (Blend) { return true; }
+
+// Never called, but DrawSpan<FNoBlend> must compile.
+static inline __m128i BlendVec (FNoBlend, __m128i fg, __m128i bg)
+{
+	return fg;
+}
+
+template<class Blend, bool Masked> static void DrawSpan (const FSpanDrawerArgs &args, void (*drawrest)(const FSpanDrawerArgs &))
+{
+	const int yshift = 32 - args.ybits;
+	const int xshift = yshift - args.xbits;
+	const __m128i xmask = _mm_set1_epi32 (((1 << args.xbits) - 1) << args.ybits);
+	const __m128i xshiftv = _mm_cvtsi32_si128 (xshift);
+	const __m128i yshiftv = _mm_cvtsi32_si128 (yshift);
+	const __m128i xstep = _mm_set1_epi32 (args.xstep * 4);
+	const __m128i ystep = _mm_set1_epi32 (args.ystep * 4);
+	const BYTE *source = args.source;
+	const BYTE *colormap = args.colormap;
+	const DWORD *fg2rgb = args.srcblend;
+	const DWORD *bg2rgb = args.destblend;
+	BYTE *dest = args.dest;
+	int count = args.count;
+
+	__m128i xfrac = _mm_set_epi32 (args.xfrac + args.xstep * 3, args.xfrac + args.xstep * 2, args.xfrac + args.xstep, args.xfrac);
+	__m128i yfrac = _mm_set_epi32 (args.yfrac + args.ystep * 3, args.yfrac + args.ystep * 2, args.yfrac + args.ystep, args.yfrac);
+
+	for (; count >= 4; count -= 4, dest += 4)
+	{
+		DWORD spot[4];
+
+		_mm_storeu_si128 ((__m128i *)spot, _mm_add_epi32 (
+			_mm_and_si128 (_mm_srl_epi32 (xfrac, xshiftv), xmask), _mm_srl_epi32 (yfrac, yshiftv)));
+		xfrac = _mm_add_epi32 (xfrac, xstep);
+		yfrac = _mm_add_epi32 (yfrac, ystep);
+
+		if (!IsBlended (Blend()))
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				BYTE texdata = source[spot[i]];
+				if (!Masked || texdata != 0)
+				{
+					dest[i] = colormap[texdata];
+				}
+			}
+		}
+		else
+		{
+			DWORD fg[4], bg[4], idx[4];
+			BYTE texdata[4];
+
+			for (int i = 0; i < 4; ++i)
+			{
+				texdata[i] = source[spot[i]];
+				fg[i] = fg2rgb[colormap[texdata[i]]];
+				bg[i] = bg2rgb[dest[i]];
+			}
+			_mm_storeu_si128 ((__m128i *)idx, BlendVec (Blend(),
+				_mm_loadu_si128 ((const __m128i *)fg), _mm_loadu_si128 ((const __m128i *)bg)));
+			for (int i = 0; i < 4; ++i)
+			{
+				if (!Masked || texdata[i] != 0)
+				{
+					dest[i] = RGB32k[0][0][idx[i]];
+				}
+			}
+		}
+	}
+	if (count > 0)
+	{
+		FSpanDrawerArgs rest = args;
+		rest.dest = dest;
+		rest.count = count;
+		rest.xfrac = _mm_cvtsi128_si32 (xfrac);
+		rest.yfrac = _mm_cvtsi128_si32 (yfrac);
+		drawrest (rest);
+	}
+}
+
+void R_DrawSpanP_SSE2 (const FSpanDrawerArgs &args)					{ DrawSpan<FNoBlend, false> (args, R_DrawSpanP_C); }
+void R_DrawSpanMaskedP_SSE2 (const FSpanDrawerArgs &args)				{ DrawSpan<FNoBlend, true> (args, R_DrawSpanMaskedP_C); }
+void R_DrawSpanTranslucentP_SSE2 (const FSpanDrawerArgs &args)			{ DrawSpan<FBlendAdd, false> (args, R_DrawSpanTranslucentP_C); }
+void R_DrawSpanMaskedTranslucentP_SSE2 (const FSpanDrawerArgs &args)	{ DrawSpan<FBlendAdd, true> (args, R_DrawSpanMaskedTranslucentP_C); }
+void R_DrawSpanAddClampP_SSE2 (const FSpanDrawerArgs &args)			{ DrawSpan<FBlendAddClamp, false> (args, R_DrawSpanAddClampP_C); }
+void R_DrawSpanMaskedAddClampP_SSE2 (const FSpanDrawerArgs &args)		{ DrawSpan<FBlendAddClamp, true> (args, R_DrawSpanMaskedAddClampP_C); }
+
+//==========================================================================
+//
+// rt_*4cols
+//
+// Each row of the four columns is one vector.
+//
+//==========================================================================
+
+// There is nothing to compute here, but reading and writing all four
+// pixels of a row at once still helps.
+void STACK_ARGS rt_map4cols_sse2 (int sx, int yl, int yh)
+{
+	int count = yh - yl;
+	if (count < 0)
+		return;
+	count++;
+
+	const BYTE *colormap = dc_colormap;
+	BYTE *dest = ylookup[yl] + sx + dc_destorg;
+	const BYTE *source = &dc_temp[yl*4];
+	const int pitch = dc_pitch;
+
+	do
+	{
+		DWORD in, out;
+
+		memcpy (&in, source, 4);
+		out = DWORD(colormap[in & 0xff]) | (DWORD(colormap[(in >> 8) & 0xff]) << 8) |
+			(DWORD(colormap[(in >> 16) & 0xff]) << 16) | (DWORD(colormap[in >> 24]) << 24);
+		memcpy (dest, &out, 4);
+		source += 4;
+		dest += pitch;
+	} while (--count);
+}
+
+template<class Blend> static void Blend4Cols (int sx, int yl, int yh)
+{
+	int count = yh - yl;
+	if (count < 0)
+		return;
+	count++;
+
+	const BYTE *colormap = dc_colormap;
+	const DWORD *fg2rgb = dc_srcblend;
+	const DWORD *bg2rgb = dc_destblend;
+	BYTE *dest = ylookup[yl] + sx + dc_destorg;
+	const BYTE *source = &dc_temp[yl*4];
+	const int pitch = dc_pitch;
+
+	do
+	{
+		__m128i fg = _mm_set_epi32 (fg2rgb[colormap[source[3]]], fg2rgb[colormap[source[2]]],
+			fg2rgb[colormap[source[1]]], fg2rgb[colormap[source[0]]]);
+		__m128i bg = _mm_set_epi32 (bg2rgb[dest[3]], bg2rgb[dest[2]], bg2rgb[dest[1]], bg2rgb[dest[0]]);
+		DWORD idx[4];
+
+		_mm_storeu_si128 ((__m128i *)idx, BlendVec (Blend(), fg, bg));
+		dest[0] = RGB32k[0][0][idx[0]];
+		dest[1] = RGB32k[0][0][idx[1]];
+		dest[2] = RGB32k[0][0][idx[2]];
+		dest[3] = RGB32k[0][0][idx[3]];
+		source += 4;
+		dest += pitch;
+	} while (--count);
+}
+
+void STACK_ARGS rt_add4cols_sse2 (int sx, int yl, int yh)			{ Blend4Cols<FBlendAdd> (sx, yl, yh); }
+void STACK_ARGS rt_addclamp4cols_sse2 (int sx, int yl, int yh)		{ Blend4Cols<FBlendAddClamp> (sx, yl, yh); }
+void STACK_ARGS rt_subclamp4cols_sse2 (int sx, int yl, int yh)		{ Blend4Cols<FBlendSubClamp> (sx, yl, yh); }
+void STACK_ARGS rt_revsubclamp4cols_sse2 (int sx, int yl, int yh)	{ Blend4Cols<FBlendRevSubClamp> (sx, yl, yh); }
+
+#endif
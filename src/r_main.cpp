@@ -61,6 +61,7 @@
 #include "v_font.h"
 #include "r_data/colormaps.h"
 #include "farchive.h"
+#include "r_drawqueue.h"
 // [BC] New #includes.
 #include "sv_commands.h"
 
@@ -110,6 +111,7 @@ bool r_dontmaplines;
 CVAR (String, r_viewsize, "", CVAR_NOSET)
 CVAR (Int, r_polymost, 0, 0)
 CVAR (Bool, r_shadercolormaps, true, CVAR_ARCHIVE)
+EXTERN_CVAR (Int, r_drawerthreads)
 
 fixed_t			r_BaseVisibility;
 fixed_t			r_WallVisibility;
@@ -170,6 +172,7 @@ void (*hcolfunc_post2) (int hx, int sx, int yl, int yh);
 void (STACK_ARGS *hcolfunc_post4) (int sx, int yl, int yh);
 
 cycle_t WallCycles, PlaneCycles, MaskedCycles, WallScanCycles;
+cycle_t WallDrawCycles, SpriteCycles;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
@@ -786,6 +789,8 @@ void R_RenderActorView (AActor *actor, bool dontmaplines)
 	PlaneCycles.Reset();
 	MaskedCycles.Reset();
 	WallScanCycles.Reset();
+	WallDrawCycles.Reset();
+	SpriteCycles.Reset();
 
 	fakeActive = 0; // kg3D - reset fake floor indicator
 	R_3D_ResetClip(); // reset clips (floor/ceiling)
@@ -832,6 +837,10 @@ void R_RenderActorView (AActor *actor, bool dontmaplines)
 	// [RH] Setup particles for this frame
 	P_FindParticleSubsectors ();
 
+	// Walls and flats of the main view may be drawn by the worker threads.
+	// Sky boxes, mirrors and sprites are drawn directly.
+	bool queued = R_BeginDrawerQueue ();
+
 	WallCycles.Clock();
 	DWORD savedflags = camera->renderflags;
 	// Never draw the player unless in chasecam mode
@@ -846,6 +855,15 @@ void R_RenderActorView (AActor *actor, bool dontmaplines)
 		R_RenderBSPNode (nodes + numnodes - 1);	// The head node is the last node output.
 		R_3D_ResetClip(); // reset clips (floor/ceiling)
 	}
+	if (queued)
+	{
+		WallScanCycles.Clock();
+		R_NextDrawerPhase ();
+		WallScanCycles.Unclock();
+	}
+	// Sky boxes and mirrors add to WallScanCycles too, so remember how much
+	// of WallCycles was spent drawing the walls of the main view.
+	WallDrawCycles = WallScanCycles;
 	camera->renderflags = savedflags;
 	WallCycles.Unclock();
 
@@ -855,6 +873,11 @@ void R_RenderActorView (AActor *actor, bool dontmaplines)
 	{
 		PlaneCycles.Clock();
 		R_DrawPlanes ();
+		if (queued)
+		{
+			R_EndDrawerQueue ();
+			queued = false;
+		}
 		R_DrawSkyBoxes ();
 		PlaneCycles.Unclock();
 
@@ -883,6 +906,10 @@ void R_RenderActorView (AActor *actor, bool dontmaplines)
 			}
 		}
 	}
+	if (queued)
+	{
+		R_EndDrawerQueue ();
+	}
 	WallMirrors.Clear ();
 	interpolator.RestoreInterpolations ();
 	R_SetupBuffer ();
@@ -957,6 +984,11 @@ ADD_STAT (fps)
 	FString out;
 	out.Format("frame=%04.1f ms  walls=%04.1f ms  planes=%04.1f ms  masked=%04.1f ms",
 		FrameCycles.TimeMS(), WallCycles.TimeMS(), PlaneCycles.TimeMS(), MaskedCycles.TimeMS());
+	if (r_drawerthreads > 0)
+	{
+		out.AppendFormat("\ndrawer threads: walls=%s ms  planes=%s ms",
+			R_GetDrawerThreadStats(DRAWERPHASE_WALLS).GetChars(), R_GetDrawerThreadStats(DRAWERPHASE_PLANES).GetChars());
+	}
 	return out;
 }
 
@@ -995,6 +1027,10 @@ ADD_STAT (wallcycles)
 	if (cycles && cycles < bestwallcycles)
 		bestwallcycles = cycles;
 	out.Format ("%g", bestwallcycles);
+	if (r_drawerthreads > 0)
+	{
+		out.AppendFormat ("  threads: %s ms", R_GetDrawerThreadStats(DRAWERPHASE_WALLS).GetChars());
+	}
 	return out;
 }
 
@@ -1012,7 +1048,7 @@ CCMD (clearwallcycles)
 }
 
 #if 1
-// To use these, also uncomment the clock/unclock in wallscan
+// WallScanCycles counts the time spent in R_RenderSegLoop
 static double bestscancycles = HUGE_VAL;
 
 ADD_STAT (scancycles)
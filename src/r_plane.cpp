@@ -30,6 +30,9 @@
 //
 // [RH] Further modified to significantly increase accuracy and add slopes.
 //
+// The number of hash slots now starts at MINVISPLANES and grows with
+// the number of visplanes seen in a frame, up to MAXVISPLANES.
+//
 //-----------------------------------------------------------------------------
 
 #include <stdlib.h>
@@ -62,6 +65,7 @@
 #include "r_3dfloors.h"
 #include "v_palette.h"
 #include "r_data/colormaps.h"
+#include "r_drawqueue.h"
 // [BC] New #includes.
 #include "sv_commands.h"
 
@@ -78,24 +82,39 @@ planefunction_t 		floorfunc;
 planefunction_t 		ceilingfunc;
 
 // Here comes the obnoxious "visplane".
-#define MAXVISPLANES 128    /* must be a power of 2 */
+#define MINVISPLANES 128    /* must be a power of 2 */
+#define MAXVISPLANES 8192   /* ditto */
+
+// Visplanes are allocated this many at a time.
+#define VISPLANE_BLOCK 16
 
 // Avoid infinite recursion with stacked sectors by limiting them.
 #define MAX_SKYBOX_PLANES 1000
 
 // [RH] Allocate one extra for sky box planes.
-static visplane_t		*visplanes[MAXVISPLANES+1];	// killough
+static visplane_t		**visplanes;				// killough
+static unsigned			numvisplanehash;
 static visplane_t		*freetail;					// killough
 static visplane_t		**freehead = &freetail;		// killough
 
+static TArray<BYTE *>	visplaneblocks;
+static unsigned			visplaneblockused = VISPLANE_BLOCK;
+
+// Statistics for the current frame.
+static unsigned			numvisplanes;
+static unsigned			visplanelookups, visplaneprobes;
+static cycle_t			PlaneLookupCycles;
+
 visplane_t 				*floorplane;
 visplane_t 				*ceilingplane;
 
 // killough -- hash function for visplanes
 // Empirically verified to be fairly uniform:
+// The integer part of the height is folded into the low bits, because
+// the fractional part is zero for most planes.
 
 #define visplane_hash(picnum,lightlevel,height) \
-  ((unsigned)((picnum)*3+(lightlevel)+((height).d)*7) & (MAXVISPLANES-1))
+  ((unsigned)((picnum)*3+(lightlevel)+((height).d ^ ((height).d >> FRACBITS))*7) & (numvisplanehash-1))
 
 // These are copies of the main parameters used when drawing stacked sectors.
 // When you change the main parameters, you should copy them here too *unless*
@@ -158,6 +177,8 @@ extern "C" void R_SetTiltedSpanSource_ASM (const BYTE *flat);
 extern "C" BYTE *ds_curcolormap, *ds_cursource, *ds_curtiltedsource;
 #endif
 void					R_DrawSinglePlane (visplane_t *, fixed_t alpha, bool additive, bool masked);
+static void				R_ResizeVisplaneHash (unsigned size);
+static void				R_FreeVisplanes ();
 
 //==========================================================================
 //
@@ -169,6 +190,7 @@ void					R_DrawSinglePlane (visplane_t *, fixed_t alpha, bool additive, bool mas
 
 void R_InitPlanes ()
 {
+	R_ResizeVisplaneHash (MINVISPLANES);
 }
 
 //==========================================================================
@@ -182,18 +204,53 @@ void R_DeinitPlanes ()
 	fakeActive = 0;
 
 	// do not use R_ClearPlanes because at this point the screen pointer is no longer valid.
-	for (int i = 0; i <= MAXVISPLANES; i++)	// new code -- killough
+	R_FreeVisplanes ();
+	if (visplanes != NULL)
 	{
-		for (*freehead = visplanes[i], visplanes[i] = NULL; *freehead; )
-		{
-			freehead = &(*freehead)->next;
-		}
+		M_Free (visplanes);
+		visplanes = NULL;
+		numvisplanehash = 0;
 	}
-	for (visplane_t *pl = freetail; pl != NULL; )
+}
+
+//==========================================================================
+//
+// R_ResizeVisplaneHash
+//
+// The table must not contain any visplanes.
+//
+//==========================================================================
+
+static void R_ResizeVisplaneHash (unsigned size)
+{
+	visplanes = (visplane_t **)M_Realloc (visplanes, sizeof(*visplanes) * (size+1));
+	memset (visplanes, 0, sizeof(*visplanes) * (size+1));
+	numvisplanehash = size;
+}
+
+//==========================================================================
+//
+// R_FreeVisplanes
+//
+// Frees the blocks the visplanes are allocated from. Afterwards the hash
+// table and the free list are empty.
+//
+//==========================================================================
+
+static void R_FreeVisplanes ()
+{
+	for (unsigned i = 0; i < visplaneblocks.Size(); i++)
+	{
+		M_Free (visplaneblocks[i]);
+	}
+	visplaneblocks.Clear ();
+	visplaneblockused = VISPLANE_BLOCK;
+
+	freetail = NULL;
+	freehead = &freetail;
+	if (visplanes != NULL)
 	{
-		visplane_t *next = pl->next;
-		free (pl);
-		pl = next;
+		memset (visplanes, 0, sizeof(*visplanes) * (numvisplanehash+1));
 	}
 }
 
@@ -244,7 +301,14 @@ void R_MapPlane (int y, int x1)
 	ds_x1 = x1;
 	ds_x2 = x2;
 
-	spanfunc ();
+	if (DrawerQueueActive)
+	{
+		R_QueueSpan ();
+	}
+	else
+	{
+		spanfunc ();
+	}
 }
 
 //==========================================================================
@@ -509,7 +573,7 @@ void R_ClearPlanes (bool fullclear)
 	// Don't clear fake planes if not doing a full clear.
 	if (!fullclear)
 	{
-		for (i = 0; i <= MAXVISPLANES-1; i++)	// new code -- killough
+		for (i = 0; i < (int)numvisplanehash; i++)	// new code -- killough
 		{
 			for (visplane_t **probe = &visplanes[i]; *probe != NULL; )
 			{
@@ -530,7 +594,7 @@ void R_ClearPlanes (bool fullclear)
 	}
 	else
 	{
-		for (i = 0; i <= MAXVISPLANES; i++)	// new code -- killough
+		for (i = 0; i <= (int)numvisplanehash; i++)	// new code -- killough
 		{
 			for (*freehead = visplanes[i], visplanes[i] = NULL; *freehead; )
 			{
@@ -538,6 +602,22 @@ void R_ClearPlanes (bool fullclear)
 			}
 		}
 
+		// Grow the hash table if the last frame had more visplanes than
+		// it has slots.
+		if (numvisplanes > numvisplanehash && numvisplanehash < MAXVISPLANES)
+		{
+			unsigned size = numvisplanehash;
+			while (size < numvisplanes && size < MAXVISPLANES)
+			{
+				size <<= 1;
+			}
+			R_ResizeVisplaneHash (size);
+		}
+		numvisplanes = 0;
+		visplanelookups = 0;
+		visplaneprobes = 0;
+		PlaneLookupCycles.Reset();
+
 		// opening / clipping determination
 		clearbufshort (floorclip, viewwidth, viewheight);
 		// [RH] clip ceiling to console bottom
@@ -556,16 +636,29 @@ void R_ClearPlanes (bool fullclear)
 // New function, by Lee Killough
 // [RH] top and bottom buffers get allocated immediately after the visplane.
 //
+// Visplanes that are no longer needed go to the free list and are reused
+// from there. New ones are taken from blocks of VISPLANE_BLOCK visplanes,
+// which are only freed when the resolution changes.
+//
 //==========================================================================
 
 static visplane_t *new_visplane (unsigned hash)
 {
 	visplane_t *check = freetail;
 
+	numvisplanes++;
 	if (check == NULL)
 	{
-		check = (visplane_t *)M_Malloc (sizeof(*check) + 3 + sizeof(*check->top)*(MAXWIDTH*2));
-		memset(check, 0, sizeof(*check) + 3 + sizeof(*check->top)*(MAXWIDTH*2));
+		const size_t size = (sizeof(*check) + 3 + sizeof(*check->top)*(MAXWIDTH*2) + 15) & ~15;
+
+		if (visplaneblockused == VISPLANE_BLOCK)
+		{
+			BYTE *block = (BYTE *)M_Malloc (size * VISPLANE_BLOCK);
+			memset (block, 0, size * VISPLANE_BLOCK);
+			visplaneblocks.Push (block);
+			visplaneblockused = 0;
+		}
+		check = (visplane_t *)(visplaneblocks.Last() + size * visplaneblockused++);
 		check->bottom = check->top + MAXWIDTH+2;
 	}
 	else if (NULL == (freetail = freetail->next))
@@ -633,11 +726,15 @@ visplane_t *R_FindPlane (const secplane_t &height, FTextureID picnum, int lightl
 		alpha = FRACUNIT;
 	}
 
+	PlaneLookupCycles.Clock();
+	visplanelookups++;
+
 	// New visplane algorithm uses hash table -- killough
-	hash = isskybox ? MAXVISPLANES : visplane_hash (picnum.GetIndex(), lightlevel, height);
+	hash = isskybox ? numvisplanehash : visplane_hash (picnum.GetIndex(), lightlevel, height);
 
 	for (check = visplanes[hash]; check; check = check->next)	// killough
 	{
+		visplaneprobes++;
 		if (isskybox)
 		{
 			if (skybox == check->skybox && plane == check->height)
@@ -673,11 +770,13 @@ visplane_t *R_FindPlane (const secplane_t &height, FTextureID picnum, int lightl
 						)
 					   )
 					{
+						PlaneLookupCycles.Unclock();
 						return check;
 					}
 				}
 				else
 				{
+					PlaneLookupCycles.Unclock();
 					return check;
 				}
 			}
@@ -698,11 +797,13 @@ visplane_t *R_FindPlane (const secplane_t &height, FTextureID picnum, int lightl
 			CurrentSkybox == check->CurrentSkybox
 			)
 		{
+		  PlaneLookupCycles.Unclock();
 		  return check;
 		}
 	}
 
 	check = new_visplane (hash);		// killough
+	PlaneLookupCycles.Unclock();
 
 	check->height = plane;
 	check->picnum = picnum;
@@ -787,7 +888,7 @@ visplane_t *R_CheckPlane (visplane_t *pl, int start, int stop)
 
 		if (pl->skybox != NULL && !pl->skybox->bInSkybox && (pl->picnum == skyflatnum || pl->skybox->bAlways) && viewactive)
 		{
-			hash = MAXVISPLANES;
+			hash = numvisplanehash;
 		}
 		else
 		{
@@ -927,6 +1028,9 @@ static const BYTE *R_GetTwoSkyColumns (FTexture *fronttex, int x)
 
 static void R_DrawSky (visplane_t *pl)
 {
+	// Two layer skies are composed in skybuf, which is reused for every
+	// fourth column, so they can't be recorded.
+	FDirectDrawing direct (backskytex != NULL);
 	int x;
 
  	if (pl->minx > pl->maxx)
@@ -1045,7 +1149,7 @@ int R_DrawPlanes ()
 
 	ds_color = 3;
 
-	for (i = 0; i < MAXVISPLANES; i++)
+	for (i = 0; i < (int)numvisplanehash; i++)
 	{
 		for (pl = visplanes[i]; pl; pl = pl->next)
 		{
@@ -1070,7 +1174,7 @@ void R_DrawHeightPlanes(fixed_t height)
 
 	ds_color = 3;
 
-	for (i = 0; i < MAXVISPLANES; i++)
+	for (i = 0; i < (int)numvisplanehash; i++)
 	{
 		for (pl = visplanes[i]; pl; pl = pl->next)
 		{
@@ -1106,6 +1210,7 @@ void R_DrawSinglePlane (visplane_t *pl, fixed_t alpha, bool additive, bool maske
 
 	if (r_drawflat)
 	{ // [RH] no texture mapping
+		FDirectDrawing direct;
 		ds_color += 4;
 		R_MapVisPlane (pl, R_MapColoredPlane);
 	}
@@ -1183,7 +1288,7 @@ void R_DrawSkyBoxes ()
 
 	numskyboxes = 0;
 
-	if (visplanes[MAXVISPLANES] == NULL)
+	if (visplanes[numvisplanehash] == NULL)
 		return;
 
 	R_3D_EnterSkybox();
@@ -1204,12 +1309,12 @@ void R_DrawSkyBoxes ()
 	int i;
 	visplane_t *pl;
 
-	for (pl = visplanes[MAXVISPLANES]; pl != NULL; pl = visplanes[MAXVISPLANES])
+	for (pl = visplanes[numvisplanehash]; pl != NULL; pl = visplanes[numvisplanehash])
 	{
 		// Pop the visplane off the list now so that if this skybox adds more
 		// skyboxes to the list, they will be drawn instead of skipped (because
 		// new skyboxes go to the beginning of the list instead of the end).
-		visplanes[MAXVISPLANES] = pl->next;
+		visplanes[numvisplanehash] = pl->next;
 		pl->next = NULL;
 
 		if (pl->maxx < pl->minx || !r_skyboxes || numskyboxes == MAX_SKYBOX_PLANES)
@@ -1364,7 +1469,7 @@ void R_DrawSkyBoxes ()
 
 	if(fakeActive) return;
 
-	for (*freehead = visplanes[MAXVISPLANES], visplanes[MAXVISPLANES] = NULL; *freehead; )
+	for (*freehead = visplanes[numvisplanehash], visplanes[numvisplanehash] = NULL; *freehead; )
 		freehead = &(*freehead)->next;
 }
 
@@ -1375,6 +1480,34 @@ ADD_STAT(skyboxes)
 	return out;
 }
 
+//==========================================================================
+//
+// STAT visplanes
+//
+// Shows how well the visplane hash table works for the last frame.
+//
+//==========================================================================
+
+ADD_STAT(visplanes)
+{
+	FString out;
+	unsigned longest = 0;
+
+	for (unsigned i = 0; i < numvisplanehash; i++)
+	{
+		unsigned length = 0;
+		for (visplane_t *pl = visplanes[i]; pl != NULL; pl = pl->next)
+		{
+			length++;
+		}
+		longest = MAX(longest, length);
+	}
+	out.Format ("%u visplanes, %u hash slots, longest chain=%u, probes/lookup=%.2f, lookup=%04.2f ms",
+		numvisplanes, numvisplanehash, longest,
+		visplanelookups ? double(visplaneprobes) / visplanelookups : 0., PlaneLookupCycles.TimeMS());
+	return out;
+}
+
 //==========================================================================
 //
 // R_DrawSkyPlane
@@ -1563,7 +1696,7 @@ void R_DrawNormalPlane (visplane_t *pl, fixed_t alpha, bool additive, bool maske
 	else
 		plane_shade = true;
 
-	if (spanfunc != R_FillSpan)
+	if (spanfunc != static_cast<void (*)(void)>(R_FillSpan))
 	{
 		if (masked)
 		{
@@ -1641,6 +1774,9 @@ void R_DrawTiltedPlane (visplane_t *pl, fixed_t alpha, bool additive, bool maske
 		return;
 	}
 
+	// The tilted span drawer reads its lighting from tiltlighting.
+	FDirectDrawing direct;
+
 	double vx = FIXED2FLOAT(viewx);
 	double vy = FIXED2FLOAT(viewy);
 	double vz = FIXED2FLOAT(viewz);
@@ -1808,32 +1944,8 @@ void R_MapVisPlane (visplane_t *pl, void (*mapfunc)(int y, int x1))
 
 bool R_PlaneInitData ()
 {
-	int i;
-	visplane_t *pl;
-
 	// Free all visplanes and let them be re-allocated as needed.
-	pl = freetail;
-
-	while (pl)
-	{
-		visplane_t *next = pl->next;
-		M_Free (pl);
-		pl = next;
-	}
-	freetail = NULL;
-	freehead = &freetail;
-
-	for (i = 0; i < MAXVISPLANES; i++)
-	{
-		pl = visplanes[i];
-		visplanes[i] = NULL;
-		while (pl)
-		{
-			visplane_t *next = pl->next;
-			M_Free (pl);
-			pl = next;
-		}
-	}
+	R_FreeVisplanes ();
 
 	return true;
 }
@@ -0,0 +1,369 @@
+//-----------------------------------------------------------------------------
+//
+// Zandronum Source
+// Copyright (C) 2026 Zandronum Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// Filename: r_renderbench.cpp
+//
+// Description: Renders frames into an offscreen canvas and reports how long the
+// renderer took for each phase.
+//
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include "actor.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "d_player.h"
+#include "doomdata.h"
+#include "doomstat.h"
+#include "g_level.h"
+#include "m_argv.h"
+#include "m_crc32.h"
+#include "p_local.h"
+#include "r_main.h"
+#include "r_renderbench.h"
+#include "r_sky.h"
+#include "r_state.h"
+#include "r_utility.h"
+#include "stats.h"
+#include "tarray.h"
+#include "textures/textures.h"
+#include "v_video.h"
+
+//*****************************************************************************
+//	DEFINES
+
+// The scripted camera path turns around in this many steps at every spot.
+#define	ANGLES_PER_SPOT		8
+
+enum
+{
+	BENCHPHASE_BSP,
+	BENCHPHASE_WALLS,
+	BENCHPHASE_PLANES,
+	BENCHPHASE_SPRITES,
+	BENCHPHASE_MASKED,
+	BENCHPHASE_FRAME,
+
+	NUM_BENCHPHASES
+};
+
+//*****************************************************************************
+//	VARIABLES
+
+extern cycle_t WallCycles, PlaneCycles, MaskedCycles;
+extern cycle_t WallDrawCycles, SpriteCycles;
+
+static	const char		*g_pszPhaseNames[NUM_BENCHPHASES] =
+{
+	"bsp",
+	"walls",
+	"planes",
+	"sprites",
+	"masked",
+	"frame",
+};
+
+// Time in milliseconds spent in each phase, one entry per frame.
+static	TArray<double>	g_FrameTimes[NUM_BENCHPHASES];
+
+static	DCanvas			*g_pCanvas = NULL;
+static	bool			g_bActive = false;
+static	DWORD			g_ulChecksum;
+
+//*****************************************************************************
+//	CONSOLE VARIABLES
+
+CVAR( Int, benchrender_width, 640, 0 )
+CVAR( Int, benchrender_height, 480, 0 )
+
+// 1 prints a checksum of all rendered frames at the end, 2 also prints the
+// checksum of every frame so the first one that differs can be found.
+CVAR( Int, benchrender_checksum, 0, 0 )
+
+//*****************************************************************************
+//	FUNCTIONS
+
+static bool renderbench_Begin( void )
+{
+	// R_RenderViewToCanvas is part of the software renderer.
+	if ( currentrenderer != 0 )
+	{
+		Printf( "The render benchmark needs the software renderer.\n" );
+		return false;
+	}
+
+	const int	lWidth = clamp<int>( benchrender_width, 32, MAXWIDTH );
+	const int	lHeight = clamp<int>( benchrender_height, 32, MAXHEIGHT );
+
+	g_pCanvas = new DSimpleCanvas( lWidth, lHeight );
+	g_pCanvas->ObjectFlags |= OF_Fixed;
+
+	for ( int i = 0; i < NUM_BENCHPHASES; i++ )
+		g_FrameTimes[i].Clear( );
+	g_ulChecksum = 0;
+	g_bActive = true;
+	return true;
+}
+
+//*****************************************************************************
+//
+static double renderbench_Percentile( const TArray<double> &Sorted, int lPercent )
+{
+	// Nearest rank.
+	int	lIndex = ( static_cast<int>( Sorted.Size( )) * lPercent + 99 ) / 100 - 1;
+
+	return Sorted[clamp<int>( lIndex, 0, Sorted.Size( ) - 1 )];
+}
+
+//*****************************************************************************
+//
+static void renderbench_PrintReport( void )
+{
+	const unsigned int	ulNumFrames = g_FrameTimes[BENCHPHASE_FRAME].Size( );
+
+	if ( ulNumFrames == 0 )
+	{
+		Printf( "No frames were rendered.\n" );
+		return;
+	}
+
+	Printf( "Rendered %u frames at %dx%d\n", ulNumFrames, g_pCanvas->GetWidth( ), g_pCanvas->GetHeight( ));
+	Printf( "%-8s %8s %8s %8s %8s %8s  (ms)\n", "phase", "mean", "p50", "p90", "p99", "max" );
+
+	for ( int i = 0; i < NUM_BENCHPHASES; i++ )
+	{
+		TArray<double>	Sorted = g_FrameTimes[i];
+		double			dTotal = 0;
+
+		std::sort( &Sorted[0], &Sorted[0] + ulNumFrames );
+		for ( unsigned int j = 0; j < ulNumFrames; j++ )
+			dTotal += Sorted[j];
+
+		Printf( "%-8s %8.3f %8.3f %8.3f %8.3f %8.3f\n", g_pszPhaseNames[i], dTotal / ulNumFrames,
+			renderbench_Percentile( Sorted, 50 ), renderbench_Percentile( Sorted, 90 ),
+			renderbench_Percentile( Sorted, 99 ), Sorted[ulNumFrames - 1] );
+	}
+
+	if ( benchrender_checksum > 0 )
+		Printf( "Checksum of all frames: %08x\n", static_cast<unsigned int>( g_ulChecksum ));
+}
+
+//*****************************************************************************
+//
+static void renderbench_End( void )
+{
+	renderbench_PrintReport( );
+
+	g_pCanvas->Destroy( );
+	g_pCanvas->ObjectFlags |= OF_YesReallyDelete;
+	delete g_pCanvas;
+	g_pCanvas = NULL;
+	g_bActive = false;
+}
+
+//*****************************************************************************
+//
+static void renderbench_Render( AActor *pViewer )
+{
+	// Interpolating the view would make the frame depend on the real time
+	// instead of only the game state.
+	const bool	bSavedNoInterpolate = r_NoInterpolate;
+	cycle_t		FrameCycles;
+
+	r_NoInterpolate = true;
+
+	g_pCanvas->Lock( );
+
+	FrameCycles.Reset( );
+	FrameCycles.Clock( );
+	R_RenderViewToCanvas( pViewer, g_pCanvas, 0, 0, g_pCanvas->GetWidth( ), g_pCanvas->GetHeight( ));
+	FrameCycles.Unclock( );
+
+	r_NoInterpolate = bSavedNoInterpolate;
+
+	// WallCycles covers both the BSP traversal and the wall drawing, and the
+	// sprites are drawn as part of the masked phase.
+	g_FrameTimes[BENCHPHASE_BSP].Push( MAX( WallCycles.TimeMS( ) - WallDrawCycles.TimeMS( ), 0. ));
+	g_FrameTimes[BENCHPHASE_WALLS].Push( WallDrawCycles.TimeMS( ));
+	g_FrameTimes[BENCHPHASE_PLANES].Push( PlaneCycles.TimeMS( ));
+	g_FrameTimes[BENCHPHASE_SPRITES].Push( SpriteCycles.TimeMS( ));
+	g_FrameTimes[BENCHPHASE_MASKED].Push( MAX( MaskedCycles.TimeMS( ) - SpriteCycles.TimeMS( ), 0. ));
+	g_FrameTimes[BENCHPHASE_FRAME].Push( FrameCycles.TimeMS( ));
+
+	if ( benchrender_checksum > 0 )
+	{
+		const BYTE	*pBuffer = g_pCanvas->GetBuffer( );
+		DWORD		ulFrameCRC = 0;
+		BYTE		CRCBytes[4];
+
+		for ( int y = 0; y < g_pCanvas->GetHeight( ); y++ )
+			ulFrameCRC = AddCRC32( ulFrameCRC, pBuffer + y * g_pCanvas->GetPitch( ), g_pCanvas->GetWidth( ));
+
+		for ( int i = 0; i < 4; i++ )
+			CRCBytes[i] = static_cast<BYTE>( ulFrameCRC >> ( i * 8 ));
+		g_ulChecksum = AddCRC32( g_ulChecksum, CRCBytes, 4 );
+
+		if ( benchrender_checksum > 1 )
+			Printf( "frame %u: %08x\n", g_FrameTimes[BENCHPHASE_FRAME].Size( ) - 1, static_cast<unsigned int>( ulFrameCRC ));
+	}
+
+	g_pCanvas->Unlock( );
+}
+
+//*****************************************************************************
+//
+void RENDERBENCH_StartDemo( void )
+{
+	if ( g_bActive || ( Args->CheckParm( "-benchrender" ) == 0 ))
+		return;
+
+	renderbench_Begin( );
+}
+
+//*****************************************************************************
+//
+void RENDERBENCH_FinishDemo( void )
+{
+	if ( g_bActive )
+		renderbench_End( );
+}
+
+//*****************************************************************************
+//
+bool RENDERBENCH_IsActive( void )
+{
+	return g_bActive;
+}
+
+//*****************************************************************************
+//
+void RENDERBENCH_RenderFrame( void )
+{
+	player_t	*pPlayer = &players[consoleplayer];
+
+	if (( gamestate != GS_LEVEL ) || ( pPlayer->mo == NULL ))
+		return;
+
+	if ( pPlayer->camera == NULL )
+		pPlayer->camera = pPlayer->mo;
+
+	R_SetFOV( pPlayer->camera->player ? pPlayer->camera->player->FOV : 90.f );
+
+	// Animate by game time so that every run renders the same frames.
+	const DWORD	ulTime = static_cast<DWORD>( static_cast<QWORD>( gametic ) * 1000 / TICRATE );
+
+	TexMan.UpdateAnimations( ulTime );
+	R_UpdateSky( ulTime );
+
+	// Render what the player sees, which may be a camera or another player.
+	renderbench_Render( pPlayer->camera );
+}
+
+//*****************************************************************************
+//	CONSOLE COMMANDS
+
+// Renders the current level from every player start, turning around in
+// place at each of them. The optional argument is the number of frames.
+CCMD( benchrender )
+{
+	if (( gamestate != GS_LEVEL ) || ( players[consoleplayer].mo == NULL ))
+	{
+		Printf( "You must be in a level to use benchrender.\n" );
+		return;
+	}
+
+	if ( g_bActive )
+		return;
+
+	TArray<FPlayerStart>	Spots;
+
+	for ( unsigned int i = 0; i < AllPlayerStarts.Size( ); i++ )
+		Spots.Push( AllPlayerStarts[i] );
+	for ( unsigned int i = 0; i < deathmatchstarts.Size( ); i++ )
+		Spots.Push( deathmatchstarts[i] );
+
+	if ( Spots.Size( ) == 0 )
+	{
+		FPlayerStart	Spot;
+		AActor			*pMo = players[consoleplayer].mo;
+
+		Spot.x = pMo->x;
+		Spot.y = pMo->y;
+		Spot.z = 0;
+		Spot.angle = static_cast<short>( pMo->angle / ANGLE_1 );
+		Spot.type = 1;
+		Spots.Push( Spot );
+	}
+
+	int	lNumFrames = Spots.Size( ) * ANGLES_PER_SPOT;
+
+	if ( argv.argc( ) > 1 )
+		lNumFrames = MAX( atoi( argv[1] ), 1 );
+
+	if ( renderbench_Begin( ) == false )
+		return;
+
+	// Use a temporary actor as the camera, so nothing in the level moves.
+	const fixed_t	ViewHeight = players[consoleplayer].mo->ViewHeight;
+	AActor			*pCamera = Spawn( "MapSpot", Spots[0].x, Spots[0].y, ONFLOORZ, NO_REPLACE );
+
+	for ( int i = 0; i < lNumFrames; i++ )
+	{
+		const FPlayerStart	&Spot = Spots[( i / ANGLES_PER_SPOT ) % Spots.Size( )];
+
+		pCamera->SetOrigin( Spot.x, Spot.y, 0 );
+		pCamera->z = pCamera->floorz + ViewHeight;
+		pCamera->PrevX = pCamera->x;
+		pCamera->PrevY = pCamera->y;
+		pCamera->PrevZ = pCamera->z;
+		pCamera->angle = ANGLE_1 * Spot.angle + ANGLE_45 * ( i % ANGLES_PER_SPOT );
+		pCamera->pitch = 0;
+
+		renderbench_Render( pCamera );
+	}
+
+	R_ClearPastViewer( pCamera );
+	camera = players[consoleplayer].camera;
+	pCamera->Destroy( );
+
+	renderbench_End( );
+}
@@ -52,6 +52,7 @@
 #include "r_3dfloors.h"
 #include "v_palette.h"
 #include "r_data/colormaps.h"
+#include "r_drawqueue.h"
 
 #define WALLYREPEAT 8
 
@@ -112,6 +113,8 @@ extern fixed_t	rw_backfz1, rw_backfz2;
 extern fixed_t	rw_frontcz1, rw_frontcz2;
 extern fixed_t	rw_frontfz1, rw_frontfz2;
 
+extern cycle_t WallScanCycles;
+
 int				rw_ceilstat, rw_floorstat;
 bool			rw_mustmarkfloor, rw_mustmarkceiling;
 bool			rw_prepped;
@@ -144,7 +147,7 @@ FTexture		*rw_pic;
 static fixed_t	*maskedtexturecol;
 static FTexture	*WallSpriteTile;
 
-static void R_RenderDecal (side_t *wall, DBaseDecal *first, drawseg_t *clipper, int pass);
+static void R_RenderDecal (side_t *wall, DBaseDecal *first, drawseg_t *clipper, int pass, FDirectDrawing &direct);
 static void WallSpriteColumn (void (*drawfunc)(const BYTE *column, const FTexture::Span *spans));
 void wallscan_np2(int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixed_t *lwal, fixed_t yrepeat, fixed_t top, fixed_t bot, bool mask);
 static void wallscan_np2_ds(drawseg_t *ds, int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixed_t *lwal, fixed_t yrepeat);
@@ -1048,7 +1051,28 @@ inline fixed_t prevline1 (fixed_t vince, BYTE *colormap, int count, fixed_t vplc
 	dc_texturefrac = vplce;
 	dc_source = bufplce;
 	dc_dest = dest;
-	return doprevline1 ();
+	return DrawerQueueActive ? R_QueueVLine1 (false) : doprevline1 ();
+}
+
+// While the drawer queue is active, the wall drawers are only recorded.
+inline DWORD vline1 ()
+{
+	return DrawerQueueActive ? R_QueueVLine1 (false) : dovline1 ();
+}
+
+inline void vline4 ()
+{
+	if (DrawerQueueActive) R_QueueVLine4 (false); else dovline4 ();
+}
+
+inline DWORD mvline1 ()
+{
+	return DrawerQueueActive ? R_QueueVLine1 (true) : domvline1 ();
+}
+
+inline void mvline4 ()
+{
+	if (DrawerQueueActive) R_QueueVLine4 (true); else domvline4 ();
 }
 
 void wallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixed_t *lwal,
@@ -1114,7 +1138,7 @@ void wallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixed_t
 		dc_count = y2ve[0] - y1ve[0];
 		dc_texturefrac = texturemid + FixedMul (dc_iscale, (y1ve[0]<<FRACBITS)-centeryfrac+FRACUNIT);
 
-		dovline1();
+		vline1();
 	}
 
 	for(; x <= x2-3; x += 4)
@@ -1175,7 +1199,7 @@ void wallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixed_t
 		{
 			dc_count = d4-u4;
 			dc_dest = ylookup[u4]+x+dc_destorg;
-			dovline4();
+			vline4();
 		}
 
 		BYTE *i = x+ylookup[d4]+dc_destorg;
@@ -1207,7 +1231,7 @@ void wallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixed_t
 		dc_count = y2ve[0] - y1ve[0];
 		dc_texturefrac = texturemid + FixedMul (dc_iscale, (y1ve[0]<<FRACBITS)-centeryfrac+FRACUNIT);
 
-		dovline1();
+		vline1();
 	}
 
 //unclock (WallScanCycles);
@@ -1392,7 +1416,7 @@ inline fixed_t mvline1 (fixed_t vince, BYTE *colormap, int count, fixed_t vplce,
 	dc_texturefrac = vplce;
 	dc_source = bufplce;
 	dc_dest = dest;
-	return domvline1 ();
+	return mvline1 ();
 }
 
 void maskwallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixed_t *lwal,
@@ -1458,7 +1482,7 @@ void maskwallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixe
 		dc_count = y2ve[0] - y1ve[0];
 		dc_texturefrac = texturemid + FixedMul (dc_iscale, (y1ve[0]<<FRACBITS)-centeryfrac+FRACUNIT);
 
-		domvline1();
+		mvline1();
 	}
 
 	for(; x <= x2-3; x += 4, p+= 4)
@@ -1517,7 +1541,7 @@ void maskwallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixe
 		{
 			dc_count = d4-u4;
 			dc_dest = ylookup[u4]+p;
-			domvline4();
+			mvline4();
 		}
 
 		BYTE *i = p+ylookup[d4];
@@ -1547,7 +1571,7 @@ void maskwallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixe
 		dc_count = y2ve[0] - y1ve[0];
 		dc_texturefrac = texturemid + FixedMul (dc_iscale, (y1ve[0]<<FRACBITS)-centeryfrac+FRACUNIT);
 
-		domvline1();
+		mvline1();
 	}
 
 //unclock(WallScanCycles);
@@ -1568,6 +1592,7 @@ inline void preptmvline1 (fixed_t vince, BYTE *colormap, int count, fixed_t vplc
 void transmaskwallscan (int x1, int x2, short *uwal, short *dwal, fixed_t *swal, fixed_t *lwal,
 	fixed_t yrepeat, const BYTE *(*getcol)(FTexture *tex, int x))
 {
+	FDirectDrawing direct;
 	fixed_t (*tmvline1)();
 	void (*tmvline4)();
 	int x, shiftval;
@@ -2574,7 +2599,9 @@ void R_StoreWallRange (int start, int stop)
 		}
 	}
 
+	WallScanCycles.Clock();
 	R_RenderSegLoop ();
+	WallScanCycles.Unclock();
 
 	if(fake3D & 7) {
 		ds_p++;
@@ -2600,9 +2627,16 @@ void R_StoreWallRange (int start, int stop)
 	}
 
 	// [RH] Draw any decals bound to the seg
-	for (DBaseDecal *decal = curline->sidedef->AttachedDecals; decal != NULL; decal = decal->WallNext)
+	// All of them share one flush of the drawer queue, which only happens
+	// once the first one is actually drawn.
+	if (curline->sidedef->AttachedDecals != NULL)
 	{
-		R_RenderDecal (curline->sidedef, decal, ds_p, 0);
+		FDirectDrawing direct (false);
+
+		for (DBaseDecal *decal = curline->sidedef->AttachedDecals; decal != NULL; decal = decal->WallNext)
+		{
+			R_RenderDecal (curline->sidedef, decal, ds_p, 0, direct);
+		}
 	}
 
 	ds_p++;
@@ -2973,7 +3007,7 @@ void PrepLWall (fixed_t *lwall, fixed_t walxrepeat)
 //		= 1: drawing masked textures (including sprites)
 // Currently, only pass = 0 is done or used
 
-static void R_RenderDecal (side_t *wall, DBaseDecal *decal, drawseg_t *clipper, int pass)
+static void R_RenderDecal (side_t *wall, DBaseDecal *decal, drawseg_t *clipper, int pass, FDirectDrawing &direct)
 {
 	fixed_t lx, ly, lx2, ly2, decalx, decaly;
 	int x1, x2;
@@ -3265,6 +3299,9 @@ static void R_RenderDecal (side_t *wall, DBaseDecal *decal, drawseg_t *clipper,
 	// rw_offset is used as the texture's vertical scale
 	rw_offset = SafeDivScale30(1, yscale);
 
+	// Decals are drawn on top of the wall, so it must be finished first.
+	direct.Begin ();
+
 	do
 	{
 		dc_x = x1;
@@ -118,7 +118,11 @@ void FSoftwareRenderer::PrecacheTexture(FTexture *tex, int cache)
 
 void FSoftwareRenderer::RenderView(player_t *player)
 {
-	R_RenderActorView (player->mo);
+	TexMan.UpdateAsyncDecodes ();
+	{
+		FAsyncDecodeScope async (true);
+		R_RenderActorView (player->mo);
+	}
 	// [RH] Let cameras draw onto textures that were visible this frame.
 	FCanvasTextureInfo::UpdateAll ();
 }
@@ -61,6 +61,7 @@
 #include "r_data/r_translate.h"
 #include "r_data/colormaps.h"
 #include "r_data/voxels.h"
+#include "stats.h"
 #include "p_local.h"
 // [BB] New #includes.
 #include "w_wad.h"
@@ -94,6 +95,7 @@ struct FCoverageBuffer
 };
 
 extern fixed_t globaluclip, globaldclip;
+extern cycle_t SpriteCycles;
 
 
 #define MINZ			(2048*4)
@@ -1996,11 +1998,13 @@ void R_DrawMaskedSingle (bool renew)
 		NETWORK_InClientMode() &&
 		( LASTMANSTANDING_GetState( ) == LMSS_INPROGRESS )) == false )
 	{
+		SpriteCycles.Clock();
 		for (i = vsprcount; i > 0; i--)
 		{
 			// [BB] Added dummy argument to stop the current wallhack.
 			R_DrawSprite (NULL, spritesorter[i-1]);
 		}
+		SpriteCycles.Unclock();
 	}
 
 	// render any remaining masked mid textures
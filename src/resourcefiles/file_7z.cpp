@@ -116,10 +116,9 @@ struct C7zArchive
 
 	C7zArchive(FileReader *file) : ArchiveStream(file)
 	{
-		if (g_CrcTable[1] == 0)
-		{
-			CrcGenerateTable();
-		}
+		// Archives may be opened on several threads at once.
+		static bool crcinit = (CrcGenerateTable(), true);
+		(void)crcinit;
 		file->Seek(0, SEEK_SET);
 		LookToRead_CreateVTable(&LookStream, false);
 		LookStream.realStream = &ArchiveStream.s;
@@ -263,9 +262,11 @@ bool F7ZFile::Open(bool quiet)
 
 	Lumps = new F7ZLump[NumLumps];
 
+	// These are not TArrays, because this may run on a worker thread.
 	F7ZLump *lump_p = Lumps;
-	TArray<UInt16> nameUTF16;
-	TArray<char> nameASCII;
+	UInt16 *nameUTF16 = NULL;
+	char *nameASCII = NULL;
+	size_t nameSize = 0;
 	for (DWORD i = 0; i < NumLumps; ++i)
 	{
 		CSzFileItem *file = &Archive->DB.db.Files[i];
@@ -285,16 +286,20 @@ bool F7ZFile::Open(bool quiet)
 			continue;
 		}
 
-		nameUTF16.Resize(nameLength);
-		nameASCII.Resize(nameLength);
-		SzArEx_GetFileNameUtf16(&Archive->DB, i, &nameUTF16[0]);
+		if (nameLength > nameSize)
+		{
+			nameSize = nameLength;
+			nameUTF16 = (UInt16 *)realloc(nameUTF16, nameSize * sizeof(UInt16));
+			nameASCII = (char *)realloc(nameASCII, nameSize);
+		}
+		SzArEx_GetFileNameUtf16(&Archive->DB, i, nameUTF16);
 		for (size_t c = 0; c < nameLength; ++c)
 		{
 			nameASCII[c] = static_cast<char>(nameUTF16[c]);
 		}
-		FixPathSeperator(&nameASCII[0]);
+		FixPathSeperator(nameASCII);
 
-		FString name = &nameASCII[0];
+		FString name = nameASCII;
 		name.ToLower();
 
 		lump_p->LumpNameSetup(name);
@@ -305,6 +310,8 @@ bool F7ZFile::Open(bool quiet)
 		lump_p->CheckEmbedded();
 		lump_p++;
 	}
+	free(nameUTF16);
+	free(nameASCII);
 	// Resize the lump record array to its actual size
 	NumLumps -= skipped;
 
@@ -312,10 +319,11 @@ bool F7ZFile::Open(bool quiet)
 	{
 		// Quick check for unsupported compression method
 
-		TArray<char> temp;
-		temp.Resize(Lumps[0].LumpSize);
+		char *temp = (char *)malloc(MAX(Lumps[0].LumpSize, 1));
+		res = Archive->Extract(Lumps[0].Position, temp);
+		free(temp);
 
-		if (SZ_OK != Archive->Extract(Lumps[0].Position, &temp[0]))
+		if (SZ_OK != res)
 		{
 			if (!quiet) Printf("\n%s: unsupported 7z/LZMA file!\n", Filename);
 			return false;
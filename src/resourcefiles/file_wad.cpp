@@ -252,7 +252,7 @@ public:
 		{
 			const char * buffer = Owner->Reader->GetBuffer();
 
-			if (buffer != NULL)
+			if (buffer != NULL && Position + LumpSize <= Owner->Reader->GetLength())
 			{
 				// This is an in-memory file so the cache can point directly to the file's data.
 				Cache = const_cast<char*>(buffer) + Position;
@@ -205,8 +205,8 @@ bool FZipFile::Open(bool quiet)
 	Reader->Seek(LittleLong(info.DirectoryOffset), SEEK_SET);
 	Reader->Read(directory, dirsize);
 
-	// [AK] Store the names of all the lumps in the current directory.
-	TArray<FString> oldNames;
+	// [AK] The lumps from firstInDirectory up to lump_p are all in the current directory.
+	FZipLump *firstInDirectory = Lumps;
 	FString currentDirectory;
 
 	char *dirptr = (char*)directory;
@@ -287,47 +287,25 @@ bool FZipFile::Open(bool quiet)
 			directoryName = name.Left(ULONG(directory - name.GetChars()));
 		}
 
-		// [AK] Check if we're in the same directory. If not, clear the list of old lump names.
+		// [AK] Check if we're in the same directory. If not, forget the old lump names.
 		if ((currentDirectory.IsEmpty()) || (currentDirectory.CompareNoCase(directoryName) != 0))
 		{
-			oldNames.Clear();
+			firstInDirectory = lump_p;
 			currentDirectory = directoryName;
 		}
 
-		// [AK] Check for any duplicate lumps in the current directory.
-		for (int i = oldNames.Size() - 1; i > -1; i--)
+		// [AK] Check for any duplicate lumps in the current directory. They are only
+		// flagged here, because this may run on a worker thread. AddResourceFile puts
+		// them on the list of duplicate lumps.
+		for (int j = int(lump_p - firstInDirectory) - 1; j > -1; j--)
 		{
-			if (oldNames[i].CompareNoCase(name) == 0)
+			if (stricmp(firstInDirectory[j].FullName, name) == 0)
 			{
-				const char *shortenedFilename = strrchr(Filename, '/');
-				if (shortenedFilename != NULL) shortenedFilename++;
-
-				const char *actualFilename = shortenedFilename != NULL ? shortenedFilename : Filename;
-				bool addDuplicate = true;
-
-				// [AK] To keep the list of duplicate lumps as small as possible, first check if this
-				// particular lump isn't already on the list. If not, add it to the list then.
-				for (unsigned int j = 0; j < DuplicateLumps.Size(); j++)
-				{
-					if ((DuplicateLumps[j].CompareNoCase(lump_p->FullName) == 0) && (DuplicateLumpFilenames[j].CompareNoCase(actualFilename) == 0 ))
-					{
-						addDuplicate = false;
-						break;
-					}
-				}
-
-				if (addDuplicate)
-				{
-					DuplicateLumps.Push(lump_p->FullName);
-					DuplicateLumpFilenames.Push(actualFilename);
-				}
-
+				lump_p->Flags |= LUMPF_DUPLICATE;
 				break;
 			}
 		}
 
-		// [AK] Add this lump name to the list.
-		oldNames.Push(name);
 		lump_p++;
 	}
 	// Resize the lump record array to its actual size
@@ -405,7 +383,8 @@ int FZipLump::FillCache()
 	if (Flags & LUMPFZIP_NEEDFILESTART) SetLumpAddress();
 	const char *buffer;
 
-	if (Method == METHOD_STORED && (buffer = Owner->Reader->GetBuffer()) != NULL)
+	if (Method == METHOD_STORED && (buffer = Owner->Reader->GetBuffer()) != NULL &&
+		Position + LumpSize <= Owner->Reader->GetLength())
 	{
 		// This is an in-memory file so the cache can point directly to the file's data.
 		Cache = const_cast<char*>(buffer) + Position;
@@ -284,6 +284,22 @@ FResourceFile *FResourceFile::OpenDirectory(const char *filename, bool quiet)
 	return CheckDir(filename, NULL, quiet);
 }
 
+//==========================================================================
+//
+// Like OpenResourceFile but only checks for Zip and 7z archives. Their
+// Open functions only allocate with new and malloc, and leave anything
+// global, like the list of duplicate lumps, to AddResourceFile. Unlike
+// the other formats they can be opened on a worker thread.
+//
+//==========================================================================
+
+FResourceFile *FResourceFile::OpenArchive(const char *filename, FileReader *file, bool quiet)
+{
+	FResourceFile *resfile = CheckZip(filename, file, quiet);
+	if (resfile == NULL) resfile = Check7Z(filename, file, quiet);
+	return resfile;
+}
+
 //==========================================================================
 //
 // Resource file base class
@@ -339,7 +355,7 @@ int FUncompressedLump::FillCache()
 {
 	const char * buffer = Owner->Reader->GetBuffer();
 
-	if (buffer != NULL)
+	if (buffer != NULL && Position + LumpSize <= Owner->Reader->GetLength())
 	{
 		// This is an in-memory file so the cache can point directly to the file's data.
 		Cache = const_cast<char*>(buffer) + Position;
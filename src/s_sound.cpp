@@ -51,6 +51,7 @@
 #include "g_level.h"
 #include "po_man.h"
 #include "farchive.h"
+#include "stats.h"
 // [BB] New #includes.
 #include "cl_demo.h"
 #include "deathmatch.h"
@@ -108,6 +109,8 @@ extern float S_GetMusicVolume (const char *music);
 
 static bool S_CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_limit, float limit_range, AActor *actor, int channel);
 static bool S_IsChannelUsed(AActor *actor, int channel, int *seen);
+static void S_IndexChannel(FSoundChan *chan);
+static void S_UnindexChannel(FSoundChan *chan);
 static void S_ActivatePlayList(bool goBack);
 static void CalcPosVel(FSoundChan *chan, FVector3 *pos, FVector3 *vel);
 static void CalcPosVel(int type, const AActor *actor, const sector_t *sector, const FPolyObj *poly,
@@ -129,6 +132,18 @@ static int		RestartEvictionsAt;	// do not restart evicted channels before this l
 static bool		g_bNewSoundCurve;
 static BYTE		*g_aOriginalSoundCurve;
 
+// Active channels are also kept in small hash tables by SoundID and by
+// source actor, so that the checks done for every new sound don't have to
+// walk the whole channel list. Both keep the order of the Channels list.
+enum { CHANNEL_INDEX_SIZE = 256 };
+static FSoundChan *ChannelsBySound[CHANNEL_INDEX_SIZE];
+static FSoundChan *ChannelsByActor[CHANNEL_INDEX_SIZE];
+static DWORD	ChannelSequence;
+
+static int		SoundsStarted, SoundsCulled, SoundsLimited;
+static int		LastSoundsStarted, LastSoundsCulled, LastSoundsLimited;
+static cycle_t	UpdateSoundsCycles;
+
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
 int sfx_empty;
@@ -143,6 +158,7 @@ int S_SoundCurveSize;
 FBoolCVar noisedebug ("noise", false, 0);	// [RH] Print sound debugging info?
 CVAR (Int, snd_channels, 32, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)	// number of channels available
 CVAR (Bool, snd_flipstereo, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+CVAR (Bool, snd_cullinaudible, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)	// don't start sounds that are out of earshot
 
 // [AK] Prevents any music changes as if a playlist was playing, originally from ZCC.
 CVAR (Bool, snd_lockmusic, false, CVAR_ARCHIVE);
@@ -631,6 +647,7 @@ FISoundChannel *S_GetChannel(void *syschan)
 	}
 	S_LinkChannel(chan, &Channels);
 	chan->SysChannel = syschan;
+	chan->Sequence = ++ChannelSequence;
 	return chan;
 }
 
@@ -644,6 +661,7 @@ FISoundChannel *S_GetChannel(void *syschan)
 
 void S_ReturnChannel(FSoundChan *chan)
 {
+	S_UnindexChannel(chan);
 	S_UnlinkChannel(chan);
 	memset(chan, 0, sizeof(*chan));
 	S_LinkChannel(chan, &FreeChannels);
@@ -681,6 +699,90 @@ void S_LinkChannel(FSoundChan *chan, FSoundChan **head)
 	chan->PrevChan = head;
 }
 
+//==========================================================================
+//
+// S_IndexChannel
+//
+// Adds a channel to the SoundID and actor indices once its source has
+// been set up. The buckets are sorted like the Channels list, newest
+// first, so that searches find the same channel first as a walk of the
+// Channels list would.
+//
+//==========================================================================
+
+static inline unsigned int S_ActorIndexHash(const AActor *actor)
+{
+	return (DWORD(size_t(actor) >> 3) * 2654435761u) >> 24;
+}
+
+static void S_IndexChannelActor(FSoundChan *chan)
+{
+	if (chan->SourceType == SOURCE_Actor && chan->Actor != NULL)
+	{
+		FSoundChan **head = &ChannelsByActor[S_ActorIndexHash(chan->Actor)];
+
+		while (*head != NULL && (*head)->Sequence > chan->Sequence)
+		{
+			head = &(*head)->NextByActor;
+		}
+		chan->NextByActor = *head;
+		if (chan->NextByActor != NULL)
+		{
+			chan->NextByActor->PrevByActor = &chan->NextByActor;
+		}
+		*head = chan;
+		chan->PrevByActor = head;
+	}
+}
+
+static void S_UnindexChannelActor(FSoundChan *chan)
+{
+	if (chan->PrevByActor != NULL)
+	{
+		*(chan->PrevByActor) = chan->NextByActor;
+		if (chan->NextByActor != NULL)
+		{
+			chan->NextByActor->PrevByActor = chan->PrevByActor;
+		}
+		chan->NextByActor = NULL;
+		chan->PrevByActor = NULL;
+	}
+}
+
+static void S_IndexChannel(FSoundChan *chan)
+{
+	FSoundChan **head = &ChannelsBySound[chan->SoundID & (CHANNEL_INDEX_SIZE - 1)];
+
+	while (*head != NULL && (*head)->Sequence > chan->Sequence)
+	{
+		head = &(*head)->NextBySound;
+	}
+	chan->NextBySound = *head;
+	if (chan->NextBySound != NULL)
+	{
+		chan->NextBySound->PrevBySound = &chan->NextBySound;
+	}
+	*head = chan;
+	chan->PrevBySound = head;
+
+	S_IndexChannelActor(chan);
+}
+
+static void S_UnindexChannel(FSoundChan *chan)
+{
+	if (chan->PrevBySound != NULL)
+	{
+		*(chan->PrevBySound) = chan->NextBySound;
+		if (chan->NextBySound != NULL)
+		{
+			chan->NextBySound->PrevBySound = chan->PrevBySound;
+		}
+		chan->NextBySound = NULL;
+		chan->PrevBySound = NULL;
+	}
+	S_UnindexChannelActor(chan);
+}
+
 // [RH] Split S_StartSoundAtVolume into multiple parts so that sounds can
 //		be specified both by id and by name. Also borrowed some stuff from
 //		Hexen and parameters from Quake.
@@ -877,6 +979,32 @@ static void CalcPolyobjSoundOrg(const FPolyObj *poly, fixed_t *x, fixed_t *y, fi
 //
 //==========================================================================
 
+//==========================================================================
+//
+// S_IsInaudible
+//
+// Returns true if a sound at pos is too far away from the listener to be
+// heard at all. Such sounds are not started, so that they don't take
+// channels away from the sounds nearby.
+//
+//==========================================================================
+
+static bool S_IsInaudible(const SoundListener &listener, const FVector3 &pos, FRolloffInfo *rolloff, float attenuation)
+{
+	if (!snd_cullinaudible || !listener.valid)
+	{
+		return false;
+	}
+	float distance = (pos - listener.position).Length();
+	return S_GetRolloff(rolloff, distance * attenuation, true) <= 0;
+}
+
+//==========================================================================
+//
+// S_StartSound
+//
+//==========================================================================
+
 static FSoundChan *S_StartSound(AActor *actor, const sector_t *sec, const FPolyObj *poly,
 	const FVector3 *pt, int channel, FSoundID sound_id, float volume, float attenuation,
 	FRolloffInfo *forcedrolloff=NULL)
@@ -1035,6 +1163,7 @@ static FSoundChan *S_StartSound(AActor *actor, const sector_t *sec, const FPolyO
 	if (near_limit > 0 && S_CheckSoundLimit(sfx, pos, near_limit, limit_range, actor, channel))
 	{
 		chanflags |= CHAN_EVICTED;
+		SoundsLimited++;
 	}
 
 	// If the sound is blocked and not looped, return now. If the sound
@@ -1090,7 +1219,18 @@ static FSoundChan *S_StartSound(AActor *actor, const sector_t *sec, const FPolyO
 	}
 
 	// If this actor is already playing something on the selected channel, stop it.
-	if (type != SOURCE_None && ((actor == NULL && channel != CHAN_AUTO) || (actor != NULL && S_IsChannelUsed(actor, channel, &seen))))
+	if (type == SOURCE_Actor && S_IsChannelUsed(actor, channel, &seen))
+	{
+		for (chan = ChannelsByActor[S_ActorIndexHash(actor)]; chan != NULL; chan = chan->NextByActor)
+		{
+			if (chan->Actor == actor && chan->EntChannel == channel)
+			{
+				S_StopChannel(chan);
+				break;
+			}
+		}
+	}
+	else if (type != SOURCE_None && actor == NULL && channel != CHAN_AUTO)
 	{
 		for (chan = Channels; chan != NULL; chan = chan->NextChan)
 		{
@@ -1148,7 +1288,15 @@ static FSoundChan *S_StartSound(AActor *actor, const sector_t *sec, const FPolyO
 		{
 			SoundListener listener;
 			S_SetListener(listener, players[consoleplayer].camera);
-			chan = (FSoundChan*)GSnd->StartSound3D (sfx->data, &listener, volume, rolloff, attenuation, pitch, basepriority, pos, vel, channel, startflags, NULL);
+			if (basepriority == 0 && !(chanflags & (CHAN_LOOP | CHAN_AREA)) && S_IsInaudible(listener, pos, rolloff, attenuation))
+			{
+				chan = NULL;
+				SoundsCulled++;
+			}
+			else
+			{
+				chan = (FSoundChan*)GSnd->StartSound3D (sfx->data, &listener, volume, rolloff, attenuation, pitch, basepriority, pos, vel, channel, startflags, NULL);
+			}
 		}
 		else
 		{
@@ -1190,6 +1338,11 @@ static FSoundChan *S_StartSound(AActor *actor, const sector_t *sec, const FPolyO
 		case SOURCE_Unattached:	chan->Point[0] = pt->X; chan->Point[1] = pt->Y; chan->Point[2] = pt->Z;	break;
 		default:										break;
 		}
+		S_IndexChannel(chan);
+		if (!(chanflags & CHAN_EVICTED))
+		{
+			SoundsStarted++;
+		}
 	}
 	return chan;
 }
@@ -1494,9 +1647,11 @@ bool S_CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_limit, floa
 	FSoundChan *chan;
 	int count;
 	
-	for (chan = Channels, count = 0; chan != NULL && count < near_limit; chan = chan->NextChan)
+	int sound_id = int(sfx - &S_sfx[0]);
+
+	for (chan = ChannelsBySound[sound_id & (CHANNEL_INDEX_SIZE - 1)], count = 0; chan != NULL && count < near_limit; chan = chan->NextBySound)
 	{
-		if (!(chan->ChanFlags & CHAN_EVICTED) && &S_sfx[chan->SoundID] == sfx)
+		if (!(chan->ChanFlags & CHAN_EVICTED) && chan->SoundID == sound_id)
 		{
 			FVector3 chanorigin;
 
@@ -1535,12 +1690,15 @@ bool S_IsMusicPaused ( void )
 
 void S_StopSoundID (int sound_id, int channel)
 {
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	FSoundChan *chan = ChannelsBySound[sound_id & (CHANNEL_INDEX_SIZE - 1)];
+	while (chan != NULL)
 	{
+		FSoundChan *next = chan->NextBySound;
 		if ( (chan->SoundID == sound_id) && (chan->EntChannel == channel) )
 		{
 			S_StopChannel(chan);
 		}
+		chan = next;
 	}
 }
 
@@ -1577,12 +1735,11 @@ void S_StopSound (int channel)
 
 void S_StopSound (AActor *actor, int channel)
 {
-	FSoundChan *chan = Channels;
+	FSoundChan *chan = ChannelsByActor[S_ActorIndexHash(actor)];
 	while (chan != NULL)
 	{
-		FSoundChan *next = chan->NextChan;
-		if (chan->SourceType == SOURCE_Actor &&
-			chan->Actor == actor &&
+		FSoundChan *next = chan->NextByActor;
+		if (chan->Actor == actor &&
 			(chan->EntChannel == channel || (i_compatflags & COMPATF_MAGICSILENCE)))
 		{
 			S_StopChannel(chan);
@@ -1724,18 +1881,21 @@ void S_RelinkSound (AActor *from, AActor *to)
 	if (from == NULL)
 		return;
 
-	FSoundChan *chan = Channels;
+	FSoundChan *chan = ChannelsByActor[S_ActorIndexHash(from)];
 	while (chan != NULL)
 	{
-		FSoundChan *next = chan->NextChan;
-		if (chan->SourceType == SOURCE_Actor && chan->Actor == from)
+		FSoundChan *next = chan->NextByActor;
+		if (chan->Actor == from)
 		{
 			if (to != NULL)
 			{
+				S_UnindexChannelActor(chan);
 				chan->Actor = to;
+				S_IndexChannelActor(chan);
 			}
 			else if (!(chan->ChanFlags & CHAN_LOOP))
 			{
+				S_UnindexChannelActor(chan);
 				chan->Actor = NULL;
 				chan->SourceType = SOURCE_Unattached;
 				chan->Point[0] = FIXED2FLOAT(from->x);
@@ -1760,10 +1920,9 @@ void S_RelinkSound (AActor *from, AActor *to)
 
 bool S_ChangeSoundVolume(AActor *actor, int channel, float volume)
 {
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = ChannelsByActor[S_ActorIndexHash(actor)]; chan != NULL; chan = chan->NextByActor)
 	{
-		if (chan->SourceType == SOURCE_Actor &&
-			chan->Actor == actor &&
+		if (chan->Actor == actor &&
 			(chan->EntChannel == channel || (i_compatflags & COMPATF_MAGICSILENCE)))
 		{
 			GSnd->ChannelVolume(chan, volume);
@@ -1785,10 +1944,9 @@ bool S_GetSoundPlayingInfo (const AActor *actor, int sound_id)
 {
 	if (sound_id > 0)
 	{
-		for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+		for (FSoundChan *chan = ChannelsByActor[S_ActorIndexHash(actor)]; chan != NULL; chan = chan->NextByActor)
 		{
 			if (chan->OrgID == sound_id &&
-				chan->SourceType == SOURCE_Actor &&
 				chan->Actor == actor)
 			{
 				return true;
@@ -1848,9 +2006,9 @@ static bool S_IsChannelUsed(AActor *actor, int channel, int *seen)
 	{
 		return true;
 	}
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = ChannelsByActor[S_ActorIndexHash(actor)]; chan != NULL; chan = chan->NextByActor)
 	{
-		if (chan->SourceType == SOURCE_Actor && chan->Actor == actor)
+		if (chan->Actor == actor)
 		{
 			*seen |= 1 << chan->EntChannel;
 			if (chan->EntChannel == channel)
@@ -1875,9 +2033,9 @@ bool S_IsActorPlayingSomething (AActor *actor, int channel, int sound_id)
 		channel = 0;
 	}
 
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = ChannelsByActor[S_ActorIndexHash(actor)]; chan != NULL; chan = chan->NextByActor)
 	{
-		if (chan->SourceType == SOURCE_Actor && chan->Actor == actor)
+		if (chan->Actor == actor)
 		{
 			if (channel == 0 || chan->EntChannel == channel)
 			{
@@ -2093,6 +2251,14 @@ void S_UpdateSounds (AActor *listenactor)
 	if ( NETWORK_GetState( ) == NETSTATE_SERVER )
 		return;
 
+	LastSoundsStarted = SoundsStarted;
+	LastSoundsCulled = SoundsCulled;
+	LastSoundsLimited = SoundsLimited;
+	SoundsStarted = SoundsCulled = SoundsLimited = 0;
+
+	UpdateSoundsCycles.Reset();
+	UpdateSoundsCycles.Clock();
+
 	I_UpdateMusic();
 
 	// [RH] Update music and/or playlist. IsPlaying() must be called
@@ -2130,6 +2296,7 @@ void S_UpdateSounds (AActor *listenactor)
 		RestartEvictionsAt = 0;
 		S_RestoreEvictedChannels();
 	}
+	UpdateSoundsCycles.Unclock();
 }
 
 //==========================================================================
@@ -2321,6 +2488,7 @@ void S_StopChannel(FSoundChan *chan)
 			chan->ChanFlags |= CHAN_FORGETTABLE;
 			if (chan->SourceType == SOURCE_Actor)
 			{
+				S_UnindexChannelActor(chan);
 				chan->Actor = NULL;
 			}
 		}
@@ -2438,6 +2606,7 @@ void S_SerializeSounds(FArchive &arc)
 		{
 			chan = (FSoundChan*)S_GetChannel(NULL);
 			arc << *chan;
+			S_IndexChannel(chan);
 			// Sounds always start out evicted when restored from a save.
 			chan->ChanFlags |= CHAN_EVICTED | CHAN_ABSTIME;
 		}
@@ -3245,3 +3414,26 @@ CCMD (cachesound)
 		}
 	}
 }
+
+//==========================================================================
+//
+// STAT sounds
+//
+// Sounds started, culled for being out of earshot and held back by their
+// NearLimit since the previous S_UpdateSounds, and the time it took.
+//
+//==========================================================================
+
+ADD_STAT (sounds)
+{
+	FString out;
+	int count = 0;
+
+	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	{
+		count++;
+	}
+	out.Format ("channels=%d started=%d culled=%d limited=%d update=%04.2f ms",
+		count, LastSoundsStarted, LastSoundsCulled, LastSoundsLimited, UpdateSoundsCycles.TimeMS());
+	return out;
+}
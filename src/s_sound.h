@@ -178,6 +178,11 @@ struct FSoundChan : public FISoundChannel
 {
 	FSoundChan	*NextChan;	// Next channel in this list.
 	FSoundChan **PrevChan;	// Previous channel in this list.
+	FSoundChan	*NextBySound;	// Next channel in this SoundID's index bucket.
+	FSoundChan **PrevBySound;
+	FSoundChan	*NextByActor;	// Next channel in this Actor's index bucket.
+	FSoundChan **PrevByActor;
+	DWORD		Sequence;	// Channels with a higher sequence were allocated later.
 	FSoundID	SoundID;	// Sound ID of playing sound.
 	FSoundID	OrgID;		// Sound ID of sound used to start this channel.
 	float		Volume;
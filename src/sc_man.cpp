@@ -23,9 +23,19 @@
 #include "templates.h"
 #include "doomstat.h"
 #include "v_text.h"
+#include "c_dispatch.h"
+#include "doomerrors.h"
+#include "stats.h"
 
 // MACROS ------------------------------------------------------------------
 
+// Whitespace and comments are skipped 16 bytes at a time where SSE2 is
+// available.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SC_SSE2
+#include <emmintrin.h>
+#endif
+
 // TYPES -------------------------------------------------------------------
 
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
@@ -42,6 +52,210 @@
 
 // CODE --------------------------------------------------------------------
 
+//==========================================================================
+//
+// CountNewlines
+//
+//==========================================================================
+
+static int CountNewlines (const char *p, const char *end)
+{
+	int count = 0;
+
+#ifdef SC_SSE2
+	const __m128i newline = _mm_set1_epi8('\n');
+	for (; end - p >= 16; p += 16)
+	{
+		unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), newline));
+		for (; mask != 0; mask &= mask - 1)
+		{
+			count++;
+		}
+	}
+#endif
+	for (; p < end; ++p)
+	{
+		count += (*p == '\n');
+	}
+	return count;
+}
+
+//==========================================================================
+//
+// FindCommentEnd
+//
+// Returns the position of the next "*/" or NULL if there is none.
+//
+//==========================================================================
+
+static const char *FindCommentEnd (const char *p, const char *end)
+{
+	while ((p = (const char *)memchr (p, '*', end - p)) != NULL)
+	{
+		if (end - p >= 2 && p[1] == '/')
+		{
+			return p;
+		}
+		p++;
+	}
+	return NULL;
+}
+
+//==========================================================================
+//
+// BlankBlock
+//
+// Checks if the next 16 characters are all whitespace on the same line.
+//
+//==========================================================================
+
+#ifdef SC_SSE2
+static inline bool BlankBlock (const char *p, bool tokens)
+{
+	const __m128i chars = _mm_loadu_si128((const __m128i *)p);
+	const __m128i newlines = _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n'));
+	__m128i blanks;
+
+	if (tokens)
+	{
+		// Space, \t, \v, \f and \r
+		const __m128i ctrl = _mm_and_si128(
+			_mm_cmpeq_epi8(_mm_max_epu8(chars, _mm_set1_epi8('\t')), chars),
+			_mm_cmpeq_epi8(_mm_min_epu8(chars, _mm_set1_epi8('\r')), chars));
+		blanks = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')), ctrl);
+	}
+	else
+	{
+		// Everything up to and including space
+		blanks = _mm_cmpeq_epi8(_mm_min_epu8(chars, _mm_set1_epi8(' ')), chars);
+	}
+	return _mm_movemask_epi8(_mm_andnot_si128(newlines, blanks)) == 0xFFFF;
+}
+#endif
+
+//==========================================================================
+//
+// ParseDecimal
+//
+// Fast path for the plain decimal numbers that make up nearly all numeric
+// constants in scripts. Returns false for anything strtol has to handle:
+// hex, octal, suffixes and numbers that could overflow.
+//
+//==========================================================================
+
+static inline bool ParseDecimal (const char *p, int &value)
+{
+	bool negative = false;
+	int v = 0, digits = 0;
+
+	if (*p == '-' || *p == '+')
+	{
+		negative = (*p++ == '-');
+	}
+	if (*p == '0' && p[1] != '\0')
+	{
+		return false;
+	}
+	for (; *p >= '0' && *p <= '9'; ++p)
+	{
+		if (++digits > 9)
+		{
+			return false;
+		}
+		v = v * 10 + (*p - '0');
+	}
+	if (digits == 0 || *p != '\0')
+	{
+		return false;
+	}
+	value = negative ? -v : v;
+	return true;
+}
+
+//==========================================================================
+//
+// ParseFloat
+//
+// Fast path for short decimal floats. With at most 15 significant digits
+// and a power of ten of at most 22 both operands are exact, so the one
+// multiplication or division rounds the same way strtod does. Anything
+// else is left to strtod.
+//
+//==========================================================================
+
+static inline bool ParseFloat (const char *p, double &value)
+{
+	static const double powers[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	bool negative = false;
+	SQWORD mantissa = 0;
+	int digits = 0, scale = 0;
+
+	if (*p == '-' || *p == '+')
+	{
+		negative = (*p++ == '-');
+	}
+	for (; *p >= '0' && *p <= '9'; ++p)
+	{
+		if (++digits > 15)
+		{
+			return false;
+		}
+		mantissa = mantissa * 10 + (*p - '0');
+	}
+	if (*p == '.')
+	{
+		for (++p; *p >= '0' && *p <= '9'; ++p, --scale)
+		{
+			if (++digits > 15)
+			{
+				return false;
+			}
+			mantissa = mantissa * 10 + (*p - '0');
+		}
+	}
+	if (digits == 0)
+	{
+		return false;
+	}
+	if (*p == 'e' || *p == 'E')
+	{
+		bool negexp = false;
+		int exponent = 0, expdigits = 0;
+
+		if (*++p == '-' || *p == '+')
+		{
+			negexp = (*p++ == '-');
+		}
+		for (; *p >= '0' && *p <= '9'; ++p)
+		{
+			if (++expdigits > 3)
+			{
+				return false;
+			}
+			exponent = exponent * 10 + (*p - '0');
+		}
+		if (expdigits == 0)
+		{
+			return false;
+		}
+		scale += negexp ? -exponent : exponent;
+	}
+	if (*p != '\0' || scale < -22 || scale > 22)
+	{
+		return false;
+	}
+	value = scale < 0 ? double(mantissa) / powers[-scale] : double(mantissa) * powers[scale];
+	if (negative)
+	{
+		value = -value;
+	}
+	return true;
+}
+
 //==========================================================================
 //
 // FScanner Constructor
@@ -110,18 +324,34 @@ FScanner &FScanner::operator=(const FScanner &other)
 	ScriptOpen = true;
 	ScriptName = other.ScriptName;
 	ScriptBuffer = other.ScriptBuffer;
-	ScriptPtr = other.ScriptPtr;
-	ScriptEndPtr = other.ScriptEndPtr;
+
+	// A scanner in view mode keeps its buffer locked, so this can be a copy
+	// of it instead of a reference to the same text.
+	const char *base = ScriptBuffer.GetChars();
+	const char *otherbase = other.ScriptBuffer.GetChars();
+	ScriptPtr = base + (other.ScriptPtr - otherbase);
+	ScriptEndPtr = base + (other.ScriptEndPtr - otherbase);
 	AlreadyGot = other.AlreadyGot;
 	AlreadyGotLine = other.AlreadyGotLine;
 	LastGotToken = other.LastGotToken;
-	LastGotPtr = other.LastGotPtr;
+	LastGotPtr = other.LastGotPtr == NULL ? NULL : base + (other.LastGotPtr - otherbase);
 	LastGotLine = other.LastGotLine;
 	CMode = other.CMode;
 	Escape = other.Escape;
+	ViewMode = other.ViewMode;
+	if (ViewMode)
+	{
+		ScriptBuffer.LockBuffer();
+	}
+	ViewEnd = other.ViewEnd == NULL ? NULL : const_cast<char *>(base) + (other.ViewEnd - otherbase);
+	ViewChar = other.ViewChar;
 
 	// Copy public members
-	if (other.String == other.StringBuffer)
+	if (other.String >= otherbase && other.String <= other.ScriptEndPtr)
+	{
+		String = const_cast<char *>(base) + (other.String - otherbase);
+	}
+	else if (other.String == other.StringBuffer)
 	{
 		memcpy(StringBuffer, other.StringBuffer, sizeof(StringBuffer));
 		BigStringBuffer = "";
@@ -262,6 +492,8 @@ void FScanner::PrepareScript ()
 	LastGotLine = 1;
 	CMode = false;
 	Escape = true;
+	ViewMode = false;
+	ViewEnd = NULL;
 	StringBuffer[0] = '\0';
 	BigStringBuffer = "";
 }
@@ -276,6 +508,8 @@ void FScanner::Close ()
 {
 	ScriptOpen = false;
 	ScriptBuffer = "";
+	ViewMode = false;
+	ViewEnd = NULL;
 	BigStringBuffer = "";
 	StringBuffer[0] = '\0';
 	String = StringBuffer;
@@ -344,6 +578,7 @@ bool FScanner::isText()
 	for(unsigned int i=0;i<ScriptBuffer.Len();i++)
 	{
 		int c = ScriptBuffer[i];
+		if (&ScriptBuffer[i] == ViewEnd) c = ViewChar;
 		if (c < ' ' && c != '\n' && c != '\r' && c != '\t') return false;
 	}
 	return true;
@@ -377,6 +612,39 @@ void FScanner::SetEscape (bool esc)
 	Escape = esc;
 }
 
+//==========================================================================
+//
+// FScanner :: SetViewMode
+//
+// In view mode, tokens are not copied into a separate buffer. String
+// points straight into the script text, which gets terminated behind the
+// token until the next one is read. Only parsers that never write to
+// String may turn this on; anything written there would end up in the
+// script and be seen again after UnGet or RestorePos.
+//
+//==========================================================================
+
+void FScanner::SetViewMode (bool views)
+{
+	if (views && !ViewMode && ScriptOpen)
+	{
+		// The text is about to be written to, so it must not be shared.
+		const char *oldbase = ScriptBuffer.GetChars();
+		ptrdiff_t scriptofs = ScriptPtr - oldbase;
+		ptrdiff_t endofs = ScriptEndPtr - oldbase;
+		ptrdiff_t lastofs = LastGotPtr != NULL ? LastGotPtr - oldbase : 0;
+		const char *base = ScriptBuffer.LockBuffer();
+		ScriptPtr = base + scriptofs;
+		ScriptEndPtr = base + endofs;
+		if (LastGotPtr != NULL) LastGotPtr = base + lastofs;
+	}
+	else if (!views && ViewMode)
+	{
+		ScriptBuffer.UnlockBuffer();
+	}
+	ViewMode = views;
+}
+
 //==========================================================================
 //
 // FScanner::ScanString
@@ -409,16 +677,128 @@ bool FScanner::ScanString (bool tokens)
 		return false;
 	}
 
+	// The text behind the last token in view mode has to be put back before
+	// it can be scanned.
+	char *lastend = ViewEnd;
+	if (lastend != NULL)
+	{
+		*lastend = ViewChar;
+		ViewEnd = NULL;
+	}
+
 	LastGotPtr = ScriptPtr;
 	LastGotLine = Line;
 
 	// In case the generated scanner does not use marker, avoid compiler warnings.
 	marker;
 #include "sc_man_scanner.h"
+	if (!return_val && lastend != NULL)
+	{
+		// Nothing new was found, so the last token stays valid.
+		ViewEnd = lastend;
+		ViewChar = *lastend;
+		*lastend = '\0';
+	}
 	LastGotToken = tokens;
 	return return_val;
 }
 
+//==========================================================================
+//
+// FScanner :: SkipBlanks
+//
+// Skips the whitespace and comments in front of the next token before the
+// generated scanner gets to see them. Those go through it one character
+// at a time, so this does the same thing in bulk. Returns false if the
+// script ends before another token.
+//
+//==========================================================================
+
+bool FScanner::SkipBlanks (const char *&cursor, bool tokens)
+{
+	const char *p = cursor;
+	const char *limit = ScriptEndPtr;
+	bool hexencomments = !tokens && !CMode;
+
+	for (;;)
+	{
+		while (p < limit)
+		{
+			unsigned char c = *p;
+
+			if (c == '\n')
+			{
+				if (++p >= limit)
+				{
+					cursor = p;
+					return false;
+				}
+				Line++;
+				Crossed = true;
+#ifdef SC_SSE2
+				while (limit - p >= 16 && BlankBlock(p, tokens))
+				{
+					p += 16;
+				}
+#endif
+			}
+			else if (tokens ? (c == ' ' || (c >= '\t' && c <= '\r')) : c <= ' ')
+			{
+				p++;
+			}
+			else
+			{
+				break;
+			}
+		}
+		if (p >= limit)
+		{
+			cursor = limit;
+			return false;
+		}
+		if (*p == '/' && p[1] == '*')
+		{
+			const char *end = FindCommentEnd(p + 2, limit);
+			if (end == NULL)
+			{
+				// The comment runs to the end of the script. The scanner doesn't
+				// count the last line break then, so neither does this.
+				int lines = CountNewlines(p + 2, limit) - 1;
+				if (lines > 0)
+				{
+					Line += lines;
+					Crossed = true;
+				}
+				cursor = limit;
+				return false;
+			}
+			int lines = CountNewlines(p + 2, end);
+			if (lines > 0)
+			{
+				Line += lines;
+				Crossed = true;
+			}
+			p = end + 2;
+		}
+		else if ((*p == '/' && p[1] == '/') || (*p == ';' && hexencomments))
+		{
+			// Skip to the line break; the loop above takes care of that.
+			const char *end = (const char *)memchr(p, '\n', limit - p);
+			if (end == NULL)
+			{
+				break;
+			}
+			p = end;
+		}
+		else
+		{
+			break;
+		}
+	}
+	cursor = p;
+	return true;
+}
+
 //==========================================================================
 //
 // FScanner :: GetString
@@ -499,14 +879,20 @@ bool FScanner::GetToken ()
 		}
 		else if (TokenType == TK_IntConst)
 		{
-			char *stopper;
-			Number = strtol(String, &stopper, 0);
+			if (!ParseDecimal(String, Number))
+			{
+				char *stopper;
+				Number = strtol(String, &stopper, 0);
+			}
 			Float = Number;
 		}
 		else if (TokenType == TK_FloatConst)
 		{
-			char *stopper;
-			Float = strtod(String, &stopper);
+			if (!ParseFloat(String, Float))
+			{
+				char *stopper;
+				Float = strtod(String, &stopper);
+			}
 		}
 		else if (TokenType == TK_StringConst)
 		{
@@ -598,7 +984,7 @@ bool FScanner::GetNumber ()
 		{
 			Number = INT_MAX;
 		}
-		else
+		else if (!ParseDecimal (String, Number))
 		{
 			Number = strtol (String, &stopper, 0);
 			if (*stopper != 0)
@@ -653,7 +1039,7 @@ bool FScanner::CheckNumber ()
 		{
 			Number = INT_MAX;
 		}
-		else
+		else if (!ParseDecimal (String, Number))
 		{
 			Number = strtol (String, &stopper, 0);
 			if (*stopper != 0)
@@ -691,6 +1077,10 @@ bool FScanner::CheckFloat ()
 			return false;
 		}
 	
+		if (ParseFloat (String, Float))
+		{
+			return true;
+		}
 		Float = strtod (String, &stopper);
 		if (*stopper != 0)
 		{
@@ -719,6 +1109,11 @@ bool FScanner::GetFloat ()
 	CheckOpen ();
 	if (GetString())
 	{
+		if (ParseFloat (String, Float))
+		{
+			Number = (int)Float;
+			return true;
+		}
 		Float = strtod (String, &stopper);
 		if (*stopper != 0)
 		{
@@ -1071,3 +1466,128 @@ void STACK_ARGS FScriptPosition::Message (int severity, const char *message, ...
 }
 
 
+//==========================================================================
+//
+// BenchScan
+//
+// Reads a script to the end and returns the number of tokens in it, or -1
+// if it does not scan in this mode.
+//
+//==========================================================================
+
+static int BenchScan (FScanner &sc, bool tokens, cycle_t &time)
+{
+	int count = 0;
+
+	time.Clock();
+	try
+	{
+		if (tokens)
+		{
+			while (sc.GetToken()) count++;
+		}
+		else
+		{
+			while (sc.GetString()) count++;
+		}
+	}
+	catch (CRecoverableError &)
+	{
+		count = -1;
+	}
+	time.Unclock();
+	return count;
+}
+
+//==========================================================================
+//
+// CCMD benchparse
+//
+// Times the scanner in each of its modes over all lumps with the given
+// names, or over the common script lumps if no names are given.
+//
+//==========================================================================
+
+CCMD (benchparse)
+{
+	static const char *const defaultnames[] =
+	{
+		"DECORATE", "MAPINFO", "ZMAPINFO", "SNDINFO", "TEXTURES", "GLDEFS",
+		"LANGUAGE", "ANIMDEFS", "SNDSEQ", "TEXTMAP", NULL
+	};
+	static const char *const modenames[] =
+	{
+		"strings", "string views", "tokens", "token views"
+	};
+	TArray<const char *> names;
+	cycle_t times[4];
+	int counts[4] = { 0 }, failed[4] = { 0 };
+	int lumps = 0;
+	double bytes = 0;
+
+	for (int i = 1; i < argv.argc(); ++i)
+	{
+		names.Push(argv[i]);
+	}
+	if (names.Size() == 0)
+	{
+		for (const char *const *name = defaultnames; *name != NULL; ++name)
+		{
+			names.Push(*name);
+		}
+	}
+	for (int mode = 0; mode < 4; ++mode)
+	{
+		times[mode].Reset();
+	}
+
+	for (int i = 0; i < Wads.GetNumLumps(); ++i)
+	{
+		unsigned j;
+
+		for (j = 0; j < names.Size() && !Wads.CheckLumpName(i, names[j]); ++j)
+		{
+		}
+		if (j == names.Size() || Wads.LumpLength(i) == 0)
+		{
+			continue;
+		}
+
+		FMemLump data = Wads.ReadLump(i);
+		lumps++;
+		bytes += Wads.LumpLength(i);
+		for (int mode = 0; mode < 4; ++mode)
+		{
+			FScanner sc;
+			sc.OpenMem(Wads.GetLumpFullName(i), (const char *)data.GetMem(), Wads.LumpLength(i));
+			sc.SetViewMode(!!(mode & 1));
+			int count = BenchScan(sc, mode >= 2, times[mode]);
+			if (count < 0)
+			{
+				failed[mode]++;
+			}
+			else
+			{
+				counts[mode] += count;
+			}
+		}
+	}
+
+	if (lumps == 0)
+	{
+		Printf("No lumps to parse.\n");
+		return;
+	}
+	Printf("%d lumps, %.1f KB\n", lumps, bytes / 1024);
+	for (int mode = 0; mode < 4; ++mode)
+	{
+		double ms = times[mode].TimeMS();
+		Printf("%-12s %9d tokens %9.2f ms %8.1f MB/s", modenames[mode], counts[mode], ms,
+			ms > 0 ? bytes / 1048576 / (ms / 1000) : 0.);
+		if (failed[mode] > 0)
+		{
+			Printf(" (%d lumps stopped at a script error)", failed[mode]);
+		}
+		Printf("\n");
+	}
+}
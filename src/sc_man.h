@@ -26,6 +26,7 @@ public:
 
 	void SetCMode(bool cmode);
 	void SetEscape(bool esc);
+	void SetViewMode(bool views);
 	const SavedPos SavePos();
 	void RestorePos(const SavedPos &pos);
 
@@ -83,6 +84,7 @@ protected:
 	void PrepareScript();
 	void CheckOpen();
 	bool ScanString(bool tokens);
+	bool SkipBlanks(const char *&cursor, bool tokens);
 
 	// Strings longer than this minus one will be dynamically allocated.
 	static const int MAX_STRING_SIZE = 128;
@@ -100,6 +102,9 @@ protected:
 	int LastGotLine;
 	bool CMode;
 	bool Escape;
+	bool ViewMode;
+	char *ViewEnd;
+	char ViewChar;
 };
 
 enum
@@ -68,6 +68,7 @@ extern void ChildSigHandler (int signum);
 #include "s_sound.h"
 #include "m_swap.h"
 #include "i_cd.h"
+#include "cmdlib.h"
 #include "tempfiles.h"
 #include "templates.h"
 #include "stats.h"
@@ -155,7 +156,7 @@ void I_InitMusic (void)
 
 	snd_musicvolume.Callback ();
 
-	nomusic = !!Args->CheckParm("-nomusic") || !!Args->CheckParm("-nosound") || !!Args->CheckParm("-host");
+	nomusic = !!Args->CheckParm("-nomusic") || !!Args->CheckParm("-nosound") || !!Args->CheckParm("-host") || !!Args->CheckParm("-benchrender");
 
 #ifdef _WIN32
 	I_InitMusicWin32 ();
@@ -373,6 +374,20 @@ static EMIDIType IdentifyMIDIType(DWORD *id, int size)
 	}
 }
 
+//==========================================================================
+//
+// identify raw OPL formats
+//
+//==========================================================================
+
+static bool IsRawOPL(const DWORD *id)
+{
+	return
+		(id[0] == MAKE_ID('R','A','W','A') && id[1] == MAKE_ID('D','A','T','A')) ||		// Rdos Raw OPL
+		(id[0] == MAKE_ID('D','B','R','A') && id[1] == MAKE_ID('W','O','P','L')) ||		// DosBox Raw OPL
+		(id[0] == MAKE_ID('A','D','L','I') && *((BYTE *)id + 4) == 'B');		// Martin Fernandez's modified IMF
+}
+
 //==========================================================================
 //
 // identify a music lump's type and set up a player for it
@@ -501,10 +516,7 @@ retry_as_fmod:
 	}
 
 	// Check for various raw OPL formats
-	else if (
-		(id[0] == MAKE_ID('R','A','W','A') && id[1] == MAKE_ID('D','A','T','A')) ||		// Rdos Raw OPL
-		(id[0] == MAKE_ID('D','B','R','A') && id[1] == MAKE_ID('W','O','P','L')) ||		// DosBox Raw OPL
-		(id[0] == MAKE_ID('A','D','L','I') && *((BYTE *)id + 4) == 'B'))		// Martin Fernandez's modified IMF
+	else if (IsRawOPL(id))
 	{
 		info = new OPLMUSSong (file, musiccache, len);
 	}
@@ -877,3 +889,341 @@ UNSAFE_CCMD (writemidi)
 		Printf("Could not write to music file.\n");
 	}
 }
+
+//==========================================================================
+//
+// Music benchmark
+//
+// Renders a song through every software backend that can play it, as
+// fast as possible and without an audio device, and reports how much CPU
+// time each backend needs per second of audio. The output of each
+// backend can be saved as a wave file as well.
+//
+//==========================================================================
+
+CVAR (Int, benchmusic_samplerate, 44100, 0)
+
+// Songs that never end by themselves are cut off after this many seconds.
+CVAR (Int, benchmusic_maxseconds, 300, 0)
+
+struct FMusicBenchResult
+{
+	const char *Backend;
+	double Seconds;
+	double MS;
+	bool Failed;
+};
+
+//==========================================================================
+//
+// BenchWriteWaveHeader
+//
+// Writes a plain PCM or float wave header. The chunk sizes are filled in
+// by BenchFinishWave.
+//
+//==========================================================================
+
+static bool BenchWriteWaveHeader (FILE *file, const OfflineSoundStream *stream)
+{
+	int flags = stream->GetFlags();
+	int channels = (flags & SoundStream::Mono) ? 1 : 2;
+	int framesize = stream->GetFrameSize();
+	DWORD header[11];
+
+	header[0] = MAKE_ID('R','I','F','F');
+	header[1] = 0;
+	header[2] = MAKE_ID('W','A','V','E');
+	header[3] = MAKE_ID('f','m','t',' ');
+	header[4] = LittleLong(16);
+	header[5] = LittleLong(((flags & SoundStream::Float) ? 3 : 1) | (channels << 16));
+	header[6] = LittleLong(stream->GetSampleRate());
+	header[7] = LittleLong(stream->GetSampleRate() * framesize);
+	header[8] = LittleLong(framesize | ((framesize / channels * 8) << 16));
+	header[9] = MAKE_ID('d','a','t','a');
+	header[10] = 0;
+	return fwrite(header, 4, 11, file) == 11;
+}
+
+static void BenchFinishWave (FILE *file)
+{
+	long pos = ftell(file);
+	DWORD size;
+
+	size = LittleLong(DWORD(pos - 8));
+	fseek(file, 4, SEEK_SET);
+	fwrite(&size, 4, 1, file);
+	size = LittleLong(DWORD(pos - 44));
+	fseek(file, 40, SEEK_SET);
+	fwrite(&size, 4, 1, file);
+	fclose(file);
+}
+
+//==========================================================================
+//
+// BenchSongBackend
+//
+// Names the backend that I_RegisterSong picks for anything but MIDI.
+//
+//==========================================================================
+
+static const char *BenchSongBackend (BYTE *data, int len)
+{
+	BYTE *ungzipped = NULL;
+	DWORD id[32/4];
+	const char *fmt;
+	const char *backend;
+
+	memcpy(id, data, sizeof(id));
+	if ((id[0] & MAKE_ID(255,255,255,0)) == GZIP_ID)
+	{
+		ungzipped = ungzip(data, &len);
+		if (ungzipped != NULL && len >= 32)
+		{
+			memcpy(id, ungzipped, sizeof(id));
+		}
+	}
+
+	if (IsRawOPL(id))
+	{
+		backend = "OPL";
+	}
+	else if ((fmt = GME_CheckFormat(id[0])) != NULL && fmt[0] != '\0')
+	{
+		backend = "GME";
+	}
+	else
+	{
+		backend = "DUMB";
+	}
+	delete[] ungzipped;
+	return backend;
+}
+
+//==========================================================================
+//
+// BenchRenderSong
+//
+// Plays the song into an offline stream until it ends, then deletes it.
+//
+//==========================================================================
+
+static void BenchRenderSong (MusInfo *song, const char *wavename, FMusicBenchResult &result)
+{
+	result.Seconds = result.MS = 0;
+	result.Failed = true;
+
+	if (song == NULL)
+	{
+		return;
+	}
+
+	song->Play(false, 0);
+
+	OfflineSoundStream *stream = OfflineSoundStream::Latest;
+	if (stream == NULL || !stream->IsPlaying())
+	{
+		song->Stop();
+		delete song;
+		return;
+	}
+
+	FILE *wave = NULL;
+	if (wavename != NULL)
+	{
+		wave = fopen(wavename, "wb");
+		if (wave == NULL || !BenchWriteWaveHeader(wave, stream))
+		{
+			Printf("Could not write %s\n", wavename);
+			if (wave != NULL) fclose(wave);
+			wave = NULL;
+		}
+	}
+
+	int framesize = stream->GetFrameSize();
+	int len = MAX(stream->GetBufferBytes() / framesize, 256) * framesize;
+	double maxframes = double(MAX<int>(benchmusic_maxseconds, 1)) * stream->GetSampleRate();
+	double frames = 0;
+	TArray<BYTE> buffer;
+	cycle_t rendertime;
+
+	buffer.Resize(len);
+	rendertime.Reset();
+	while (frames < maxframes)
+	{
+		rendertime.Clock();
+		bool more = stream->Render(&buffer[0], len);
+		rendertime.Unclock();
+		if (!more)
+		{
+			break;
+		}
+		frames += len / framesize;
+		if (wave != NULL && fwrite(&buffer[0], 1, len, wave) != (size_t)len)
+		{
+			Printf("Could not write %s\n", wavename);
+			fclose(wave);
+			wave = NULL;
+		}
+	}
+	if (wave != NULL)
+	{
+		BenchFinishWave(wave);
+	}
+
+	result.Seconds = frames / stream->GetSampleRate();
+	result.MS = rendertime.TimeMS();
+	result.Failed = false;
+
+	song->Stop();
+	delete song;
+}
+
+//==========================================================================
+//
+// I_BenchMusic
+//
+// Musicname is either a music lump or a file. If waveprefix is not NULL,
+// each backend's output is written to <waveprefix>-<backend>.wav.
+//
+//==========================================================================
+
+void I_BenchMusic (const char *musicname, const char *waveprefix)
+{
+	static const struct { EMidiDevice Device; const char *Name; } MIDIBackends[] =
+	{
+		{ MDEV_OPL,			"OPL" },
+		{ MDEV_GUS,			"TiMidity" },
+#ifdef HAVE_FLUIDSYNTH
+		{ MDEV_FLUIDSYNTH,	"FluidSynth" },
+#endif
+	};
+
+	TArray<BYTE> data;
+	int lumpnum;
+
+	if (FileExists(musicname))
+	{
+		FILE *file = fopen(musicname, "rb");
+		if (file != NULL)
+		{
+			fseek(file, 0, SEEK_END);
+			data.Resize(ftell(file));
+			fseek(file, 0, SEEK_SET);
+			if (data.Size() > 0 && fread(&data[0], 1, data.Size(), file) != data.Size())
+			{
+				data.Clear();
+			}
+			fclose(file);
+		}
+	}
+	else if ((lumpnum = Wads.CheckNumForFullName(musicname, true, ns_music)) >= 0)
+	{
+		data.Resize(Wads.LumpLength(lumpnum));
+		if (data.Size() > 0)
+		{
+			Wads.ReadLump(lumpnum, &data[0]);
+		}
+	}
+	else
+	{
+		Printf("Music \"%s\" not found\n", musicname);
+		return;
+	}
+	if (data.Size() < 32)
+	{
+		Printf("Could not read \"%s\"\n", musicname);
+		return;
+	}
+
+	// The playing song's backends may share state with the ones that are
+	// being benchmarked, so it's stopped for the duration.
+	S_StopMusic(true);
+
+	SoundRenderer *savedsnd = GSnd;
+	int savednomusic = nomusic;
+	GSnd = I_CreateOfflineSoundRenderer((float)clamp<int>(benchmusic_samplerate, 8000, 192000));
+	nomusic = false;
+
+	TArray<FMusicBenchResult> results;
+	MusInfo *song = I_RegisterSong(NULL, &data[0], -1, data.Size(), MDEV_GUS);
+
+	if (song != NULL && song->IsMIDI())
+	{
+		delete song;
+		for (size_t i = 0; i < countof(MIDIBackends); ++i)
+		{
+			FMusicBenchResult result;
+			FString wavename;
+
+			result.Backend = MIDIBackends[i].Name;
+			if (waveprefix != NULL)
+			{
+				wavename.Format("%s-%s.wav", waveprefix, result.Backend);
+			}
+			song = I_RegisterSong(NULL, &data[0], -1, data.Size(), MIDIBackends[i].Device);
+			BenchRenderSong(song, waveprefix != NULL ? wavename.GetChars() : NULL, result);
+			results.Push(result);
+		}
+	}
+	else if (song != NULL)
+	{
+		// Everything else only has a single software backend.
+		FMusicBenchResult result;
+		FString wavename;
+
+		result.Backend = BenchSongBackend(&data[0], data.Size());
+		if (waveprefix != NULL)
+		{
+			wavename.Format("%s-%s.wav", waveprefix, result.Backend);
+		}
+		BenchRenderSong(song, waveprefix != NULL ? wavename.GetChars() : NULL, result);
+		results.Push(result);
+	}
+
+	delete GSnd;
+	GSnd = savedsnd;
+	nomusic = savednomusic;
+	S_RestartMusic();
+
+	if (results.Size() == 0)
+	{
+		Printf("\"%s\" can't be played by any of the software backends\n", musicname);
+		return;
+	}
+
+	Printf("%-12s %10s %10s %12s %10s\n", "backend", "audio (s)", "cpu (ms)", "ms/s audio", "realtime");
+	for (unsigned i = 0; i < results.Size(); ++i)
+	{
+		const FMusicBenchResult &r = results[i];
+
+		if (r.Failed)
+		{
+			Printf("%-12s failed to start\n", r.Backend);
+		}
+		else if (r.Seconds <= 0)
+		{
+			Printf("%-12s produced no audio\n", r.Backend);
+		}
+		else
+		{
+			Printf("%-12s %10.1f %10.0f %12.2f %9.1fx\n", r.Backend, r.Seconds, r.MS,
+				r.MS / r.Seconds, r.MS > 0 ? r.Seconds * 1000 / r.MS : 0.);
+		}
+	}
+}
+
+//==========================================================================
+//
+// CCMD benchmusic
+//
+//==========================================================================
+
+UNSAFE_CCMD (benchmusic)
+{
+	if (argv.argc() < 2 || argv.argc() > 3)
+	{
+		Printf("Usage: benchmusic <music> [wave file prefix]\n");
+		return;
+	}
+	I_BenchMusic(argv[1], argv.argc() == 3 ? argv[2] : NULL);
+}
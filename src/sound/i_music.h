@@ -56,6 +56,9 @@ MusInfo *I_RegisterSong (const char *file, BYTE *musiccache, int offset, int len
 MusInfo *I_RegisterCDSong (int track, int cdid = 0);
 MusInfo *I_RegisterURLSong (const char *url);
 
+// Renders a song through every software backend and reports their speed.
+void I_BenchMusic (const char *musicname, const char *waveprefix);
+
 // The base music class. Everything is derived from this --------------------
 
 class MusInfo
@@ -246,6 +246,44 @@ public:
 	}
 };
 
+//==========================================================================
+//
+// OfflineSoundRenderer
+//
+// Plays no sound effects, like the null renderer, but hands out streams
+// that can be rendered without an audio device.
+//
+//==========================================================================
+
+class OfflineSoundRenderer : public NullSoundRenderer
+{
+public:
+	OfflineSoundRenderer (float outputrate)
+		: OutputRate(outputrate)
+	{
+	}
+	float GetOutputRate()
+	{
+		return OutputRate;
+	}
+	SoundStream *CreateStream (SoundStreamCallback callback, int buffbytes, int flags, int samplerate, void *userdata)
+	{
+		return new OfflineSoundStream (callback, buffbytes, flags, samplerate, userdata);
+	}
+	void PrintStatus ()
+	{
+		Printf("Offline sound module active.\n");
+	}
+
+private:
+	float OutputRate;
+};
+
+SoundRenderer *I_CreateOfflineSoundRenderer (float outputrate)
+{
+	return new OfflineSoundRenderer (outputrate);
+}
+
 void I_InitSound ()
 {
 #ifdef NO_SOUND
@@ -256,6 +294,10 @@ void I_InitSound ()
 	nosound = !!Args->CheckParm ("-nosound") || !!Args->CheckParm("-host"); // [BB] No sound for the server
 	nosfx = !!Args->CheckParm ("-nosfx") || !!Args->CheckParm("-host"); // [BB]
 
+	// The render and music benchmarks run without any audio output.
+	if (Args->CheckParm ("-benchrender") || Args->CheckParm ("-benchmusic"))
+		nosound = true;
+
 	if (nosound)
 	{
 		GSnd = new NullSoundRenderer;
@@ -364,6 +406,78 @@ FString SoundStream::GetStats()
 	return "No stream stats available.";
 }
 
+//==========================================================================
+//
+// OfflineSoundStream
+//
+//==========================================================================
+
+OfflineSoundStream *OfflineSoundStream::Latest;
+
+OfflineSoundStream::OfflineSoundStream (SoundStreamCallback callback, int buffbytes, int flags, int samplerate, void *userdata)
+	: Callback(callback), UserData(userdata), Flags(flags), SampleRate(samplerate),
+	  BufferBytes(buffbytes), Playing(false), Ended(false)
+{
+	Latest = this;
+}
+
+OfflineSoundStream::~OfflineSoundStream ()
+{
+	if (Latest == this)
+	{
+		Latest = NULL;
+	}
+}
+
+bool OfflineSoundStream::Play (bool looping, float volume)
+{
+	Playing = true;
+	return true;
+}
+
+void OfflineSoundStream::Stop ()
+{
+	Playing = false;
+}
+
+void OfflineSoundStream::SetVolume (float volume)
+{
+}
+
+bool OfflineSoundStream::SetPaused (bool paused)
+{
+	return true;
+}
+
+unsigned int OfflineSoundStream::GetPosition ()
+{
+	return 0;
+}
+
+bool OfflineSoundStream::IsEnded ()
+{
+	return Ended;
+}
+
+bool OfflineSoundStream::Render (void *buff, int len)
+{
+	if (!Playing || Ended)
+	{
+		return false;
+	}
+	if (!Callback (this, buff, len, UserData))
+	{
+		Ended = true;
+	}
+	return !Ended;
+}
+
+int OfflineSoundStream::GetFrameSize () const
+{
+	int size = (Flags & (Float | Bits32)) ? 4 : (Flags & Bits8) ? 1 : 2;
+	return (Flags & Mono) ? size : size * 2;
+}
+
 //==========================================================================
 //
 // SoundRenderer :: LoadSoundVoc
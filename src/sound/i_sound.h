@@ -82,6 +82,40 @@ public:
 
 typedef bool (*SoundStreamCallback)(SoundStream *stream, void *buff, int len, void *userdata);
 
+// A stream that is never played by an audio device. Whoever owns it pulls
+// the data out with Render instead, as fast as the callback can make it.
+class OfflineSoundStream : public SoundStream
+{
+public:
+	OfflineSoundStream (SoundStreamCallback callback, int buffbytes, int flags, int samplerate, void *userdata);
+	~OfflineSoundStream ();
+
+	bool Play (bool looping, float volume);
+	void Stop ();
+	void SetVolume (float volume);
+	bool SetPaused (bool paused);
+	unsigned int GetPosition ();
+	bool IsEnded ();
+
+	// Returns false once the callback has run out of data.
+	bool Render (void *buff, int len);
+
+	int GetFlags () const { return Flags; }
+	int GetSampleRate () const { return SampleRate; }
+	int GetBufferBytes () const { return BufferBytes; }
+	int GetFrameSize () const;
+	bool IsPlaying () const { return Playing; }
+
+	// The most recently created stream that still exists.
+	static OfflineSoundStream *Latest;
+
+private:
+	SoundStreamCallback Callback;
+	void *UserData;
+	int Flags, SampleRate, BufferBytes;
+	bool Playing, Ended;
+};
+
 class SoundRenderer
 {
 public:
@@ -159,6 +193,10 @@ extern bool nosound;
 void I_InitSound ();
 void I_ShutdownSound ();
 
+// Creates a sound renderer without an audio device, whose streams are all
+// OfflineSoundStreams.
+SoundRenderer *I_CreateOfflineSoundRenderer (float outputrate);
+
 void S_ChannelEnded(FISoundChannel *schan);
 void S_ChannelVirtualChanged(FISoundChannel *schan, bool is_virtual);
 float S_GetRolloff(FRolloffInfo *rolloff, float distance, bool logarithmic);
@@ -40,6 +40,7 @@
 #include "m_swap.h"
 #include "w_wad.h"
 #include "v_text.h"
+#include "stats.h"
 #include "timidity/timidity.h"
 #include <errno.h>
 
@@ -337,15 +338,32 @@ TimidityWaveWriterMIDIDevice::~TimidityWaveWriterMIDIDevice()
 int TimidityWaveWriterMIDIDevice::Resume()
 {
 	float writebuffer[4096];
+	cycle_t rendertime;
+	double frames = 0;
 
-	while (ServiceStream(writebuffer, sizeof(writebuffer)))
+	rendertime.Reset();
+	for (;;)
 	{
+		rendertime.Clock();
+		bool more = ServiceStream(writebuffer, sizeof(writebuffer));
+		rendertime.Unclock();
+		if (!more)
+		{
+			break;
+		}
+		frames += countof(writebuffer) / 2;
 		if (fwrite(writebuffer, sizeof(writebuffer), 1, File) != 1)
 		{
 			Printf("Could not write entire wave file: %s\n", strerror(errno));
 			return 1;
 		}
 	}
+
+	// Rendering speed, not counting the time spent writing the file.
+	double seconds = frames / Renderer->rate;
+	double ms = rendertime.TimeMS();
+	Printf("Rendered %.1f seconds of audio in %.0f ms (%.1fx realtime)\n",
+		seconds, ms, ms > 0 ? seconds * 1000 / ms : 0.);
 	return 0;
 }
 
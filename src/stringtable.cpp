@@ -152,6 +152,7 @@ void FStringTable::LoadLanguage (int lumpnum, DWORD code, bool exactMatch, int p
 
 	FScanner sc(lumpnum);
 	sc.SetCMode (true);
+	sc.SetViewMode (true);
 	while (sc.GetString ())
 	{
 		if (sc.Compare ("["))
@@ -173,6 +173,16 @@ void JPEG_OutputMessage (j_common_ptr cinfo)
 	Printf (TEXTCOLOR_ORANGE "JPEG failure: %s\n", buffer);
 }
 
+//==========================================================================
+//
+// Used when decoding on a worker thread, where Printf can't be called.
+//
+//==========================================================================
+
+static void JPEG_NoOutputMessage (j_common_ptr cinfo)
+{
+}
+
 //==========================================================================
 //
 // A JPEG texture
@@ -192,6 +202,10 @@ public:
 	int CopyTrueColorPixels(FBitmap *bmp, int x, int y, int rotate, FCopyInfo *inf = NULL);
 	bool UseBasePalette();
 
+	bool CanDecodeAsync ();
+	BYTE *DecodePixels (FileReader &lump, bool quiet);
+	void SetDecodedPixels (BYTE *pixels, Span **spans);
+
 protected:
 
 	BYTE *Pixels;
@@ -366,17 +380,44 @@ const BYTE *FJPEGTexture::GetPixels ()
 
 void FJPEGTexture::MakeTexture ()
 {
-	FWadLump lump = Wads.OpenLumpNum (SourceLump);
+	Pixels = TexMan.QueueAsyncDecode (this);
+	if (Pixels == NULL)
+	{
+		FWadLump lump = Wads.OpenLumpNum (SourceLump);
+		Pixels = DecodePixels (lump, false);
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool FJPEGTexture::CanDecodeAsync ()
+{
+	return Pixels == NULL;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+BYTE *FJPEGTexture::DecodePixels (FileReader &lump, bool quiet)
+{
 	JSAMPLE *buff = NULL;
+	BYTE *pixels;
 
 	jpeg_decompress_struct cinfo;
 	jpeg_error_mgr jerr;
 
-	Pixels = new BYTE[Width * Height];
-	memset (Pixels, 0xBA, Width * Height);
+	pixels = new BYTE[Width * Height];
+	memset (pixels, 0xBA, Width * Height);
 
 	cinfo.err = jpeg_std_error(&jerr);
-	cinfo.err->output_message = JPEG_OutputMessage;
+	cinfo.err->output_message = quiet ? JPEG_NoOutputMessage : JPEG_OutputMessage;
 	cinfo.err->error_exit = JPEG_ErrorExit;
 	jpeg_create_decompress(&cinfo);
 	try
@@ -387,7 +428,7 @@ void FJPEGTexture::MakeTexture ()
 			  (cinfo.out_color_space == JCS_CMYK && cinfo.num_components == 4) ||
 			  (cinfo.out_color_space == JCS_GRAYSCALE && cinfo.num_components == 1)))
 		{
-			Printf (TEXTCOLOR_ORANGE "Unsupported color format\n");
+			if (!quiet) Printf (TEXTCOLOR_ORANGE "Unsupported color format\n");
 			throw -1;
 		}
 
@@ -400,7 +441,7 @@ void FJPEGTexture::MakeTexture ()
 		{
 			int num_scanlines = jpeg_read_scanlines(&cinfo, &buff, 1);
 			BYTE *in = buff;
-			BYTE *out = Pixels + y;
+			BYTE *out = pixels + y;
 			switch (cinfo.out_color_space)
 			{
 			case JCS_RGB:
@@ -448,13 +489,39 @@ void FJPEGTexture::MakeTexture ()
 	}
 	catch (int)
 	{
-		Printf (TEXTCOLOR_ORANGE "   in texture %s\n", Name);
 		jpeg_destroy_decompress(&cinfo);
+		if (quiet)
+		{
+			delete[] pixels;
+			pixels = NULL;
+		}
+		else
+		{
+			Printf (TEXTCOLOR_ORANGE "   in texture %s\n", Name);
+		}
 	}
 	if (buff != NULL)
 	{
 		delete[] buff;
 	}
+	return pixels;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FJPEGTexture::SetDecodedPixels (BYTE *pixels, Span **spans)
+{
+	// JPEGs have no holes, so they always use DummySpans.
+	if (spans != NULL)
+	{
+		FreeSpans (spans);
+	}
+	Unload ();
+	Pixels = pixels;
 }
 
 
@@ -491,6 +491,9 @@ void FMultiPatchTexture::MakeTexture ()
 	BYTE blendwork[256];
 	bool hasTranslucent = false;
 
+	// The patches' pixels are baked into ours, so they must not be placeholders.
+	FAsyncDecodeScope noasync (false);
+
 	Pixels = new BYTE[numpix];
 	memset (Pixels, 0, numpix);
 
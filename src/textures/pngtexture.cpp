@@ -61,6 +61,10 @@ public:
 	int CopyTrueColorPixels(FBitmap *bmp, int x, int y, int rotate, FCopyInfo *inf = NULL);
 	bool UseBasePalette();
 
+	bool CanDecodeAsync ();
+	BYTE *DecodePixels (FileReader &lump, bool quiet);
+	void SetDecodedPixels (BYTE *pixels, Span **spans);
+
 protected:
 
 	FString SourceFile;
@@ -447,6 +451,12 @@ void FPNGTexture::MakeTexture ()
 {
 	FileReader *lump;
 
+	Pixels = TexMan.QueueAsyncDecode (this);
+	if (Pixels != NULL)
+	{
+		return;
+	}
+
 	if (SourceLump >= 0)
 	{
 		lump = new FWadLump(Wads.OpenLumpNum(SourceLump));
@@ -456,31 +466,54 @@ void FPNGTexture::MakeTexture ()
 		lump = new FileReader(SourceFile.GetChars());
 	}
 
-	Pixels = new BYTE[Width*Height];
+	Pixels = DecodePixels (*lump, false);
+	delete lump;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool FPNGTexture::CanDecodeAsync ()
+{
+	return Pixels == NULL && SourceLump >= 0;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+BYTE *FPNGTexture::DecodePixels (FileReader &lump, bool quiet)
+{
+	BYTE *pixels = new BYTE[Width*Height];
 	if (StartOfIDAT == 0)
 	{
-		memset (Pixels, 0x99, Width*Height);
+		memset (pixels, 0x99, Width*Height);
 	}
 	else
 	{
 		DWORD len, id;
-		lump->Seek (StartOfIDAT, SEEK_SET);
-		lump->Read(&len, 4);
-		lump->Read(&id, 4);
+		lump.Seek (StartOfIDAT, SEEK_SET);
+		lump.Read(&len, 4);
+		lump.Read(&id, 4);
 
 		if (ColorType == 0 || ColorType == 3)	/* Grayscale and paletted */
 		{
-			M_ReadIDAT (lump, Pixels, Width, Height, Width, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
+			M_ReadIDAT (&lump, pixels, Width, Height, Width, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
 
 			if (Width == Height)
 			{
 				if (PaletteMap != NULL)
 				{
-					FlipSquareBlockRemap (Pixels, Width, Height, PaletteMap);
+					FlipSquareBlockRemap (pixels, Width, Height, PaletteMap);
 				}
 				else
 				{
-					FlipSquareBlock (Pixels, Width, Height);
+					FlipSquareBlock (pixels, Width, Height);
 				}
 			}
 			else
@@ -488,14 +521,14 @@ void FPNGTexture::MakeTexture ()
 				BYTE *newpix = new BYTE[Width*Height];
 				if (PaletteMap != NULL)
 				{
-					FlipNonSquareBlockRemap (newpix, Pixels, Width, Height, Width, PaletteMap);
+					FlipNonSquareBlockRemap (newpix, pixels, Width, Height, Width, PaletteMap);
 				}
 				else
 				{
-					FlipNonSquareBlock (newpix, Pixels, Width, Height, Width);
+					FlipNonSquareBlock (newpix, pixels, Width, Height, Width);
 				}
-				BYTE *oldpix = Pixels;
-				Pixels = newpix;
+				BYTE *oldpix = pixels;
+				pixels = newpix;
 				delete[] oldpix;
 			}
 		}
@@ -506,9 +539,9 @@ void FPNGTexture::MakeTexture ()
 			BYTE *in, *out;
 			int x, y, pitch, backstep;
 
-			M_ReadIDAT (lump, tempix, Width, Height, Width*bytesPerPixel, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
+			M_ReadIDAT (&lump, tempix, Width, Height, Width*bytesPerPixel, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
 			in = tempix;
-			out = Pixels;
+			out = pixels;
 
 			// Convert from source format to paletted, column-major.
 			// Formats with alpha maps are reduced to only 1 bit of alpha.
@@ -574,7 +607,24 @@ void FPNGTexture::MakeTexture ()
 			delete[] tempix;
 		}
 	}
-	delete lump;
+	return pixels;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FPNGTexture::SetDecodedPixels (BYTE *pixels, Span **spans)
+{
+	Unload ();
+	if (Spans != NULL)
+	{
+		FreeSpans (Spans);
+	}
+	Pixels = pixels;
+	Spans = spans;
 }
 
 //===========================================================================
@@ -215,6 +215,25 @@ void FTexture::HackHack (int newheight)
 {
 }
 
+bool FTexture::CanDecodeAsync ()
+{
+	return false;
+}
+
+BYTE *FTexture::DecodePixels (FileReader &lump, bool quiet)
+{
+	return NULL;
+}
+
+void FTexture::SetDecodedPixels (BYTE *pixels, Span **spans)
+{
+	delete[] pixels;
+	if (spans != NULL)
+	{
+		FreeSpans (spans);
+	}
+}
+
 FTexture::Span **FTexture::CreateSpans (const BYTE *pixels) const
 {
 	Span **spans, *span;
@@ -0,0 +1,243 @@
+/*
+** texturedecoder.cpp
+** Decodes PNG, JPEG and TGA textures on the worker threads
+**
+** Image textures are decoded in two situations: in bulk while a level is
+** being precached, and one at a time when the renderer first touches a
+** texture that was not precached. The first case is handled by
+** PrecacheDecode, which hands batches of textures to the worker pool.
+** The second case is only taken when r_asynctextures is set: the texture
+** gets an empty placeholder for the current frame and the real pixels are
+** swapped in by UpdateAsyncDecodes before the next one is drawn.
+**
+** Lump reading, console output and M_Malloc are not thread-safe, so the
+** source data is always read on the main thread, the spans of masked
+** textures are built there once the pixels are in, and the decoders are
+** run in quiet mode. A texture that fails to decode in the background is decoded again
+** on the main thread so that the usual error messages are printed.
+*/
+
+#include "doomtype.h"
+#include "doomstat.h"
+#include "w_wad.h"
+#include "templates.h"
+#include "files.h"
+#include "c_cvars.h"
+#include "workerpool.h"
+#include "textures/textures.h"
+
+CVAR (Bool, r_asynctextures, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+// Number of textures whose source data is held in memory at once while precaching.
+enum { PRECACHE_BATCH = 64 };
+
+struct FDecodeJob
+{
+	FTexture *Tex;
+	TArray<BYTE> Source;
+	BYTE *Pixels;
+
+	void Read ()
+	{
+		int lump = Tex->GetSourceLump();
+		Source.Resize (Wads.LumpLength (lump));
+		if (Source.Size() > 0)
+		{
+			Wads.ReadLump (lump, &Source[0]);
+		}
+	}
+
+	void Decode ()
+	{
+		Pixels = NULL;
+		if (Source.Size() > 0)
+		{
+			MemoryReader reader ((const char *)&Source[0], Source.Size());
+			Pixels = Tex->DecodePixels (reader, true);
+		}
+	}
+
+	// Returns false if the texture could not be decoded.
+	bool Install ()
+	{
+		FTexture::Span **spans = NULL;
+		if (Pixels != NULL && Tex->bMasked)
+		{
+			spans = Tex->CreateSpans (Pixels);
+		}
+		Tex->SetDecodedPixels (Pixels, spans);
+		Source.Clear ();
+		return Pixels != NULL;
+	}
+};
+
+struct FAsyncDecode
+{
+	FDecodeJob Job;
+	FWorkerGroup Group;
+};
+
+static TArray<FAsyncDecode *> AsyncDecodes;
+static bool AsyncDecodeAllowed;
+
+//==========================================================================
+//
+// FAsyncDecodeScope
+//
+// Textures are only decoded in the background while one of these with
+// allow set is in scope. Anything that copies a texture's pixels somewhere
+// else (like multipatch composition) disables it again so that it never
+// sees a placeholder.
+//
+//==========================================================================
+
+FAsyncDecodeScope::FAsyncDecodeScope (bool allow)
+{
+	SavedAllowed = AsyncDecodeAllowed;
+	AsyncDecodeAllowed = allow;
+}
+
+FAsyncDecodeScope::~FAsyncDecodeScope ()
+{
+	AsyncDecodeAllowed = SavedAllowed;
+}
+
+bool FAsyncDecodeScope::IsAllowed ()
+{
+	return AsyncDecodeAllowed;
+}
+
+//==========================================================================
+//
+// FTextureManager :: QueueAsyncDecode
+//
+// Called from a texture's MakeTexture. Returns a blank placeholder buffer
+// if the texture is being decoded in the background, or NULL if the
+// caller has to decode it right now.
+//
+//==========================================================================
+
+BYTE *FTextureManager::QueueAsyncDecode (FTexture *tex)
+{
+	if (!AsyncDecodeAllowed || !r_asynctextures || gamestate != GS_LEVEL ||
+		WorkerPool.GetNumThreads() <= 1 || FWorkerPool::IsWorkerThread())
+	{
+		return NULL;
+	}
+
+	bool pending = false;
+	for (unsigned i = 0; i < AsyncDecodes.Size(); ++i)
+	{
+		if (AsyncDecodes[i]->Job.Tex == tex)
+		{
+			pending = true;
+			break;
+		}
+	}
+	if (!pending)
+	{
+		if (!tex->CanDecodeAsync())
+		{
+			return NULL;
+		}
+		FAsyncDecode *decode = new FAsyncDecode;
+		decode->Job.Tex = tex;
+		decode->Job.Pixels = NULL;
+		decode->Job.Read ();
+		decode->Group.Run ([decode]() { decode->Job.Decode (); });
+		AsyncDecodes.Push (decode);
+	}
+
+	BYTE *placeholder = new BYTE[tex->GetWidth() * tex->GetHeight()];
+	memset (placeholder, 0, tex->GetWidth() * tex->GetHeight());
+	return placeholder;
+}
+
+//==========================================================================
+//
+// FTextureManager :: UpdateAsyncDecodes
+//
+// Swaps the pixels of every finished background decode into its texture.
+// Must not be called while a frame is being drawn.
+//
+//==========================================================================
+
+void FTextureManager::UpdateAsyncDecodes ()
+{
+	for (unsigned i = 0; i < AsyncDecodes.Size(); )
+	{
+		FAsyncDecode *decode = AsyncDecodes[i];
+		if (!decode->Group.IsDone())
+		{
+			++i;
+			continue;
+		}
+		decode->Group.Wait ();
+		AsyncDecodes.Delete (i);
+		if (!decode->Job.Install ())
+		{
+			FAsyncDecodeScope noasync (false);
+			decode->Job.Tex->GetPixels ();
+		}
+		delete decode;
+	}
+}
+
+//==========================================================================
+//
+// FTextureManager :: WaitForAsyncDecodes
+//
+//==========================================================================
+
+void FTextureManager::WaitForAsyncDecodes ()
+{
+	for (unsigned i = 0; i < AsyncDecodes.Size(); ++i)
+	{
+		AsyncDecodes[i]->Group.Wait ();
+	}
+	UpdateAsyncDecodes ();
+}
+
+//==========================================================================
+//
+// FTextureManager :: PrecacheDecode
+//
+// Decodes all image textures in the hitlist on the worker threads, so
+// that the precache loop only has to deal with what is left.
+//
+//==========================================================================
+
+void FTextureManager::PrecacheDecode (const BYTE *hitlist)
+{
+	TArray<FTexture *> textures;
+
+	for (int i = NumTextures() - 1; i >= 0; i--)
+	{
+		FTexture *tex = ByIndex (i);
+		if (hitlist[i] != 0 && tex != NULL && tex->CanDecodeAsync())
+		{
+			textures.Push (tex);
+		}
+	}
+
+	TArray<FDecodeJob> jobs;
+	jobs.Resize (MIN<unsigned> (textures.Size(), PRECACHE_BATCH));
+
+	for (unsigned start = 0; start < textures.Size(); start += PRECACHE_BATCH)
+	{
+		unsigned count = MIN<unsigned> (textures.Size() - start, PRECACHE_BATCH);
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			jobs[i].Tex = textures[start + i];
+			jobs[i].Read ();
+		}
+		WorkerPool.ParallelFor (count, [&jobs](unsigned i) { jobs[i].Decode (); });
+
+		// Failures are left to the regular precache, which reports them.
+		for (unsigned i = 0; i < count; ++i)
+		{
+			jobs[i].Install ();
+		}
+	}
+}
@@ -53,6 +53,7 @@
 #include "r_renderer.h"
 #include "r_sky.h"
 #include "textures/textures.h"
+#include "workerpool.h"
 // [BB] New #includes.
 #include "cl_demo.h"
 
@@ -95,6 +96,7 @@ FTextureManager::~FTextureManager ()
 
 void FTextureManager::DeleteAll()
 {
+	WaitForAsyncDecodes ();
 	for (unsigned int i = 0; i < Textures.Size(); ++i)
 	{
 		delete Textures[i].Texture;
@@ -425,6 +427,10 @@ void FTextureManager::ReplaceTexture (FTextureID picnum, FTexture *newtexture, b
 
 	FTexture *oldtexture = Textures[index].Texture;
 
+	if (free)
+	{
+		WaitForAsyncDecodes ();
+	}
 	strcpy (newtexture->Name, oldtexture->Name);
 	newtexture->UseType = oldtexture->UseType;
 	Textures[index].Texture = newtexture;
@@ -1242,6 +1248,15 @@ void FTextureManager::PrecacheLevel (void)
 	memset (hitlist, 0, cnt);
 
 	screen->GetHitlist(hitlist);
+
+	// Decode image textures on the worker threads first. Multipatch
+	// textures are still composited below, but from decoded patches.
+	WaitForAsyncDecodes ();
+	if (WorkerPool.GetNumThreads() > 1)
+	{
+		PrecacheDecode (hitlist);
+	}
+
 	for (int i = cnt - 1; i >= 0; i--)
 	{
 		Renderer->PrecacheTexture(ByIndex(i), hitlist[i]);
@@ -302,6 +302,17 @@ public:
 
 	virtual void HackHack (int newheight);	// called by FMultipatchTexture to discover corrupt patches.
 
+	// Some textures can be decoded on a worker thread. DecodePixels builds
+	// the pixels from a copy of the source lump without changing the
+	// texture, so it must only use its arguments and read-only tables, and
+	// it must not allocate with M_Malloc or TArray. If quiet is set and
+	// decoding fails it returns NULL, so that the texture can be decoded
+	// again on the main thread where errors can be printed.
+	// SetDecodedPixels installs the result and is called on the main thread.
+	virtual bool CanDecodeAsync ();
+	virtual BYTE *DecodePixels (FileReader &lump, bool quiet);
+	virtual void SetDecodedPixels (BYTE *pixels, Span **spans);
+
 protected:
 	WORD Width, Height, WidthMask;
 	static BYTE GrayMap[256];
@@ -329,6 +340,8 @@ public:
 	static void FlipNonSquareBlockRemap (BYTE *blockto, const BYTE *blockfrom, int x, int y, int srcpitch, const BYTE *remap);
 
 	friend class D3DTex;
+	friend class FTextureManager;
+	friend struct FDecodeJob;
 
 public:
 
@@ -474,6 +487,14 @@ public:
 	int NumTextures () const { return (int)Textures.Size(); }
 	void PrecacheLevel (void);
 
+	// Decoding textures on worker threads (texturedecoder.cpp).
+	// QueueAsyncDecode returns the placeholder pixels that a texture should
+	// use until its decoded pixels are installed by UpdateAsyncDecodes, or
+	// NULL if the texture must be decoded right away.
+	BYTE *QueueAsyncDecode (FTexture *tex);
+	void UpdateAsyncDecodes ();
+	void WaitForAsyncDecodes ();
+
 	void WriteTexture (FArchive &arc, int picnum);
 	int ReadTexture (FArchive &arc);
 
@@ -515,6 +536,8 @@ private:
 
 	void InitPalettedVersions();
 
+	void PrecacheDecode (const BYTE *hitlist);
+
 	// Switches
 
 	void InitSwitchList ();
@@ -541,6 +564,21 @@ private:
 	TArray<BYTE *> BuildTileFiles;
 };
 
+// Textures that are first used inside this scope are decoded in the
+// background if r_asynctextures is on. Until then they show a placeholder.
+// Code that needs the real pixels right away must disallow it.
+class FAsyncDecodeScope
+{
+public:
+	FAsyncDecodeScope (bool allow);
+	~FAsyncDecodeScope ();
+
+	static bool IsAllowed ();
+
+private:
+	bool SavedAllowed;
+};
+
 // A texture that doesn't really exist
 class FDummyTexture : public FTexture
 {
@@ -90,6 +90,10 @@ public:
 	int CopyTrueColorPixels(FBitmap *bmp, int x, int y, int rotate, FCopyInfo *inf = NULL);
 	bool UseBasePalette();
 
+	bool CanDecodeAsync ();
+	BYTE *DecodePixels (FileReader &lump, bool quiet);
+	void SetDecodedPixels (BYTE *pixels, Span **spans);
+
 protected:
 	BYTE *Pixels;
 	Span **Spans;
@@ -288,15 +292,42 @@ void FTGATexture::ReadCompressed(FileReader &lump, BYTE * buffer, int bytesperpi
 //==========================================================================
 
 void FTGATexture::MakeTexture ()
+{
+	Pixels = TexMan.QueueAsyncDecode (this);
+	if (Pixels == NULL)
+	{
+		FWadLump lump = Wads.OpenLumpNum (SourceLump);
+		Pixels = DecodePixels (lump, false);
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool FTGATexture::CanDecodeAsync ()
+{
+	return Pixels == NULL;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+BYTE *FTGATexture::DecodePixels (FileReader &lump, bool quiet)
 {
 	BYTE PaletteMap[256];
-	FWadLump lump = Wads.OpenLumpNum (SourceLump);
 	TGAHeader hdr;
 	WORD w;
 	BYTE r,g,b,a;
 	BYTE * buffer;
+	BYTE *pixels;
 
-	Pixels = new BYTE[Width*Height];
+	pixels = new BYTE[Width*Height];
 	lump.Read(&hdr, sizeof(hdr));
 	lump.Seek(hdr.id_len, SEEK_CUR);
 	
@@ -376,7 +407,7 @@ void FTGATexture::MakeTexture ()
 			BYTE * p = ptr + y * Pitch;
 			for(int x=0;x<Width;x++)
 			{
-				Pixels[x*Height+y] = PaletteMap[*p];
+				pixels[x*Height+y] = PaletteMap[*p];
 				p+=step_x;
 			}
 		}
@@ -394,7 +425,7 @@ void FTGATexture::MakeTexture ()
 				for(int x=0;x<Width;x++)
 				{
 					int v = LittleLong(*p);
-					Pixels[x*Height+y] = RGB32k[(v>>10) & 0x1f][(v>>5) & 0x1f][v & 0x1f];
+					pixels[x*Height+y] = RGB32k[(v>>10) & 0x1f][(v>>5) & 0x1f][v & 0x1f];
 					p+=step_x;
 				}
 			}
@@ -406,7 +437,7 @@ void FTGATexture::MakeTexture ()
 				BYTE * p = ptr + y * Pitch;
 				for(int x=0;x<Width;x++)
 				{
-					Pixels[x*Height+y] = RGB32k[p[2]>>3][p[1]>>3][p[0]>>3];
+					pixels[x*Height+y] = RGB32k[p[2]>>3][p[1]>>3][p[0]>>3];
 					p+=step_x;
 				}
 			}
@@ -420,7 +451,7 @@ void FTGATexture::MakeTexture ()
 					BYTE * p = ptr + y * Pitch;
 					for(int x=0;x<Width;x++)
 					{
-						Pixels[x*Height+y] = RGB32k[p[2]>>3][p[1]>>3][p[0]>>3];
+						pixels[x*Height+y] = RGB32k[p[2]>>3][p[1]>>3][p[0]>>3];
 						p+=step_x;
 					}
 				}
@@ -432,7 +463,7 @@ void FTGATexture::MakeTexture ()
 					BYTE * p = ptr + y * Pitch;
 					for(int x=0;x<Width;x++)
 					{
-						Pixels[x*Height+y] = p[3] >= 128? RGB32k[p[2]>>3][p[1]>>3][p[0]>>3] : 0;
+						pixels[x*Height+y] = p[3] >= 128? RGB32k[p[2]>>3][p[1]>>3][p[0]>>3] : 0;
 						p+=step_x;
 					}
 				}
@@ -453,7 +484,7 @@ void FTGATexture::MakeTexture ()
 				BYTE * p = ptr + y * Pitch;
 				for(int x=0;x<Width;x++)
 				{
-					Pixels[x*Height+y] = GrayMap[*p];
+					pixels[x*Height+y] = GrayMap[*p];
 					p+=step_x;
 				}
 			}
@@ -465,7 +496,7 @@ void FTGATexture::MakeTexture ()
 				BYTE * p = ptr + y * Pitch;
 				for(int x=0;x<Width;x++)
 				{
-					Pixels[x*Height+y] = GrayMap[p[1]];	// only use the high byte
+					pixels[x*Height+y] = GrayMap[p[1]];	// only use the high byte
 					p+=step_x;
 				}
 			}
@@ -480,6 +511,24 @@ void FTGATexture::MakeTexture ()
 		break;
     }
 	delete [] buffer;
+	return pixels;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FTGATexture::SetDecodedPixels (BYTE *pixels, Span **spans)
+{
+	Unload ();
+	if (Spans != NULL)
+	{
+		FreeSpans (Spans);
+	}
+	Pixels = pixels;
+	Spans = spans;
 }	
 
 //===========================================================================
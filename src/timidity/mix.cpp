@@ -29,6 +29,10 @@
 #include "templates.h"
 #include "c_cvars.h"
 
+#ifdef TIMIDITY_SSE2
+#include <emmintrin.h>
+#endif
+
 EXTERN_CVAR(Bool, midi_timiditylike)
 
 namespace Timidity
@@ -458,13 +462,63 @@ static int update_signal(Voice *v)
 	return 0;
 }
 
+/* Adds count samples to both channels of an interleaved stereo buffer. */
+static void mix_stereo(const sample_t *sp, float *lp, final_volume_t left, final_volume_t right, int count)
+{
+#ifdef TIMIDITY_SSE2
+	const __m128 amp = _mm_setr_ps(left, right, left, right);
+
+	for (; count >= 4; count -= 4)
+	{
+		__m128 s = _mm_loadu_ps(sp);
+		_mm_storeu_ps(lp, _mm_add_ps(_mm_loadu_ps(lp), _mm_mul_ps(_mm_unpacklo_ps(s, s), amp)));
+		_mm_storeu_ps(lp + 4, _mm_add_ps(_mm_loadu_ps(lp + 4), _mm_mul_ps(_mm_unpackhi_ps(s, s), amp)));
+		sp += 4;
+		lp += 8;
+	}
+#endif
+	while (count--)
+	{
+		sample_t s = *sp++;
+		lp[0] += s * left;
+		lp[1] += s * right;
+		lp += 2;
+	}
+}
+
+/* Adds count samples to one channel of an interleaved stereo buffer. */
+static void mix_single(const sample_t *sp, float *lp, final_volume_t amp, int count)
+{
+#ifdef TIMIDITY_SSE2
+	// The other channel gets -0 added, which leaves every value unchanged.
+	// The last sample is always left to the scalar loop, because lp may
+	// point at the right channel, and the vector code would otherwise
+	// touch the left channel of the sample after it.
+	const __m128 amp4 = _mm_set1_ps(amp);
+	const __m128 nzero = _mm_set1_ps(-0.f);
+
+	for (; count > 4; count -= 4)
+	{
+		__m128 s = _mm_mul_ps(_mm_loadu_ps(sp), amp4);
+		_mm_storeu_ps(lp, _mm_add_ps(_mm_loadu_ps(lp), _mm_unpacklo_ps(s, nzero)));
+		_mm_storeu_ps(lp + 4, _mm_add_ps(_mm_loadu_ps(lp + 4), _mm_unpackhi_ps(s, nzero)));
+		sp += 4;
+		lp += 8;
+	}
+#endif
+	while (count--)
+	{
+		lp[0] += *sp++ * amp;
+		lp += 2;
+	}
+}
+
 static void mix_mystery_signal(SDWORD control_ratio, const sample_t *sp, float *lp, Voice *v, int count)
 {
 	final_volume_t 
 		left = v->left_mix, 
 		right = v->right_mix;
 	int cc;
-	sample_t s;
 
 	if (!(cc = v->control_counter))
 	{
@@ -481,13 +535,9 @@ static void mix_mystery_signal(SDWORD control_ratio, const sample_t *sp, float *
 		if (cc < count)
 		{
 			count -= cc;
-			while (cc--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += right * s;
-				lp += 2;
-			}
+			mix_stereo(sp, lp, left, right, cc);
+			sp += cc;
+			lp += cc * 2;
 			cc = control_ratio;
 			if (update_signal(v))
 				return;	/* Envelope ran out */
@@ -497,13 +547,7 @@ static void mix_mystery_signal(SDWORD control_ratio, const sample_t *sp, float *
 		else
 		{
 			v->control_counter = cc - count;
-			while (count--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += right * s;
-				lp += 2;
-			}
+			mix_stereo(sp, lp, left, right, count);
 			return;
 		}
 	}
@@ -527,11 +571,9 @@ static void mix_single_signal(SDWORD control_ratio, const sample_t *sp, float *l
 		if (cc < count)
 		{
 			count -= cc;
-			while (cc--)
-			{
-				lp[0] += *sp++ * amp;
-				lp += 2;
-			}
+			mix_single(sp, lp, amp, cc);
+			sp += cc;
+			lp += cc * 2;
 			cc = control_ratio;
 			if (update_signal(v))
 				return;	/* Envelope ran out */
@@ -540,11 +582,7 @@ static void mix_single_signal(SDWORD control_ratio, const sample_t *sp, float *l
 		else
 		{
 			v->control_counter = cc - count;
-			while (count--)
-			{
-				lp[0] += *sp++ * amp;
-				lp += 2;
-			}
+			mix_single(sp, lp, amp, count);
 			return;
 		}
 	}
@@ -602,27 +640,7 @@ static void mix_mono_signal(SDWORD control_ratio, const sample_t *sp, float *lp,
 
 static void mix_mystery(SDWORD control_ratio, const sample_t *sp, float *lp, Voice *v, int count)
 {
-	final_volume_t 
-		left = v->left_mix, 
-		right = v->right_mix;
-	sample_t s;
-
-	while (count--)
-	{
-		s = *sp++;
-		lp[0] += s * left;
-		lp[1] += s * right;
-		lp += 2;
-	}
-}
-
-static void mix_single(const sample_t *sp, float *lp, final_volume_t amp, int count)
-{
-	while (count--)
-	{
-		lp[0] += *sp++ * amp;
-		lp += 2;
-	}
+	mix_stereo(sp, lp, v->left_mix, v->right_mix, count);
 }
 
 static void mix_single_left(const sample_t *sp, float *lp, Voice *v, int count)
@@ -726,7 +744,7 @@ static void ramp_out(const sample_t *sp, float *lp, Voice *v, int c)
 
 /**************** interface function ******************/
 
-void mix_voice(Renderer *song, float *buf, Voice *v, int c)
+void mix_voice(Renderer *song, float *buf, sample_t *resample_buffer, Voice *v, int c)
 {
 	int count = c;
 	sample_t *sp;
@@ -738,13 +756,13 @@ void mix_voice(Renderer *song, float *buf, Voice *v, int c)
 	{
 		if (count >= MAX_DIE_TIME)
 			count = MAX_DIE_TIME;
-		sp = resample_voice(song, v, &count);
+		sp = resample_voice(song, resample_buffer, v, &count);
 		ramp_out(sp, buf, v, count);
 		v->status = 0;
 	}
 	else
 	{
-		sp = resample_voice(song, v, &count);
+		sp = resample_voice(song, resample_buffer, v, &count);
 		if (count < 0)
 		{
 			return;
@@ -28,6 +28,10 @@
 #include "timidity.h"
 #include "c_cvars.h"
 
+#ifdef TIMIDITY_SSE2
+#include <emmintrin.h>
+#endif
+
 EXTERN_CVAR(Bool, midi_timiditylike)
 
 namespace Timidity
@@ -41,6 +45,36 @@ namespace Timidity
 #define FINALINTERP if (ofs == le) *dest++ = src[ofs >> FRACTION_BITS];
 /* So it isn't interpolation. At least it's final. */
 
+/* Runs RESAMPLATION count times and returns the new end of dest. The SSE2
+   version does four samples at once and gives the same results. */
+static inline sample_t *resample_run(sample_t *dest, const sample_t *src, int &ofs, int incr, int count)
+{
+#ifdef TIMIDITY_SSE2
+	const __m128i mask = _mm_set1_epi32(FRACTION_MASK);
+	const __m128 scale = _mm_set1_ps(1.f / (1 << FRACTION_BITS));
+
+	for (; count >= 4; count -= 4)
+	{
+		__m128i ofs4 = _mm_setr_epi32(ofs, ofs + incr, ofs + incr * 2, ofs + incr * 3);
+		int o[4];
+
+		_mm_storeu_si128((__m128i *)o, _mm_srai_epi32(ofs4, FRACTION_BITS));
+		__m128 s0 = _mm_setr_ps(src[o[0]], src[o[1]], src[o[2]], src[o[3]]);
+		__m128 s1 = _mm_setr_ps(src[o[0] + 1], src[o[1] + 1], src[o[2] + 1], src[o[3] + 1]);
+		__m128 m = _mm_cvtepi32_ps(_mm_and_si128(ofs4, mask));
+		_mm_storeu_ps(dest, _mm_add_ps(s0, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(s1, s0), m), scale)));
+		dest += 4;
+		ofs += incr * 4;
+	}
+#endif
+	while (count--)
+	{
+		RESAMPLATION;
+		ofs += incr;
+	}
+	return dest;
+}
+
 /*************** resampling with fixed increment *****************/
 
 static sample_t *rs_plain(sample_t *resample_buffer, Voice *v, int *countptr)
@@ -75,11 +109,7 @@ static sample_t *rs_plain(sample_t *resample_buffer, Voice *v, int *countptr)
 		count -= i;
 	}
 
-	while (i--) 
-	{
-		RESAMPLATION;
-		ofs += incr;
-	}
+	dest = resample_run(dest, src, ofs, incr, i);
 
 	if (ofs >= le) 
 	{
@@ -124,11 +154,7 @@ static sample_t *rs_loop(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		dest = resample_run(dest, src, ofs, incr, i);
 	}
 
 	vp->sample_offset=ofs; /* Update offset */
@@ -168,11 +194,7 @@ static sample_t *rs_bidir(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		dest = resample_run(dest, src, ofs, incr, i);
 	}
 
 	/* Then do the bidirectional looping */
@@ -190,11 +212,7 @@ static sample_t *rs_bidir(sample_t *resample_buffer, Voice *vp, int count)
 		{
 			count -= i;
 		}
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		dest = resample_run(dest, src, ofs, incr, i);
 		if (ofs >= le) 
 		{
 			/* fold the overshoot back in */
@@ -363,11 +381,7 @@ static sample_t *rs_vib_loop(sample_t *resample_buffer, float rate, Voice *vp, i
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		dest = resample_run(dest, src, ofs, incr, i);
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -421,11 +435,7 @@ static sample_t *rs_vib_bidir(sample_t *resample_buffer, float rate, Voice *vp,
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		dest = resample_run(dest, src, ofs, incr, i);
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -454,11 +464,7 @@ static sample_t *rs_vib_bidir(sample_t *resample_buffer, float rate, Voice *vp,
 			cc -= i;
 		}
 		count -= i;
-		while (i--) 
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		dest = resample_run(dest, src, ofs, incr, i);
 		if (vibflag) 
 		{
 			cc = vp->vibrato_control_ratio;
@@ -484,7 +490,7 @@ static sample_t *rs_vib_bidir(sample_t *resample_buffer, float rate, Voice *vp,
 	return resample_buffer;
 }
 
-sample_t *resample_voice(Renderer *song, Voice *vp, int *countptr)
+sample_t *resample_voice(Renderer *song, sample_t *resample_buffer, Voice *vp, int *countptr)
 {
 	int ofs;
 	WORD modes;
@@ -525,13 +531,13 @@ sample_t *resample_voice(Renderer *song, Voice *vp, int *countptr)
 		if (vp->status & VOICE_LPE && !(midi_timiditylike && vp->sample->modes & PATCH_T_NO_LOOP))
 		{
 			if (modes & PATCH_BIDIR)
-				return rs_vib_bidir(song->resample_buffer, song->rate, vp, *countptr);
+				return rs_vib_bidir(resample_buffer, song->rate, vp, *countptr);
 			else
-				return rs_vib_loop(song->resample_buffer, song->rate, vp, *countptr);
+				return rs_vib_loop(resample_buffer, song->rate, vp, *countptr);
 		}
 		else
 		{
-			return rs_vib_plain(song->resample_buffer, song->rate, vp, countptr);
+			return rs_vib_plain(resample_buffer, song->rate, vp, countptr);
 		}
 	}
 	else
@@ -539,13 +545,13 @@ sample_t *resample_voice(Renderer *song, Voice *vp, int *countptr)
 		if (vp->status & VOICE_LPE && !(midi_timiditylike && vp->sample->modes & PATCH_T_NO_LOOP))
 		{
 			if (modes & PATCH_BIDIR)
-				return rs_bidir(song->resample_buffer, vp, *countptr);
+				return rs_bidir(resample_buffer, vp, *countptr);
 			else
-				return rs_loop(song->resample_buffer, vp, *countptr);
+				return rs_loop(resample_buffer, vp, *countptr);
 		}
 		else
 		{
-			return rs_plain(song->resample_buffer, vp, countptr);
+			return rs_plain(resample_buffer, vp, countptr);
 		}
 	}
 }
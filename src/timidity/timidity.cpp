@@ -22,6 +22,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
+#include <thread>
 
 #include "timidity.h"
 #include "templates.h"
@@ -31,6 +33,7 @@
 #include "i_system.h"
 #include "files.h"
 #include "w_wad.h"
+#include "workerpool.h"
 
 CVAR(String, midi_config, CONFIG_FILE, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Int, midi_voices, 32, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
@@ -38,6 +41,7 @@ CVAR(Bool, midi_timiditylike, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(String, gus_patchdir, "", CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Bool, midi_dmxgus, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Int, gus_memsize, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+CVAR(Bool, midi_parallelmix, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
 namespace Timidity
 {
@@ -708,10 +712,80 @@ Renderer::Renderer(float sample_rate)
 	voices = clamp<int>(midi_voices, 16, 256);
 	voice = new Voice[voices];
 	drumchannels = DEFAULT_DRUMCHANNELS;
+	mix_job = NULL;
+	// Asking the pool takes its lock, so don't do that from the stream callback.
+	mix_threads = WorkerPool.GetNumThreads();
 }
 
+void Renderer::ComputeOutput(float *buffer, int count)
+{
+	// count is in samples, not bytes.
+	if (count <= 0)
+	{
+		return;
+	}
+	Voice *v = &voice[0];
+
+	memset(buffer, 0, sizeof(float)*count*2);		// An integer 0 is also a float 0.
+	if (ComputeOutputParallel(buffer, count))
+	{
+		return;
+	}
+	if (resample_buffer_size < count)
+	{
+		resample_buffer_size = count;
+		resample_buffer = (sample_t *)M_Realloc(resample_buffer, count * sizeof(float) * 2);
+	}
+	for (int i = 0; i < voices; i++, v++)
+	{
+		if (v->status & VOICE_RUNNING)
+		{
+			mix_voice(this, buffer, resample_buffer, v, count);
+		}
+	}
+}
+
+/* Everything the stream callback shares with the worker threads when the
+   voices are mixed in parallel. Every group of voices is mixed into a
+   buffer of its own, so the only data that is written by more than one
+   thread are the atomic counters. */
+struct MixJob
+{
+	FWorkerGroup Helpers;
+	std::atomic<unsigned> Claim;	// number of groups << 16 | next unclaimed group
+	std::atomic<int> Finished;
+	std::atomic<int> Queued;		// helpers that have not started yet
+	int Count;
+	int GroupStart[MAX_MIX_GROUPS + 1];
+	TArray<Voice *> Voices;
+	float *Output[MAX_MIX_GROUPS];
+	sample_t *Resample[MAX_MIX_GROUPS];
+	int BufferSize[MAX_MIX_GROUPS];
+
+	MixJob() : Claim(0), Finished(0), Queued(0)
+	{
+		memset(Output, 0, sizeof(Output));
+		memset(Resample, 0, sizeof(Resample));
+		memset(BufferSize, 0, sizeof(BufferSize));
+	}
+	~MixJob()
+	{
+		Helpers.Wait();
+		for (int i = 0; i < MAX_MIX_GROUPS; ++i)
+		{
+			M_Free(Output[i]);
+			M_Free(Resample[i]);
+		}
+	}
+};
+
 Renderer::~Renderer()
 {
+	// This waits for the helpers, which may still be looking at the voices.
+	if (mix_job != NULL)
+	{
+		delete mix_job;
+	}
 	if (resample_buffer != NULL)
 	{
 		M_Free(resample_buffer);
@@ -722,28 +796,128 @@ Renderer::~Renderer()
 	}
 }
 
-void Renderer::ComputeOutput(float *buffer, int count)
+/* Claims and mixes groups until there are none left. This runs on the
+   stream callback's thread and on the helpers. A helper that only starts
+   after the batch it was queued for is over takes part in the current
+   one, if any: the claim word changes atomically from one batch to the
+   next, and a group is only claimed after the batch has been set up. */
+static void mix_groups(Renderer *song, MixJob *job)
 {
-	// count is in samples, not bytes.
-	if (count <= 0)
+	for (;;)
 	{
-		return;
+		unsigned claim = job->Claim.load();
+		if ((claim & 0xFFFF) >= (claim >> 16))
+		{
+			return;
+		}
+		if (!job->Claim.compare_exchange_weak(claim, claim + 1))
+		{
+			continue;
+		}
+		int group = claim & 0xFFFF;
+		float *out = job->Output[group];
+
+		memset(out, 0, sizeof(float) * job->Count * 2);
+		for (int i = job->GroupStart[group]; i < job->GroupStart[group + 1]; ++i)
+		{
+			mix_voice(song, out, job->Resample[group], job->Voices[i], job->Count);
+		}
+		job->Finished++;
 	}
-	Voice *v = &voice[0];
+}
 
-	memset(buffer, 0, sizeof(float)*count*2);		// An integer 0 is also a float 0.
-	if (resample_buffer_size < count)
+/* Mixes the running voices in groups on the worker threads. Returns false
+   if it's not worth it, in which case the caller mixes them by itself.
+   The groups are added to the output in order, so the result does not
+   depend on which thread got to mix which group. */
+bool Renderer::ComputeOutputParallel(float *buffer, int count)
+{
+	if (!midi_parallelmix || count < MIN_SAMPLES_PER_GROUP)
 	{
-		resample_buffer_size = count;
-		resample_buffer = (sample_t *)M_Realloc(resample_buffer, count * sizeof(float) * 2);
+		return false;
 	}
-	for (int i = 0; i < voices; i++, v++)
+
+	int running = 0;
+	for (int i = 0; i < voices; ++i)
 	{
-		if (v->status & VOICE_RUNNING)
+		if (voice[i].status & VOICE_RUNNING)
+		{
+			running++;
+		}
+	}
+	int groups = MIN<int>(running / MIN_VOICES_PER_GROUP, MAX_MIX_GROUPS);
+	if (groups < 2)
+	{
+		return false;
+	}
+	groups = MIN<int>(groups, mix_threads);
+	if (groups < 2)
+	{
+		return false;
+	}
+
+	if (mix_job == NULL)
+	{
+		mix_job = new MixJob;
+	}
+	MixJob *job = mix_job;
+
+	job->Voices.Clear();
+	for (int i = 0; i < voices; ++i)
+	{
+		if (voice[i].status & VOICE_RUNNING)
+		{
+			job->Voices.Push(&voice[i]);
+		}
+	}
+	for (int i = 0; i <= groups; ++i)
+	{
+		job->GroupStart[i] = running * i / groups;
+	}
+	for (int i = 0; i < groups; ++i)
+	{
+		if (job->BufferSize[i] < count)
+		{
+			job->BufferSize[i] = count;
+			job->Output[i] = (float *)M_Realloc(job->Output[i], count * sizeof(float) * 2);
+			job->Resample[i] = (sample_t *)M_Realloc(job->Resample[i], count * sizeof(float) * 2);
+		}
+	}
+	job->Count = count;
+	job->Finished = 0;
+	job->Claim = unsigned(groups) << 16;
+
+	// Helpers from earlier batches that haven't run yet will join this one,
+	// so only top them up instead of queueing new ones every time.
+	// If the pool is busy, the remaining groups are simply mixed here.
+	for (int i = groups - 1 - job->Queued; i > 0; --i)
+	{
+		job->Queued++;
+		if (!job->Helpers.TryRun([this, job]() { job->Queued--; mix_groups(this, job); }))
+		{
+			job->Queued--;
+			break;
+		}
+	}
+
+	mix_groups(this, job);
+
+	// All groups are claimed, so this only waits for helpers that are
+	// still busy with theirs.
+	while (job->Finished < groups)
+	{
+		std::this_thread::yield();
+	}
+
+	for (int i = 0; i < groups; ++i)
+	{
+		const float *out = job->Output[i];
+		for (int j = 0; j < count * 2; ++j)
 		{
-			mix_voice(this, buffer, v, count);
+			buffer[j] += out[j];
 		}
 	}
+	return true;
 }
 
 void Renderer::MarkInstrument(int banknum, int percussion, int instr)
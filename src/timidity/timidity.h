@@ -75,6 +75,14 @@ config.h
    click removal. */
 #define MAX_DIE_TIME				20
 
+/* When midi_parallelmix is on, the running voices are split into groups
+   that are mixed on the worker threads. A group should have at least
+   this many voices, and a buffer at least this many samples, or the
+   handoff costs more than it saves. */
+#define MIN_VOICES_PER_GROUP		8
+#define MIN_SAMPLES_PER_GROUP		64
+#define MAX_MIX_GROUPS				16
+
 /**************************************************************************/
 /* Anything below this shouldn't need to be changed unless you're porting
    to a new machine with other than 32-bit, big-endian words. */
@@ -91,6 +99,12 @@ config.h
 
 #define MAX_AMPLIFICATION			800
 
+/* Resampling and mixing process four samples at a time with SSE2
+   whenever the compiler targets it. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TIMIDITY_SSE2
+#endif
+
 /* The TiMiditiy configuration file */
 #define CONFIG_FILE	"timidity.cfg"
 
@@ -385,7 +399,7 @@ FontFile *ReadDLS(const char *filename, FileReader *f);
 mix.h
 */
 
-extern void mix_voice(struct Renderer *song, float *buf, struct Voice *v, int c);
+extern void mix_voice(struct Renderer *song, float *buf, sample_t *resample_buffer, struct Voice *v, int c);
 extern int recompute_envelope(struct Voice *v);
 extern void apply_envelope_to_amp(struct Voice *v);
 
@@ -600,7 +614,7 @@ enum
 resample.h
 */
 
-extern sample_t *resample_voice(struct Renderer *song, Voice *v, int *countptr);
+extern sample_t *resample_voice(struct Renderer *song, sample_t *resample_buffer, Voice *v, int *countptr);
 extern void pre_resample(struct Renderer *song, Sample *sp);
 
 /* 
@@ -646,6 +660,8 @@ struct Renderer
 	int adjust_panning_immediately;
 	int voices;
 	int lost_notes, cut_notes;
+	struct MixJob *mix_job;
+	int mix_threads;		// threads in the worker pool when the renderer was made
 
 	Renderer(float sample_rate);
 	~Renderer();
@@ -654,6 +670,7 @@ struct Renderer
 	void HandleLongMessage(const BYTE *data, int len);
 	void HandleController(int chan, int ctrl, int val);
 	void ComputeOutput(float *buffer, int num_samples);
+	bool ComputeOutputParallel(float *buffer, int num_samples);
 	void MarkInstrument(int bank, int percussion, int instr);
 	void Reset();
 
@@ -56,6 +56,9 @@
 #include "doomerrors.h"
 #include "resourcefiles/resourcefile.h"
 #include "md5.h"
+#include "c_console.h"
+#include "workerpool.h"
+#include "stats.h"
 // [TP]
 #include "c_cvars.h"
 
@@ -121,6 +124,7 @@ void uppercopy (char *to, const char *from)
 FWadCollection::FWadCollection ()
 : FirstLumpIndex(NULL), NextLumpIndex(NULL),
   FirstLumpIndex_FullName(NULL), NextLumpIndex_FullName(NULL), 
+  LumpNames(NULL), LumpNamespaces(NULL),
   NumLumps(0)
 {
 }
@@ -152,6 +156,16 @@ void FWadCollection::DeleteAll ()
 		delete[] NextLumpIndex_FullName;
 		NextLumpIndex_FullName = NULL;
 	}
+	if (LumpNames != NULL)
+	{
+		delete[] LumpNames;
+		LumpNames = NULL;
+	}
+	if (LumpNamespaces != NULL)
+	{
+		delete[] LumpNamespaces;
+		LumpNamespaces = NULL;
+	}
 
 	LumpInfo.Clear();
 	NumLumps = 0;
@@ -165,6 +179,92 @@ void FWadCollection::DeleteAll ()
 	Files.Clear();
 }
 
+//==========================================================================
+//
+// OpenMappedFile
+//
+// Returns NULL if the file cannot be mapped or mapping is disabled.
+//
+//==========================================================================
+
+static FileReader *OpenMappedFile (const char *filename)
+{
+	if (Args->CheckParm ("-nommap"))
+	{
+		return NULL;
+	}
+	MappedFileReader *mapped = new MappedFileReader;
+	if (!mapped->Open (filename))
+	{
+		delete mapped;
+		return NULL;
+	}
+	return mapped;
+}
+
+//==========================================================================
+//
+// PrepareFiles
+//
+// Opens all files in allwads on the worker threads and reads the
+// directories of those that are archives. Other formats have to be opened
+// in order, because WADs with skins get numbered namespaces, so they only
+// get their reader opened here. Messages are kept until the file is added.
+//
+//==========================================================================
+
+struct FPreparedFile
+{
+	FileReader *Reader;
+	FResourceFile *Resfile;
+	FString Messages;
+};
+
+static void PrepareFiles (TArray<FPreparedFile> &prepared)
+{
+	prepared.Resize (allwads.Size());
+	WorkerPool.ParallelFor (allwads.Size(), [&](unsigned i)
+	{
+		FPreparedFile &file = prepared[i];
+		const char *filename = allwads[i];
+		struct stat info;
+
+		file.Reader = NULL;
+		file.Resfile = NULL;
+
+		// Anything that needs an error message is left to AddFile.
+		if (stat (filename, &info) != 0 || (info.st_mode & S_IFDIR))
+		{
+			return;
+		}
+		file.Reader = OpenMappedFile (filename);
+		if (file.Reader == NULL)
+		{
+			FileReader *reader = new FileReader;
+			if (!reader->Open (filename))
+			{
+				delete reader;
+				return;
+			}
+			file.Reader = reader;
+		}
+
+		C_StartThreadCapture (&file.Messages);
+		file.Resfile = FResourceFile::OpenArchive (filename, file.Reader);
+		C_EndThreadCapture ();
+
+		if (file.Resfile != NULL)
+		{
+			file.Reader = NULL;
+		}
+		else
+		{
+			// AddFile will try again and print whatever went wrong.
+			file.Messages = "";
+		}
+	});
+}
+
 //==========================================================================
 //
 // W_InitMultipleFiles
@@ -184,6 +284,11 @@ void FWadCollection::InitMultipleFiles (/*TArray<FString> &filenames*/) // [BB]
 	DeleteAll();
 	numfiles = 0;
 
+	// Reading the directory of a big archive takes a while, so do that
+	// for all of them at once before adding them in order.
+	TArray<FPreparedFile> prepared;
+	PrepareFiles(prepared);
+
 	for(unsigned i=0;i<allwads.Size(); i++) // [BB] Changed to allwads.
 	{
 		int baselump = NumLumps;
@@ -219,7 +324,17 @@ void FWadCollection::InitMultipleFiles (/*TArray<FString> &filenames*/) // [BB]
 			}
 		}
 
-		AddFile (allwads[i], NULL, bLoadedAutomatically, isOptional);
+		if (prepared[i].Resfile != NULL)
+		{
+			prepared[i].Resfile->Reader->bLoadedAutomatically = bLoadedAutomatically;
+			Printf (" adding %s", allwads[i].GetChars());
+			Printf ("%s", prepared[i].Messages.GetChars());
+			AddResourceFile (allwads[i], prepared[i].Resfile, isOptional);
+		}
+		else
+		{
+			AddFile (allwads[i], prepared[i].Reader, bLoadedAutomatically, isOptional);
+		}
 	}
 
 	NumLumps = LumpInfo.Size();
@@ -235,6 +350,8 @@ void FWadCollection::InitMultipleFiles (/*TArray<FString> &filenames*/) // [BB]
 	NextLumpIndex = new DWORD[NumLumps];
 	FirstLumpIndex_FullName = new DWORD[NumLumps];
 	NextLumpIndex_FullName = new DWORD[NumLumps];
+	LumpNames = new QWORD[NumLumps];
+	LumpNamespaces = new int[NumLumps];
 	InitHashChains ();
 	LumpInfo.ShrinkToFit();
 	Files.ShrinkToFit();
@@ -289,15 +406,21 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadinfo, bool bL
 
 		if (!isdir)
 		{
-			try
+			// Map the file if possible, so that uncompressed lumps
+			// don't need to be read into memory at all.
+			wadinfo = OpenMappedFile(filename);
+			if (wadinfo == NULL)
 			{
-				wadinfo = new FileReader(filename);
-			}
-			catch (CRecoverableError &err)
-			{ // Didn't find file
-				Printf (TEXTCOLOR_RED "%s\n", err.GetMessage());
-				PrintLastError ();
-				return;
+				try
+				{
+					wadinfo = new FileReader(filename);
+				}
+				catch (CRecoverableError &err)
+				{ // Didn't find file
+					Printf (TEXTCOLOR_RED "%s\n", err.GetMessage());
+					PrintLastError ();
+					return;
+				}
 			}
 		}
 	}
@@ -318,45 +441,91 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadinfo, bool bL
 
 	if (resfile != NULL)
 	{
-		DWORD lumpstart = LumpInfo.Size();
+		AddResourceFile(filename, resfile, isOptional);
+	}
+}
 
-		resfile->SetFirstLump(lumpstart);
-		for (DWORD i=0; i < resfile->LumpCount(); i++)
-		{
-			FResourceLump *lump = resfile->GetLump(i);
-			FWadCollection::LumpRecord *lump_p = &LumpInfo[LumpInfo.Reserve(1)];
+//==========================================================================
+//
+// AddDuplicateLump
+//
+// [AK] Puts a lump that the archive flagged as a duplicate on the list.
+//
+//==========================================================================
+
+static void AddDuplicateLump (const char *filename, const char *lumpname)
+{
+	const char *shortenedFilename = strrchr(filename, '/');
+	if (shortenedFilename != NULL) shortenedFilename++;
 
-			lump_p->lump = lump;
-			lump_p->wadnum = Files.Size();
+	const char *actualFilename = shortenedFilename != NULL ? shortenedFilename : filename;
+
+	// [AK] To keep the list of duplicate lumps as small as possible, first check if this
+	// particular lump isn't already on the list. If not, add it to the list then.
+	for (unsigned int j = 0; j < DuplicateLumps.Size(); j++)
+	{
+		if ((DuplicateLumps[j].CompareNoCase(lumpname) == 0) && (DuplicateLumpFilenames[j].CompareNoCase(actualFilename) == 0 ))
+		{
+			return;
 		}
+	}
+
+	DuplicateLumps.Push(lumpname);
+	DuplicateLumpFilenames.Push(actualFilename);
+}
+
+//==========================================================================
+//
+// AddResourceFile
+//
+// Adds the lumps of an opened resource file and any WADs embedded in it.
+//
+//==========================================================================
 
-		// [TP] Handle isOptional
-		resfile->IsOptional = isOptional;
+void FWadCollection::AddResourceFile (const char *filename, FResourceFile *resfile, bool isOptional)
+{
+	DWORD lumpstart = LumpInfo.Size();
 
-		if (Files.Size() == IWAD_FILENUM && gameinfo.gametype == GAME_Strife && gameinfo.flags & GI_SHAREWARE)
+	resfile->SetFirstLump(lumpstart);
+	for (DWORD i=0; i < resfile->LumpCount(); i++)
+	{
+		FResourceLump *lump = resfile->GetLump(i);
+		FWadCollection::LumpRecord *lump_p = &LumpInfo[LumpInfo.Reserve(1)];
+
+		lump_p->lump = lump;
+		lump_p->wadnum = Files.Size();
+
+		if (lump->Flags & LUMPF_DUPLICATE)
 		{
-			resfile->FindStrifeTeaserVoices();
+			AddDuplicateLump(resfile->Filename, lump->FullName);
 		}
-		Files.Push(resfile);
+	}
 
-		for (DWORD i=0; i < resfile->LumpCount(); i++)
+	// [TP] Handle isOptional
+	resfile->IsOptional = isOptional;
+
+	if (Files.Size() == IWAD_FILENUM && gameinfo.gametype == GAME_Strife && gameinfo.flags & GI_SHAREWARE)
+	{
+		resfile->FindStrifeTeaserVoices();
+	}
+	Files.Push(resfile);
+
+	for (DWORD i=0; i < resfile->LumpCount(); i++)
+	{
+		FResourceLump *lump = resfile->GetLump(i);
+		if (lump->Flags & LUMPF_EMBEDDED)
 		{
-			FResourceLump *lump = resfile->GetLump(i);
-			if (lump->Flags & LUMPF_EMBEDDED)
-			{
-				char path[256];
+			char path[256];
 
-				mysnprintf(path, countof(path), "%s:", filename);
-				char *wadstr = path + strlen(path);
+			mysnprintf(path, countof(path), "%s:", filename);
+			char *wadstr = path + strlen(path);
 
-				FileReader *embedded = lump->NewReader();
-				strcpy(wadstr, lump->FullName);
+			FileReader *embedded = lump->NewReader();
+			strcpy(wadstr, lump->FullName);
 
-				// [BB] We consider all embedded files as being loaded automatically.
-				AddFile(path, embedded, true, isOptional);
-			}
+			// [BB] We consider all embedded files as being loaded automatically.
+			AddFile(path, embedded, true, isOptional);
 		}
-		return;
 	}
 }
 
@@ -457,18 +626,16 @@ int FWadCollection::CheckNumForName (const char *name, int space)
 
 	while (i != NULL_INDEX)
 	{
-		FResourceLump *lump = LumpInfo[i].lump;
-
-		if (lump->qwName == qname)
+		if (LumpNames[i] == qname)
 		{
-			if (lump->Namespace == space) break;
+			if (LumpNamespaces[i] == space) break;
 			// If the lump is from one of the special namespaces exclusive to Zips
 			// the check has to be done differently:
 			// If we find a lump with this name in the global namespace that does not come
 			// from a Zip return that. WADs don't know these namespaces and single lumps must
 			// work as well.
-			if (space > ns_specialzipdirectory && lump->Namespace == ns_global && 
-				!(lump->Flags & LUMPF_ZIPFILE)) break;
+			if (space > ns_specialzipdirectory && LumpNamespaces[i] == ns_global && 
+				!(LumpInfo[i].lump->Flags & LUMPF_ZIPFILE)) break;
 		}
 		i = NextLumpIndex[i];
 	}
@@ -478,7 +645,6 @@ int FWadCollection::CheckNumForName (const char *name, int space)
 
 int FWadCollection::CheckNumForName (const char *name, int space, int wadnum, bool exact)
 {
-	FResourceLump *lump;
 	union
 	{
 		char uname[8];
@@ -498,8 +664,8 @@ int FWadCollection::CheckNumForName (const char *name, int space, int wadnum, bo
 	// also those in earlier WADs.
 
 	while (i != NULL_INDEX &&
-		(lump = LumpInfo[i].lump, lump->qwName != qname ||
-		lump->Namespace != space ||
+		(LumpNames[i] != qname ||
+		LumpNamespaces[i] != space ||
 		 (exact? (LumpInfo[i].wadnum != wadnum) : (LumpInfo[i].wadnum > wadnum)) ))
 	{
 		i = NextLumpIndex[i];
@@ -693,8 +859,7 @@ DWORD FWadCollection::LumpNameHash (const char *s)
 
 void FWadCollection::InitHashChains (void)
 {
-	char name[8];
-	unsigned int i, j;
+	TArray<DWORD> namehash, fullnamehash;
 
 	// Mark all buckets as empty
 	memset (FirstLumpIndex, 255, NumLumps*sizeof(FirstLumpIndex[0]));
@@ -702,18 +867,32 @@ void FWadCollection::InitHashChains (void)
 	memset (FirstLumpIndex_FullName, 255, NumLumps*sizeof(FirstLumpIndex_FullName[0]));
 	memset (NextLumpIndex_FullName, 255, NumLumps*sizeof(NextLumpIndex_FullName[0]));
 
+	// Hashing the names means visiting every lump, so that part is split
+	// among the worker threads. The chains must be linked in lump order.
+	namehash.Resize (NumLumps);
+	fullnamehash.Resize (NumLumps);
+	WorkerPool.ParallelFor (NumLumps, [&](unsigned i)
+	{
+		FResourceLump *lump = LumpInfo[i].lump;
+		char name[8];
+
+		uppercopy (name, lump->Name);
+		namehash[i] = LumpNameHash (name) % NumLumps;
+		fullnamehash[i] = lump->FullName != NULL ? MakeKey(lump->FullName) % NumLumps : NULL_INDEX;
+		LumpNames[i] = lump->qwName;
+		LumpNamespaces[i] = lump->Namespace;
+	});
+
 	// Now set up the chains
-	for (i = 0; i < (unsigned)NumLumps; i++)
+	for (unsigned int i = 0; i < (unsigned)NumLumps; i++)
 	{
-		uppercopy (name, LumpInfo[i].lump->Name);
-		j = LumpNameHash (name) % NumLumps;
+		DWORD j = namehash[i];
 		NextLumpIndex[i] = FirstLumpIndex[j];
 		FirstLumpIndex[j] = i;
 
 		// Do the same for the full paths
-		if (LumpInfo[i].lump->FullName!=NULL)
+		if ((j = fullnamehash[i]) != NULL_INDEX)
 		{
-			j = MakeKey(LumpInfo[i].lump->FullName) % NumLumps;
 			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
 			FirstLumpIndex_FullName[j] = i;
 		}
@@ -1680,3 +1859,76 @@ static void PrintLastError ()
 	Printf (TEXTCOLOR_RED "  %s\n", strerror(errno));
 }
 #endif
+
+//==========================================================================
+//
+// PrintResidentMemory
+//
+// Where the system tells, prints how much of the process is resident,
+// and how much of that is private memory and how much mapped files.
+//
+//==========================================================================
+
+static void PrintResidentMemory ()
+{
+#ifdef __linux__
+	FILE *f = fopen ("/proc/self/status", "r");
+	char line[256];
+
+	if (f == NULL)
+	{
+		return;
+	}
+	while (fgets (line, sizeof(line), f) != NULL)
+	{
+		if (!strncmp (line, "VmRSS:", 6) || !strncmp (line, "RssAnon:", 8) || !strncmp (line, "RssFile:", 8))
+		{
+			Printf ("%s", line);
+		}
+	}
+	fclose (f);
+#endif
+}
+
+//==========================================================================
+//
+// CCMD benchlumps
+//
+// Reads every lump once and times it. Together with the resident memory
+// afterwards, this compares mapped resource files against -nommap.
+//
+//==========================================================================
+
+CCMD (benchlumps)
+{
+	TArray<BYTE> buffer;
+	cycle_t time;
+	double bytes = 0;
+	int lumps = Wads.GetNumLumps();
+
+	time.Reset();
+	for (int i = 0; i < lumps; ++i)
+	{
+		long size = Wads.LumpLength (i);
+
+		if (size <= 0)
+		{
+			continue;
+		}
+		if (buffer.Size() < (unsigned)size)
+		{
+			buffer.Resize (size);
+		}
+		// Opening is timed too, because that is where mapped lumps are cached.
+		time.Clock();
+		FWadLump reader = Wads.OpenLumpNum (i);
+		reader.Read (&buffer[0], size);
+		time.Unclock();
+		bytes += size;
+	}
+
+	double ms = time.TimeMS();
+	Printf ("%d lumps, %.1f MB in %.2f ms (%.1f MB/s)%s\n", lumps, bytes / 1048576, ms,
+		ms > 0 ? bytes / 1048576 / (ms / 1000) : 0., Args->CheckParm ("-nommap") ? ", not mapped" : "");
+	PrintResidentMemory ();
+}
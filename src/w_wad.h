@@ -83,6 +83,7 @@ enum ELumpFlags
 	LUMPF_ZIPFILE=2,
 	LUMPF_EMBEDDED=4,
 	LUMPF_BLOODCRYPT = 8,
+	LUMPF_DUPLICATE = 16,	// Another lump in the same Zip directory has this name.
 };
 
 
@@ -235,6 +236,9 @@ protected:
 	DWORD *FirstLumpIndex_FullName;	// The same information for fully qualified paths from .zips
 	DWORD *NextLumpIndex_FullName;
 
+	QWORD *LumpNames;				// Copies of the hashed lumps' names and namespaces, so that
+	int *LumpNamespaces;			// walking a hash chain doesn't touch every lump on the way
+
 	DWORD NumLumps;					// Not necessarily the same as LumpInfo.Size()
 	DWORD NumWads;
 
@@ -242,6 +246,7 @@ protected:
 	void InitHashChains ();								// [RH] Set up the lumpinfo hashing
 
 private:
+	void AddResourceFile (const char *filename, FResourceFile *resfile, bool isOptional);
 	void RenameSprites();
 	void RenameNerve();
 	void DeleteAll();
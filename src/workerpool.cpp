@@ -0,0 +1,316 @@
+//-----------------------------------------------------------------------------
+//
+// Zandronum Source
+// Copyright (C) 2026 Zandronum Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Filename: workerpool.cpp
+//
+// Description: A small pool of worker threads for work that can be split into
+// independent pieces, like hashing files or decoding textures.
+//
+//-----------------------------------------------------------------------------
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+#include "workerpool.h"
+#include "c_cvars.h"
+#include "templates.h"
+
+//*****************************************************************************
+//	DEFINES
+
+// Upper limit for sys_workerthreads, mostly to catch typos.
+#define	MAX_WORKER_THREADS		64
+
+struct WorkItem
+{
+	std::function<void( )>	Task;
+	FWorkerGroup			*Group;
+};
+
+//*****************************************************************************
+//	VARIABLES
+
+static	std::mutex					g_Mutex;
+static	std::condition_variable		g_WorkAvailable;
+static	std::condition_variable		g_WorkDone;
+static	std::deque<WorkItem>		g_Queue;
+static	std::vector<std::thread>	g_Threads;
+static	bool						g_bStarted = false;
+static	bool						g_bStopping = false;
+static	thread_local bool			g_bIsWorkerThread = false;
+
+FWorkerPool WorkerPool;
+
+//*****************************************************************************
+//	CONSOLE VARIABLES
+
+// Number of background worker threads. 0 uses one thread per CPU core besides
+// the main thread, a negative value disables the workers entirely.
+CUSTOM_CVAR( Int, sys_workerthreads, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG|CVAR_NOINITCALL )
+{
+	if ( self > MAX_WORKER_THREADS )
+	{
+		self = MAX_WORKER_THREADS;
+		return;
+	}
+
+	// The workers are started again with the new count on the next use.
+	WorkerPool.Shutdown( );
+}
+
+//*****************************************************************************
+//	FUNCTIONS
+
+void workerpool_Execute( WorkItem &Item )
+{
+	Item.Task( );
+
+	if ( --Item.Group->_pending == 0 )
+	{
+		// Taking the lock makes sure that a waiting thread is either still
+		// checking the counter or already waiting for the notification.
+		std::lock_guard<std::mutex> lock( g_Mutex );
+		g_WorkDone.notify_all( );
+	}
+}
+
+//*****************************************************************************
+//
+static void workerpool_ThreadProc( void )
+{
+	g_bIsWorkerThread = true;
+
+	std::unique_lock<std::mutex> lock( g_Mutex );
+	for ( ;; )
+	{
+		g_WorkAvailable.wait( lock, [] { return g_bStopping || ( g_Queue.empty( ) == false ); } );
+
+		// When stopping, the queue is drained first so no group waits forever.
+		if ( g_Queue.empty( ))
+			return;
+
+		WorkItem item = std::move( g_Queue.front( ));
+		g_Queue.pop_front( );
+
+		lock.unlock( );
+		workerpool_Execute( item );
+		lock.lock( );
+	}
+}
+
+//*****************************************************************************
+// Must be called with g_Mutex held.
+static void workerpool_StartLocked( void )
+{
+	if ( g_bStarted )
+		return;
+
+	g_bStarted = true;
+
+	int numThreads = sys_workerthreads;
+	if ( numThreads == 0 )
+		numThreads = static_cast<int>( std::thread::hardware_concurrency( )) - 1;
+
+	numThreads = clamp<int>( numThreads, 0, MAX_WORKER_THREADS );
+	for ( int i = 0; i < numThreads; i++ )
+		g_Threads.push_back( std::thread( workerpool_ThreadProc ));
+}
+
+//*****************************************************************************
+//
+FWorkerGroup::FWorkerGroup( )
+	: _pending( 0 )
+{
+}
+
+//*****************************************************************************
+//
+FWorkerGroup::~FWorkerGroup( )
+{
+	Wait( );
+}
+
+//*****************************************************************************
+//
+void FWorkerGroup::Run( std::function<void( )> Task )
+{
+	WorkItem item;
+	item.Task = std::move( Task );
+	item.Group = this;
+	_pending++;
+
+	{
+		std::lock_guard<std::mutex> lock( g_Mutex );
+		workerpool_StartLocked( );
+
+		if ( g_Threads.empty( ) == false )
+		{
+			g_Queue.push_back( std::move( item ));
+			g_WorkAvailable.notify_one( );
+			return;
+		}
+	}
+
+	workerpool_Execute( item );
+}
+
+//*****************************************************************************
+//
+bool FWorkerGroup::TryRun( std::function<void( )> Task )
+{
+	std::unique_lock<std::mutex> lock( g_Mutex, std::try_to_lock );
+
+	if (( lock.owns_lock( ) == false ) || g_Threads.empty( ))
+		return false;
+
+	WorkItem item;
+	item.Task = std::move( Task );
+	item.Group = this;
+	_pending++;
+
+	g_Queue.push_back( std::move( item ));
+	g_WorkAvailable.notify_one( );
+	return true;
+}
+
+//*****************************************************************************
+//
+void FWorkerGroup::Wait( )
+{
+	std::unique_lock<std::mutex> lock( g_Mutex );
+	while ( _pending.load( ) > 0 )
+	{
+		// Help out instead of idling. This also keeps nested groups from
+		// deadlocking when all workers are waiting themselves.
+		if ( g_Queue.empty( ) == false )
+		{
+			WorkItem item = std::move( g_Queue.front( ));
+			g_Queue.pop_front( );
+
+			lock.unlock( );
+			workerpool_Execute( item );
+			lock.lock( );
+		}
+		else
+		{
+			g_WorkDone.wait( lock );
+		}
+	}
+}
+
+//*****************************************************************************
+//
+FWorkerPool::~FWorkerPool( )
+{
+	Shutdown( );
+}
+
+//*****************************************************************************
+//
+unsigned int FWorkerPool::GetNumThreads( )
+{
+	std::lock_guard<std::mutex> lock( g_Mutex );
+	workerpool_StartLocked( );
+	return static_cast<unsigned int>( g_Threads.size( )) + 1;
+}
+
+//*****************************************************************************
+//
+void FWorkerPool::ParallelFor( unsigned int Count, const std::function<void( unsigned int )> &Body )
+{
+	const unsigned int numThreads = MIN( GetNumThreads( ), Count );
+
+	if ( numThreads <= 1 )
+	{
+		for ( unsigned int i = 0; i < Count; i++ )
+			Body( i );
+		return;
+	}
+
+	// Every thread keeps grabbing the next index, so uneven work evens out.
+	std::atomic<unsigned int> next( 0 );
+	auto worker = [&]( )
+	{
+		unsigned int i;
+		while (( i = next++ ) < Count )
+			Body( i );
+	};
+
+	FWorkerGroup group;
+	for ( unsigned int i = 1; i < numThreads; i++ )
+		group.Run( worker );
+
+	worker( );
+	group.Wait( );
+}
+
+//*****************************************************************************
+//
+void FWorkerPool::Shutdown( )
+{
+	std::vector<std::thread> threads;
+
+	{
+		std::lock_guard<std::mutex> lock( g_Mutex );
+		if ( g_bStarted == false )
+			return;
+
+		g_bStopping = true;
+		threads.swap( g_Threads );
+		g_WorkAvailable.notify_all( );
+	}
+
+	for ( unsigned int i = 0; i < threads.size( ); i++ )
+		threads[i].join( );
+
+	std::lock_guard<std::mutex> lock( g_Mutex );
+	g_bStopping = false;
+	g_bStarted = false;
+}
+
+//*****************************************************************************
+//
+bool FWorkerPool::IsWorkerThread( )
+{
+	return g_bIsWorkerThread;
+}
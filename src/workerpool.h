@@ -0,0 +1,112 @@
+//-----------------------------------------------------------------------------
+//
+// Zandronum Source
+// Copyright (C) 2026 Zandronum Development Team
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+// 3. Neither the name of the Skulltag Development Team nor the names of its
+//    contributors may be used to endorse or promote products derived from this
+//    software without specific prior written permission.
+// 4. Redistributions in any form must be accompanied by information on how to
+//    obtain complete source code for the software and any accompanying
+//    software that uses the software. The source code must either be included
+//    in the distribution or be available for no more than the cost of
+//    distribution plus a nominal fee, and must be freely redistributable
+//    under reasonable conditions. For an executable file, complete source
+//    code means the source code for all modules it contains. It does not
+//    include source code for modules or files that typically accompany the
+//    major components of the operating system on which the executable file
+//    runs.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Filename: workerpool.h
+//
+// Description: A small pool of worker threads for work that can be split into
+// independent pieces, like hashing files or decoding textures.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __WORKERPOOL_H__
+#define __WORKERPOOL_H__
+
+#include <functional>
+#include <atomic>
+
+class FWorkerPool;
+
+//*****************************************************************************
+// A set of tasks that can be waited on together. The group must outlive all
+// tasks that were started through it.
+class FWorkerGroup
+{
+public:
+	FWorkerGroup( );
+	~FWorkerGroup( );
+
+	// Queues a task to be run by one of the worker threads. If there are no
+	// workers, the task is run right away on the calling thread. Tasks must
+	// not throw and must not call Printf or any other non thread-safe code.
+	void	Run( std::function<void( )> Task );
+
+	// Like Run, but never waits for the pool's lock and never starts the
+	// workers. Returns false without doing anything if the lock is taken or
+	// there are no running workers. Meant for threads that must not block,
+	// like the audio callback.
+	bool	TryRun( std::function<void( )> Task );
+
+	// Blocks until all tasks of this group are done. The calling thread helps
+	// with queued work while waiting, so nesting groups can't deadlock.
+	void	Wait( );
+
+	// Returns true if all tasks of this group are done.
+	bool	IsDone( ) const { return _pending.load( ) == 0; }
+
+private:
+	friend void workerpool_Execute( struct WorkItem &Item );
+
+	std::atomic<int>	_pending;
+};
+
+//*****************************************************************************
+class FWorkerPool
+{
+public:
+	~FWorkerPool( );
+
+	// Number of threads that work on a ParallelFor, including the caller.
+	unsigned int	GetNumThreads( );
+
+	// Calls Body( i ) for every i in [0, Count) and returns when all calls are
+	// done. The order of the calls is unspecified, so Body must only write to
+	// data that belongs to index i.
+	void			ParallelFor( unsigned int Count, const std::function<void( unsigned int )> &Body );
+
+	// Stops all worker threads. They are started again on the next use.
+	void			Shutdown( );
+
+	// Returns true when called from one of the worker threads.
+	static bool		IsWorkerThread( );
+};
+
+extern FWorkerPool WorkerPool;
+
+#endif	// __WORKERPOOL_H__
@@ -35,15 +35,37 @@ void DumpCPUInfo(const CPUInfo *cpu)
 						 "xchgl\t%%ebx, %1\n\t" \
 		: "=a" ((output)[0]), "=r" ((output)[1]), "=c" ((output)[2]), "=d" ((output)[3]) \
 		: "a" (func));
+#define __cpuidex(output, func, subfunc) \
+	__asm__ __volatile__("xchgl\t%%ebx, %1\n\t" \
+						 "cpuid\n\t" \
+						 "xchgl\t%%ebx, %1\n\t" \
+		: "=a" ((output)[0]), "=r" ((output)[1]), "=c" ((output)[2]), "=d" ((output)[3]) \
+		: "a" (func), "c" (subfunc));
 #else
 #define __cpuid(output, func) __asm__ __volatile__("cpuid" : "=a" ((output)[0]),\
 	"=b" ((output)[1]), "=c" ((output)[2]), "=d" ((output)[3]) : "a" (func));
+#define __cpuidex(output, func, subfunc) __asm__ __volatile__("cpuid" : "=a" ((output)[0]),\
+	"=b" ((output)[1]), "=c" ((output)[2]), "=d" ((output)[3]) : "a" (func), "c" (subfunc));
 #endif
+
+// Written as bytes, since older assemblers do not know xgetbv.
+static inline unsigned int GetXCR0()
+{
+	unsigned int eax, edx;
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0));
+	return eax;
+}
+#else
+static inline unsigned int GetXCR0()
+{
+	return (unsigned int)_xgetbv(0);
+}
 #endif
 
 void CheckCPUID(CPUInfo *cpu)
 {
 	int foo[4];
+	unsigned int maxstd;
 	unsigned int maxext;
 
 	memset(cpu, 0, sizeof(*cpu));
@@ -96,6 +118,7 @@ haveid:
 
 	// Get vendor ID
 	__cpuid(foo, 0);
+	maxstd = (unsigned int)foo[0];
 	cpu->dwVendorID[0] = foo[1];
 	cpu->dwVendorID[1] = foo[3];
 	cpu->dwVendorID[2] = foo[2];
@@ -118,6 +141,18 @@ haveid:
 		cpu->DataL1LineSize = (foo[1] & 0xFF00) >> (8 - 3);
 	}
 
+	// AVX can only be used if the OS saves the YMM registers on context switches.
+	if ((foo[2] & (1 << 27)) && (foo[2] & (1 << 28)) && (GetXCR0() & 6) == 6)
+	{
+		cpu->bAVX = true;
+		if (maxstd >= 7)
+		{
+			int ext[4];
+			__cpuidex(ext, 7, 0);
+			cpu->bAVX2 = (ext[1] & (1 << 5)) != 0;
+		}
+	}
+
 	cpu->Stepping = foo[0] & 0x0F;
 	cpu->Type = (foo[0] & 0x3000) >> 12;	// valid on Intel only
 	cpu->Model = (foo[0] & 0xF0) >> 4;
@@ -221,6 +256,8 @@ void DumpCPUInfo(const CPUInfo *cpu)
 		if (cpu->bSSSE3)		Printf(" SSSE3");
 		if (cpu->bSSE41)		Printf(" SSE4.1");
 		if (cpu->bSSE42)		Printf(" SSE4.2");
+		if (cpu->bAVX)			Printf(" AVX");
+		if (cpu->bAVX2)			Printf(" AVX2");
 		if (cpu->b3DNow)		Printf(" 3DNow!");
 		if (cpu->b3DNowPlus)	Printf(" 3DNow!+");
 		Printf ("\n");
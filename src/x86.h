@@ -3,7 +3,7 @@
 
 #include "basictypes.h"
 
-struct CPUInfo	// 92 bytes
+struct CPUInfo	// 96 bytes
 {
 	union
 	{
@@ -97,6 +97,11 @@ struct CPUInfo	// 92 bytes
 		};
 		uint32 AMD_DataL1Info;
 	};
+
+	// Only set if the OS saves the AVX registers, too.
+	BYTE bAVX;
+	BYTE bAVX2;
+	BYTE Padding[2];
 };
 
 